@@ -31,11 +31,23 @@
 
 #include "globals.h"
 
+/* Allocation counters, for metrics. */
+unsigned long alloc_count;
+unsigned long realloc_count;
+unsigned long free_count;
+
+/* Allocation hook, for profiling. */
+alloc_hook_t *alloc_hook;
+
 void *
 Malloc(size_t len)
 {
     char *r;
 
+    alloc_count++;
+    if (alloc_hook != NULL) {
+	(*alloc_hook)(len);
+    }
     r = malloc(len);
     if (r == NULL) {
 	Error("Out of memory");
@@ -48,6 +60,10 @@ Calloc(size_t nelem, size_t elsize)
 {
     char *r;
 
+    alloc_count++;
+    if (alloc_hook != NULL) {
+	(*alloc_hook)(nelem * elsize);
+    }
     r = malloc(nelem * elsize);
     if (r == NULL) {
 	Error("Out of memory");
@@ -58,6 +74,14 @@ Calloc(size_t nelem, size_t elsize)
 void *
 Realloc(void *p, size_t len)
 {
+    if (p == NULL) {
+	alloc_count++;
+    } else {
+	realloc_count++;
+    }
+    if (alloc_hook != NULL) {
+	(*alloc_hook)(len);
+    }
     p = realloc(p, len);
     if (p == NULL) {
 	Error("Out of memory");
@@ -69,6 +93,7 @@ void
 Free(void *p)
 {
     if (p != NULL) {
+	free_count++;
 	free(p);
     }
 }
@@ -0,0 +1,398 @@
+#!/usr/bin/env python3
+# asyncio Python interface to x3270 emulators
+#
+# Copyright (c) 2026 Paul Mattes.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#     * Redistributions of source code must retain the above copyright
+#       notice, this list of conditions and the following disclaimer.
+#     * Redistributions in binary form must reproduce the above copyright
+#       notice, this list of conditions and the following disclaimer in the
+#       documentation and/or other materials provided with the distribution.
+#     * Neither the names of Paul Mattes nor the names of his contributors
+#       may be used to endorse or promote products derived from this software
+#       without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY PAUL MATTES "AS IS" AND ANY EXPRESS OR IMPLIED
+# WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+# MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+# EVENT SHALL PAUL MATTES BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+# OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+# WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+# OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+# ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+"""asyncio Python interface to x3270 emulators"""
+
+import asyncio
+import os
+import socket
+import sys
+
+from x3270if.common import _action_string
+from x3270if.common import ActionFailException
+from x3270if.common import StartupException
+
+# Prefix for request tags, which lets replies be matched to pipelined
+# requests.
+_tag_prefix = '@'
+
+# First emulator version that tags its replies.
+_tag_min_version = '4.6pre1'
+
+class async_session():
+    """Abstract asyncio x3270if session base class
+
+       Requests are tagged and written without waiting for earlier replies
+       (pipelined). A single reader task parses replies as they arrive and
+       completes the matching futures.
+    """
+    def __init__(self,debug=False):
+        """Initialize an instance
+
+           Args:
+              debug (bool): True to trace debug info to stderr.
+        """
+
+        # Debug flag
+        self._debug_enabled = debug
+
+        # Last prompt
+        self._prompt = ''
+
+        # Streams to/from the emulator
+        self._reader = None
+        self._writer = None
+
+        # Reader task
+        self._reader_task = None
+
+        # Pending requests, indexed by tag. Each entry is a future and the
+        # list of reply lines received so far.
+        self._pending = {}
+        self._next_tag = 0
+
+    @property
+    def prompt(self):
+        """Gets the last emulator prompt
+           str: Last emulator prompt
+
+        """
+        return self._prompt
+
+    def _attach(self,reader,writer):
+        """Attach the streams to the emulator and start the reader
+
+           Args:
+              reader (asyncio.StreamReader): Stream from the emulator
+              writer (asyncio.StreamWriter): Stream to the emulator
+        """
+        self._reader = reader
+        self._writer = writer
+        self._reader_task = asyncio.get_running_loop().create_task(self._read_replies())
+
+    def send_action(self,cmd,*args):
+        """Send an action to the emulator without waiting for the reply
+
+           Args:
+              cmd (str): Action name
+                 Action name. If 'args' is omitted, this is the entire
+                 properly-formatted action name and arguments, and the text
+                 will be passed through unmodified.
+              args (iterable): Arguments
+           Returns:
+              asyncio.Future: Completes with the command output, or raises
+                 ActionFailException or EOFError.
+        """
+        if (self._writer == None or self._reader_task.done()):
+            raise EOFError('Emulator exited')
+        argstr = _action_string(cmd, args)
+        tag = str(self._next_tag)
+        self._next_tag += 1
+        future = asyncio.get_running_loop().create_future()
+        self._pending[tag] = (future, [])
+        self._writer.write((_tag_prefix + tag + ' ' + argstr + '\n').encode('utf-8'))
+        self._debug('Sent ' + _tag_prefix + tag + ' ' + argstr)
+        return future
+
+    async def run_action(self,cmd,*args):
+        """Send an action to the emulator and wait for the reply
+
+           Args:
+              cmd (str): Action name
+                 Action name. If 'args' is omitted, this is the entire
+                 properly-formatted action name and arguments, and the text
+                 will be passed through unmodified.
+              args (iterable): Arguments
+           Returns:
+              str: Command output
+                 Mulitiple lines are separated by newline characters.
+           Raises:
+              ActionFailException: Emulator returned an error.
+              EOFError: Emulator exited unexpectedly.
+        """
+        future = self.send_action(cmd, *args)
+        await self._writer.drain()
+        return await future
+
+    async def _read_replies(self):
+        """Parse replies from the emulator as they arrive"""
+        failure = EOFError('Emulator exited')
+        try:
+            while (True):
+                line = await self._reader.readline()
+                if (line == b''): break
+                text = line.decode('utf-8').rstrip('\r\n')
+                self._debug("Got '" + text + "'")
+                if (not text.startswith(_tag_prefix)):
+                    if (text == 'ok' or text == 'error'):
+                        # An untagged reply cannot be matched to a request,
+                        # so none of the pending ones will ever complete.
+                        failure = EOFError('Emulator does not tag replies')
+                        break
+                    continue
+                tag, _, text = text[len(_tag_prefix):].partition(' ')
+                if (tag not in self._pending): continue
+                future, lines = self._pending[tag]
+                if (text != 'ok' and text != 'error'):
+                    lines.append(text)
+                    continue
+
+                # Last line of the reply. The line before it is the prompt.
+                del self._pending[tag]
+                if (lines != []): self._prompt = lines.pop()
+                result = '\n'.join(l[6:] if l.startswith('data: ') else l for l in lines)
+                if (future.done()): continue
+                if (text == 'ok'): future.set_result(result)
+                else: future.set_exception(ActionFailException(result))
+        finally:
+            for future, lines in self._pending.values():
+                if (not future.done()):
+                    future.set_exception(failure)
+            self._pending = {}
+
+    async def close(self):
+        """Close the connection to the emulator"""
+        if (self._writer != None):
+            self._writer.close()
+            try:
+                await self._writer.wait_closed()
+            except (ConnectionError, OSError):
+                pass
+            self._writer = None
+        if (self._reader_task != None):
+            await asyncio.gather(self._reader_task, return_exceptions=True)
+        self._debug('async_session closed')
+
+    async def __aenter__(self):
+        return self
+
+    async def __aexit__(self,exc_type,exc_value,traceback):
+        await self.close()
+
+    def _debug(self,text):
+        """Debug output
+
+           Args:
+              text (str): Text to log. A Newline will be added.
+        """
+        if (self._debug_enabled):
+            if os.name != 'nt':
+                sys.stderr.write('[33m')
+            sys.stderr.write(text)
+            if os.name != 'nt':
+                sys.stderr.write('[0m')
+            sys.stderr.write('\n')
+
+class async_new_emulator(async_session):
+    """Starts a new copy of s3270, driven from an asyncio event loop"""
+    def __init__(self,debug=False,emulator=None,extra_args=[]):
+        """Initialize the object. Call start() to start the emulator.
+
+           Args:
+              debug (bool): True to log debug information to stderr.
+              emulator (str): Name of the emulator to start, defaults to s3270
+              extra_args(list of str, optional): Extra arguments
+                 to pass in the s3270 command line.
+        """
+        async_session.__init__(self, debug)
+        self._emulator = emulator if emulator != None else 's3270'
+        self._extra_args = extra_args
+        self._s3270 = None
+
+    async def start(self):
+        """Start the emulator and connect to it.
+
+           Returns:
+              async_new_emulator: This object
+           Raises:
+              StartupException: Unable to start s3270.
+        """
+
+        # Create a temporary socket to find a unique local port.
+        tempsocket = socket.socket()
+        tempsocket.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        tempsocket.bind(('127.0.0.1', 0))
+        port = tempsocket.getsockname()[1]
+        self._debug('Port is {0}'.format(port))
+
+        # Create the child process.
+        try:
+            args = ['-utf8',
+                    '-minversion', _tag_min_version,
+                    '-scriptport', str(port),
+                    '-scriptportonce'] + self._extra_args
+            try:
+                self._s3270 = await asyncio.create_subprocess_exec(
+                        self._emulator, *args, stderr=asyncio.subprocess.PIPE)
+            except OSError as err:
+                raise StartupException(str(err))
+
+            # It might take a couple of tries to connect, as it takes time to
+            # start the process. We wait a maximum of half a second.
+            tries = 0
+            while (True):
+                try:
+                    reader, writer = await asyncio.open_connection('127.0.0.1', port)
+                    break
+                except OSError:
+                    tries += 1
+                    if (tries >= 5): break
+                    await asyncio.sleep(0.1)
+            if (tries >= 5):
+                errmsg = 'Could not connect to emulator'
+                self._s3270.terminate()
+                r = (await self._s3270.stderr.readline()).decode('utf-8').rstrip('\r\n')
+                if (r != ''): errmsg += ': ' + r
+                await self._s3270.wait()
+                self._s3270 = None
+                raise StartupException(errmsg)
+
+            self._attach(reader, writer)
+            self._debug('Connected')
+        finally:
+            tempsocket.close()
+        return self
+
+    async def close(self):
+        """Close the connection and wait for the emulator to exit"""
+        await async_session.close(self)
+        if (self._s3270 != None):
+            # With -scriptportonce, the emulator exits when the connection
+            # closes.
+            try:
+                await asyncio.wait_for(self._s3270.wait(), 2)
+            except asyncio.TimeoutError:
+                self._s3270.terminate()
+                await self._s3270.wait()
+            self._s3270 = None
+        self._debug('async_new_emulator closed')
+
+    async def __aenter__(self):
+        return await self.start()
+
+class emulator_pool():
+    """A pool of s3270 instances, driven from one asyncio event loop"""
+    def __init__(self,size,debug=False,emulator=None,extra_args=[]):
+        """Initialize the object. Call start() to start the emulators.
+
+           Args:
+              size (int): Number of emulators to start
+              debug (bool): True to log debug information to stderr.
+              emulator (str): Name of the emulator to start, defaults to s3270
+              extra_args(list of str, optional): Extra arguments
+                 to pass in the s3270 command line.
+        """
+        self._emulators = [async_new_emulator(debug, emulator, extra_args)
+                for i in range(size)]
+        self._idle = None
+
+    @property
+    def emulators(self):
+        """Gets the emulators in the pool
+           list of async_new_emulator: The emulators
+
+        """
+        return self._emulators
+
+    async def start(self):
+        """Start all of the emulators.
+
+           Returns:
+              emulator_pool: This object
+           Raises:
+              StartupException: Unable to start s3270.
+        """
+        results = await asyncio.gather(*(e.start() for e in self._emulators),
+                return_exceptions=True)
+        for r in results:
+            if (isinstance(r, BaseException)):
+                await self.close()
+                raise r
+        self._idle = asyncio.Queue()
+        for e in self._emulators: self._idle.put_nowait(e)
+        return self
+
+    async def run_all(self,cmd,*args):
+        """Run an action on every emulator in the pool at once
+
+           Args:
+              cmd (str): Action name
+              args (iterable): Arguments
+           Returns:
+              list of str: Command output from each emulator, in order
+           Raises:
+              ActionFailException: An emulator returned an error.
+              EOFError: An emulator exited unexpectedly.
+        """
+        return await asyncio.gather(*(e.run_action(cmd, *args)
+            for e in self._emulators))
+
+    async def acquire(self):
+        """Wait for an idle emulator and take it out of the pool
+
+           Returns:
+              async_new_emulator: The emulator
+        """
+        return await self._idle.get()
+
+    def release(self,emulator):
+        """Return an emulator to the pool
+
+           Args:
+              emulator (async_new_emulator): Emulator from acquire()
+        """
+        self._idle.put_nowait(emulator)
+
+    async def run_action(self,cmd,*args):
+        """Run an action on the next idle emulator
+
+           Args:
+              cmd (str): Action name
+              args (iterable): Arguments
+           Returns:
+              str: Command output
+           Raises:
+              ActionFailException: Emulator returned an error.
+              EOFError: Emulator exited unexpectedly.
+        """
+        emulator = await self.acquire()
+        try:
+            return await emulator.run_action(cmd, *args)
+        finally:
+            self.release(emulator)
+
+    async def close(self):
+        """Close all of the emulators"""
+        await asyncio.gather(*(e.close() for e in self._emulators),
+                return_exceptions=True)
+
+    async def __aenter__(self):
+        return await self.start()
+
+    async def __aexit__(self,exc_type,exc_value,traceback):
+        await self.close()
@@ -32,6 +32,7 @@ import socket
 import sys
 import threading
 import select
+import ssl
 import Common.Test.cti as cti
 
 # Simple socket copy server.
@@ -185,8 +186,11 @@ class playback():
         nleft = n
         ret = b''
         while nleft > 0:
-            r, _, _ = select.select([self.conn], [], [], timeout)
-            self.ct.assertNotEqual([], r, f'Emulator read timed out after {len(ret)} bytes read')
+            # A TLS connection can have data already decrypted and buffered,
+            # which select cannot see.
+            if not isinstance(self.conn, ssl.SSLSocket) or self.conn.pending() == 0:
+                r, _, _ = select.select([self.conn], [], [], timeout)
+                self.ct.assertNotEqual([], r, f'Emulator read timed out after {len(ret)} bytes read')
             chunk = self.conn.recv(nleft)
             self.ct.assertNotEqual(chunk, b'', 'Unexpected emulator EOF')
             ret += chunk
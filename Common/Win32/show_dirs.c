@@ -60,7 +60,7 @@ decode_gdflags(unsigned flags)
     if (flags == 0) {
 	return "";
     }
-    vb_init(&r);
+    vb_init_tx(&r);
     for (i = 0; flagname[i].name != NULL; i++) {
 	if (flags & flagname[i].flag) {
 	    vb_appendf(&r, "%s%s", space, flagname[i].name);
@@ -71,7 +71,7 @@ decode_gdflags(unsigned flags)
     if (flags != 0) {
 	vb_appendf(&r, "%s0x%x", space, flags);
     }
-    return txdFree(vb_consume(&r));
+    return vb_consume(&r);
 }
 
 /* Show/Query for Windows directories. */
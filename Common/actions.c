@@ -49,6 +49,15 @@
 
 llist_t actions_list = LLIST_INIT(actions_list);
 unsigned actions_list_count;
+unsigned actions_generation;
+
+/* Case-insensitive hash index of actions_list. */
+#define ACTION_HASH_SIZE	256
+static action_elt_t *action_hash[ACTION_HASH_SIZE];
+
+/* Sorted array of actions_list, rebuilt when actions are added. */
+static action_elt_t **action_index;
+static unsigned action_index_count;
 
 enum iaction ia_cause;
 const char *ia_name[] = {
@@ -83,8 +92,6 @@ init_suppressed(const char *actions)
     txdFree(a);
     while ((action = strtok(a, " \t\r\n")) != NULL) {
 	size_t sl = strlen(action);
-	action_elt_t *e;
-	bool found = false;
 
 	/* Prime for the next strtok() call. */
 	a = NULL;
@@ -96,13 +103,7 @@ init_suppressed(const char *actions)
 	}
 
 	/* Make sure the action they are suppressing is real. */
-	FOREACH_LLIST(&actions_list, e, action_elt_t *) {
-	    if (!strcasecmp(e->t.name, action)) {
-		found = true;
-		break;
-	    }
-	} FOREACH_LLIST_END(&actions_list, e, action_elt_t *);
-	if (!found) {
+	if (action_find(action) == NULL) {
 	    vtrace("Warning: action '%s' in %s not found\n", action,
 		    ResSuppressActions);
 	    continue;
@@ -325,6 +326,25 @@ run_action_entry(action_elt_t *e, enum iaction cause, unsigned count,
     return ret;
 }
 
+/**
+ * Hash an action name, ignoring case.
+ *
+ * @param[in] name	Action name
+ *
+ * @returns Hash bucket index
+ */
+static unsigned
+action_hash_name(const char *name)
+{
+    unsigned h = 2166136261U;
+    char c;
+
+    while ((c = *name++) != '\0') {
+	h = (h ^ (unsigned char)tolower((unsigned char)c)) * 16777619U;
+    }
+    return h % ACTION_HASH_SIZE;
+}
+
 /*
  * Register a group of actions.
  *
@@ -360,6 +380,8 @@ register_actions(action_table_t *new_actions, unsigned count)
 	e = Malloc(sizeof(action_elt_t));
 	e->t = new_actions[i]; /* struct copy */
 	llist_init(&e->list);
+	e->hash_next = action_hash[action_hash_name(e->t.name)];
+	action_hash[action_hash_name(e->t.name)] = e;
 
 	if (before) {
 	    /* Insert before found element. */
@@ -370,7 +392,82 @@ register_actions(action_table_t *new_actions, unsigned count)
 	}
 
 	actions_list_count++;
+	actions_generation++;
+	Replace(action_index, NULL);
+    }
+}
+
+/**
+ * Look up an action by its exact name, ignoring case.
+ *
+ * @param[in] name	Action name
+ *
+ * @returns Action element, or NULL
+ */
+action_elt_t *
+action_find(const char *name)
+{
+    action_elt_t *e;
+
+    for (e = action_hash[action_hash_name(name)];
+	    e != NULL;
+	    e = e->hash_next) {
+	if (!strcasecmp(name, e->t.name)) {
+	    return e;
+	}
+    }
+    return NULL;
+}
+
+/**
+ * Find the actions whose names begin with a prefix, ignoring case.
+ *
+ * @param[in] prefix	Name prefix
+ * @param[out] matchesp	Returned array of matching actions, in order
+ *
+ * @returns Number of matches
+ */
+unsigned
+action_find_prefix(const char *prefix, action_elt_t ***matchesp)
+{
+    size_t len = strlen(prefix);
+    unsigned lo, hi;
+    unsigned first;
+
+    /* Rebuild the sorted index, if needed. */
+    if (action_index == NULL) {
+	action_elt_t *e;
+	unsigned i = 0;
+
+	action_index = (action_elt_t **)Malloc(actions_list_count *
+		sizeof(action_elt_t *));
+	FOREACH_LLIST(&actions_list, e, action_elt_t *) {
+	    action_index[i++] = e;
+	} FOREACH_LLIST_END(&actions_list, e, action_elt_t *);
+	action_index_count = i;
+    }
+
+    /* Find the first name not less than the prefix. */
+    lo = 0;
+    hi = action_index_count;
+    while (lo < hi) {
+	unsigned mid = lo + (hi - lo) / 2;
+
+	if (strncasecmp(action_index[mid]->t.name, prefix, len) < 0) {
+	    lo = mid + 1;
+	} else {
+	    hi = mid;
+	}
+    }
+
+    /* Collect the names that match. */
+    first = lo;
+    while (lo < action_index_count &&
+	    !strncasecmp(action_index[lo]->t.name, prefix, len)) {
+	lo++;
     }
+    *matchesp = action_index + first;
+    return lo - first;
 }
 
 /**
@@ -103,12 +103,6 @@ mcursor_waiting(void)
 {
 }
 
-bool
-screen_obscured(void)
-{
-    return false;
-}
-
 unsigned long
 screen_window_number(void)
 {
@@ -71,6 +71,7 @@
 #include "kybd.h"
 #include "login_macro.h"
 #include "min_version.h"
+#include "metrics.h"
 #include "model.h"
 #include "names.h"
 #include "nvt.h"
@@ -82,6 +83,7 @@
 #include "prefer.h"
 #include "print_screen.h"
 #include "product.h"
+#include "profile.h"
 #include "proxy.h"
 #include "proxy_toggle.h"
 #include "query.h"
@@ -89,6 +91,7 @@
 #include "rpq.h"
 #include "save_restore.h"
 #include "screen.h"
+#include "screen_text.h"
 #include "selectc.h"
 #include "sio.h"
 #include "sio_glue.h"
@@ -176,12 +179,36 @@ usage(const char *msg)
 static void
 dump_stats(void)
 {
+    unsigned long count, p50, p99;
+    int i;
+
+    metrics_conn_response(&count, &p50, &p99);
     ui_leaf(IndStats,
 	    AttrBytesReceived, AT_INT, (int64_t)brcvd,
 	    AttrRecordsReceived, AT_INT, (int64_t)rrcvd,
 	    AttrBytesSent, AT_INT, (int64_t)bsent,
 	    AttrRecordsSent, AT_INT, (int64_t)rsent,
+	    AttrResponseCount, AT_INT, (int64_t)count,
+	    AttrResponseP50, AT_INT, (int64_t)p50,
+	    AttrResponseP99, AT_INT, (int64_t)p99,
 	    NULL);
+
+    /* Add the per-subsystem profile. */
+    if (!appres.profile) {
+	return;
+    }
+    for (i = 0; i < NUM_PC; i++) {
+	unsigned long allocs;
+	unsigned long long bytes, usec;
+
+	prof_get(i, &allocs, &bytes, &usec);
+	ui_leaf(IndProfile,
+		AttrName, AT_STRING, prof_name(i),
+		AttrAllocations, AT_INT, (int64_t)allocs,
+		AttrBytes, AT_INT, (int64_t)bytes,
+		AttrCpuMs, AT_INT, (int64_t)(usec / 1000),
+		NULL);
+    }
 }
 
 /* Dump the current send/receive stats out if they have changed. */
@@ -597,6 +624,9 @@ main(int argc, char *argv[])
 #endif /*]*/
     resolver_pipe_register();
     oq_register();
+    metrics_register();
+    profile_register();
+    screen_text_register();
 
     supports_cmdline_host = false;
     argc = parse_command_line(argc, (const char **)argv, &cl_hostname);
@@ -1148,7 +1178,7 @@ static void
 b3270_printer(bool on)
 {
     ui_leaf(IndOia,
-	    AttrField, AT_STRING, "printer-session",
+	    AttrField, AT_STRING, OiaPrinterSession,
 	    AttrValue, AT_BOOLEAN, on,
 	    AttrLu, AT_STRING, on? pr3287_session_lu(): NULL,
 	    NULL);
@@ -1180,6 +1210,8 @@ b3270_register(void)
 	{ AnForceStatus,	ForceStatus_action,	ACTION_HIDDEN },
     };
     static opt_t b3270_opts[] = {
+	{ OptBinaryScreen,OPT_BOOLEAN,true,ResBinaryScreen,aoffset(b3270.binary_screen),
+	    NULL, "Send screen updates in binary" },
 	{ OptCallback, OPT_STRING,  false, ResCallback,
 	    aoffset(scripting.callback), NULL, "Callback address and port" },
 	{ OptIndent,   OPT_BOOLEAN, true,  ResIndent,    aoffset(b3270.indent),
@@ -1194,12 +1226,14 @@ b3270_register(void)
 	    NULL, "Use XML format" },
     };
     static res_t b3270_resources[] = {
+	{ ResBinaryScreen,	aoffset(b3270.binary_screen), XRM_BOOLEAN },
 	{ ResCallback,		aoffset(scripting.callback), XRM_STRING },
 	{ ResIdleCommand,aoffset(idle_command),     XRM_STRING },
 	{ ResIdleCommandEnabled,aoffset(idle_command_enabled),XRM_BOOLEAN },
 	{ ResIdleTimeout,aoffset(idle_timeout),     XRM_STRING },
 	{ ResIndent,		aoffset(b3270.indent),XRM_BOOLEAN },
 	{ ResJson,		aoffset(b3270.json),XRM_BOOLEAN },
+	{ ResMaxFrameRate,	aoffset(b3270.max_frame_rate),XRM_INT },
 	{ ResUtf8,		aoffset(utf8),      XRM_BOOLEAN },
 	{ ResWrapperDoc,	aoffset(b3270.wrapper_doc), XRM_BOOLEAN },
     };
@@ -31,3 +31,4 @@
  */
 
 void b3270_new_codepage(bool);
+void screen_ui_drained(void);
@@ -36,10 +36,12 @@
 
 #include "appres.h"
 #include "b3270proto.h"
+#include "bscreen.h"
 #include "ctlr.h"
 #include "ctlrc.h"
 #include "ui_stream.h"
 #include "nvt.h"
+#include "profile.h"
 #include "screen.h"
 #include "see.h"
 #include "toggles.h"
@@ -55,18 +57,19 @@
 /* How many columns of attr diff to join with a text diff. */
 #define AM_MAX		16
 
-#define XX_UNDERLINE	0x0001	/* underlined */
-#define XX_BLINK	0x0002	/* blinking */
-#define XX_HIGHLIGHT	0x0004	/* highlighted */
-#define XX_SELECTABLE	0x0008	/* lightpen selectable */
-#define XX_REVERSE	0x0010	/* reverse video (3278) */
-#define XX_WIDE		0x0020	/* double-width character (DBCS) */
-#define XX_ORDER	0x0040	/* visible order */
-#define XX_PUA		0x0080	/* private use area */
-#define XX_NO_COPY	0x0100	/* do not copy into paste buffer */
-#define XX_WRAP		0x0200	/* NVT text wrapped here */
-#define XX_LEFT_HALF	0x0400	/* DBCS left half */
-#define XX_RIGHT_HALF	0x0800	/* DBCS right half */
+/* These are sent as-is in the binary protocol. */
+#define XX_UNDERLINE	BinGrUnderline	/* underlined */
+#define XX_BLINK	BinGrBlink	/* blinking */
+#define XX_HIGHLIGHT	BinGrHighlight	/* highlighted */
+#define XX_SELECTABLE	BinGrSelectable	/* lightpen selectable */
+#define XX_REVERSE	BinGrReverse	/* reverse video (3278) */
+#define XX_WIDE		BinGrWide	/* double-width character (DBCS) */
+#define XX_ORDER	BinGrOrder	/* visible order */
+#define XX_PUA		BinGrPrivateUse	/* private use area */
+#define XX_NO_COPY	BinGrNoCopy	/* do not copy into paste buffer */
+#define XX_WRAP		BinGrWrap	/* NVT text wrapped here */
+#define XX_LEFT_HALF	BinGrLeftHalf	/* DBCS left half */
+#define XX_RIGHT_HALF	BinGrRightHalf	/* DBCS right half */
 
 typedef struct {
     u_int ccode;	/* unicode character to display */
@@ -99,6 +102,19 @@ static struct ea zero_ea;
 static bool cursor_enabled = true;
 
 static void screen_disp_cond(bool always);
+static void scroll_saved(unsigned char fg, unsigned char bg, int count);
+static bool screen_deferred = false;
+
+static ioid_t frame_id = NULL_IOID;
+static struct timeval last_frame;
+
+/* Rows scrolled off the screen while an update is being held. */
+#define MAX_HELD_ROWS	1024	/* maximum number of rows held */
+static struct ea *held_rows = NULL;	/* the rows, oldest first */
+static int n_held = 0;			/* number of rows held */
+static int held_cols = 0;		/* width of each row */
+static unsigned char held_fg;		/* fill colors for the last scroll */
+static unsigned char held_bg;
 
 /*
  * Compare two screen_t's for equality.
@@ -133,7 +149,7 @@ see_gr(u_short gr)
 	return "default";
     }
 
-    vb_init(&r);
+    vb_init_tx(&r);
     if (gr & XX_UNDERLINE) {
 	vb_appends(&r, "underline");
 	sep = ",";
@@ -182,7 +198,7 @@ see_gr(u_short gr)
 	vb_appendf(&r, "%sright-half", sep);
 	sep = ",";
     }
-    return txdFree(vb_consume(&r));
+    return vb_consume(&r);
 }
 
 /* Save empty screen state. */
@@ -200,6 +216,9 @@ save_empty(void)
     saved_cols = COLS;
     saved_ea_is_empty = true;
 
+    /* Forget any held scrolls. */
+    n_held = 0;
+
     /* Erase saved_s. */
     Replace(saved_s, (screen_t *)Malloc(ss));
     memset(saved_s, 0, ss);
@@ -216,6 +235,16 @@ emit_erase(int rows, int cols)
 {
     bool switched = rows > 0 && cols > 0;
 
+    if (BINARY_MODE) {
+	uib_start(BinErase);
+	uib_put16(switched? rows: BinEraseSame);
+	uib_put16(switched? cols: BinEraseSame);
+	uib_put8(mode3279? HOST_COLOR_BLUE: BinColorDefault);
+	uib_put8(mode3279? HOST_COLOR_NEUTRAL_BLACK: BinColorDefault);
+	uib_end();
+	return;
+    }
+
     ui_leaf(IndErase,
 	    AttrLogicalRows, switched? AT_INT: AT_SKIP_INT, (int64_t)rows,
 	    AttrLogicalColumns, switched? AT_INT: AT_SKIP_INT, (int64_t)cols,
@@ -350,7 +379,7 @@ render_screen(struct ea *ea, screen_t *s)
 {
     int i;
     ucs4_t uc;
-    int fa_addr = find_field_attribute(0);
+    int fa_addr = formatted? find_field_attribute_ea(0, ea): -1;
     unsigned char fa = ea[fa_addr].fa;
     int fa_fg;
     int fa_bg;
@@ -402,7 +431,7 @@ render_screen(struct ea *ea, screen_t *s)
 
 	uc = 0;
 
-	d = ctlr_dbcs_state(i);
+	d = ctlr_dbcs_state_ea(i, ea);
 	if (ea[i].fa) {
 	    uc = ' ';
 	    fa = ea[i].fa;
@@ -854,6 +883,62 @@ emit_rowdiffs(screen_t *oldr, screen_t *newr, rowdiff_t *diffs)
     }
 }
 
+/* Emit binary-encoded diffs. */
+static void
+emit_rowdiffs_binary(screen_t *oldr, screen_t *newr, int row,
+	rowdiff_t *diffs)
+{
+    rowdiff_t *d;
+    unsigned count = 0;
+
+    for (d = diffs; d != NULL; d = d->next) {
+	count++;
+    }
+    uib_put16(row + 1);
+    uib_put16(count);
+
+    for (d = diffs; d != NULL; d = d->next) {
+	screen_t *o = &oldr[d->start_col];
+	screen_t *n = &newr[d->start_col];
+
+	uib_put8((d->reason == RD_TEXT)? BinChangeText: BinChangeAttr);
+	uib_put16(d->start_col + 1);
+	uib_put8(((o->fg != n->fg)? BinMaskFg: 0) |
+		 ((o->bg != n->bg)? BinMaskBg: 0) |
+		 ((o->gr != n->gr)? BinMaskGr: 0));
+	if (o->fg != n->fg) {
+	    uib_put8(n->fg);
+	}
+	if (o->bg != n->bg) {
+	    uib_put8(n->bg);
+	}
+	if (o->gr != n->gr) {
+	    uib_put16(n->gr);
+	}
+
+	if (d->reason == RD_TEXT) {
+	    int i;
+	    varbuf_t r;
+	    char utf8_buf[6];
+	    int utf8_len;
+
+	    vb_init(&r);
+	    for (i = 0; i < d->width; i++) {
+		if (n[i].ccode == 0) {
+		    /* DBCS right, skip it. */
+		    continue;
+		}
+		utf8_len = unicode_to_utf8(n[i].ccode, utf8_buf);
+		vb_append(&r, utf8_buf, utf8_len);
+	    }
+	    uib_put_string(vb_buf(&r), vb_len(&r));
+	    vb_free(&r);
+	} else {
+	    uib_put16(d->width);
+	}
+    }
+}
+
 static rowdiff_t *
 free_rowdiffs(rowdiff_t *diffs)
 {
@@ -868,7 +953,7 @@ free_rowdiffs(rowdiff_t *diffs)
 
 /* Emit one row's worth of diffs. */
 static void
-emit_row(screen_t *oldr, screen_t *newr)
+emit_row(screen_t *oldr, screen_t *newr, int row)
 {
     rowdiff_t *diffs = NULL;
 
@@ -879,7 +964,11 @@ emit_row(screen_t *oldr, screen_t *newr)
     diffs = merge_adjacent(diffs, oldr, newr);
 
     /* Emit the diffs. */
-    emit_rowdiffs(oldr, newr, diffs);
+    if (BINARY_MODE) {
+	emit_rowdiffs_binary(oldr, newr, row, diffs);
+    } else {
+	emit_rowdiffs(oldr, newr, diffs);
+    }
 
     /* Free the diffs. */
     diffs = free_rowdiffs(diffs);
@@ -894,6 +983,15 @@ emit_cursor_cond(bool with_screen)
 {
     /* Check for a cursor move. */
     if (cursor_enabled && sent_baddr != saved_baddr) {
+	if (BINARY_MODE) {
+	    uib_start(BinCursor);
+	    uib_put8(true);
+	    uib_put16((saved_baddr / COLS) + 1);
+	    uib_put16((saved_baddr % COLS) + 1);
+	    uib_end();
+	    sent_baddr = saved_baddr;
+	    return;
+	}
 	if (with_screen) {
 	    if (XML_MODE) {
 		uix_push(IndScreen, NULL);
@@ -919,6 +1017,33 @@ emit_cursor_cond(bool with_screen)
     }
 }
 
+/*
+ * Emit the diff between two screens as a binary message.
+ */
+static void
+emit_diff_binary(screen_t *old, screen_t *new)
+{
+    int row;
+    unsigned count = 0;
+
+    emit_cursor_cond(false);
+    for (row = 0; row < maxROWS; row++) {
+	if (memcmp(old + (row * maxCOLS), new + (row * maxCOLS),
+		sizeof(screen_t) * maxCOLS)) {
+	    count++;
+	}
+    }
+    uib_start(BinScreen);
+    uib_put16(count);
+    for (row = 0; row < maxROWS; row++) {
+	if (memcmp(old + (row * maxCOLS), new + (row * maxCOLS),
+		sizeof(screen_t) * maxCOLS)) {
+	    emit_row(&old[row * maxCOLS], &new[row * maxCOLS], row);
+	}
+    }
+    uib_end();
+}
+
 /*
  * Emit the diff between two screens.
  */
@@ -927,6 +1052,11 @@ emit_diff(screen_t *old, screen_t *new)
 {
     int row;
 
+    if (BINARY_MODE) {
+	emit_diff_binary(old, new);
+	return;
+    }
+
     if (XML_MODE) {
 	uix_push(IndScreen, NULL);
     } else {
@@ -951,7 +1081,7 @@ emit_diff(screen_t *old, screen_t *new)
 		ui_add_element(AttrRow, AT_INT, (int64_t)(row + 1));
 		uij_open_array(IndChanges);
 	    }
-	    emit_row(&old[row * maxCOLS], &new[row * maxCOLS]);
+	    emit_row(&old[row * maxCOLS], &new[row * maxCOLS], row);
 	    if (XML_MODE) {
 		uix_pop();
 	    } else {
@@ -981,10 +1111,67 @@ cursor_move(int baddr)
 }
 
 /*
- * Display a changed screen, perhaps unconditionally.
+ * Send the scrolls held since the last update.
+ * The UI has to see each row before it scrolls off, so the held rows are sent
+ * a screenful at a time: an update showing the next screenful of rows, with
+ * the current screen behind them, then a scroll of that many rows.
  */
 static void
-screen_disp_cond(bool always)
+emit_held_scrolls(void)
+{
+    size_t se = ROWS * COLS * sizeof(struct ea);
+    size_t ss = maxROWS * maxCOLS * sizeof(screen_t);
+    struct ea *rows;
+    int offset = 0;
+
+    /*
+     * Lay out the held rows followed by the current screen. Like ea_buf, the
+     * buffer has an extra element in front.
+     */
+    rows = (struct ea *)Malloc(((n_held + ROWS) * COLS + 1) *
+	    sizeof(struct ea));
+    memcpy(rows + 1, held_rows, n_held * COLS * sizeof(struct ea));
+    memcpy(rows + 1 + (n_held * COLS), ea_buf, se);
+
+    while (offset < n_held) {
+	struct ea *top = rows + 1 + (offset * COLS);
+	int count = n_held - offset;
+	screen_t *s;
+
+	if (count > ROWS) {
+	    count = ROWS;
+	}
+	top[-1] = ea_buf[-1];
+	s = Malloc(ss);
+	render_screen(top, s);
+	emit_diff(saved_s, s);
+	Replace(saved_s, s);
+	memcpy(saved_ea, top, se);
+	saved_ea_is_empty = false;
+	scroll_saved(held_fg, held_bg, count);
+	offset += count;
+    }
+    Free(rows);
+    n_held = 0;
+}
+
+/*
+ * Check for no change to the screen contents since the last update.
+ */
+static bool
+screen_unchanged(void)
+{
+    return n_held == 0 &&
+	saved_rows == ROWS &&
+	saved_cols == COLS &&
+	!memcmp(saved_ea, ea_buf, ROWS * COLS * sizeof(struct ea));
+}
+
+/*
+ * Render a changed screen, perhaps unconditionally.
+ */
+static void
+screen_render_cond(bool always)
 {
     bool sent_erase = false;
     size_t se = ROWS * COLS * sizeof(struct ea);
@@ -1004,11 +1191,13 @@ screen_disp_cond(bool always)
 	save_empty();
     }
 
+    /* Send any held scrolls. */
+    if (n_held > 0) {
+	emit_held_scrolls();
+    }
+
     /* Check for no change. */
-    if (!always &&
-	saved_rows == ROWS &&
-	saved_cols == COLS &&
-	!memcmp(saved_ea, ea_buf, se)) {
+    if (!always && screen_unchanged()) {
 	emit_cursor_cond(true);
 	return;
     }
@@ -1048,6 +1237,7 @@ screen_disp_cond(bool always)
 
     /* Tell them what the screen looks like now. */
     emit_diff(saved_s, s);
+    gettimeofday(&last_frame, NULL);
 
     /* Save the screen for next time. */
     Replace(saved_ea, Malloc(se));
@@ -1058,20 +1248,118 @@ screen_disp_cond(bool always)
     saved_cols = COLS;
 }
 
+/*
+ * Display a changed screen, perhaps unconditionally.
+ */
+static void
+screen_disp_cond(bool always)
+{
+    prof_cat_t prev = prof_enter(PC_SCREEN);
+
+    screen_render_cond(always);
+    prof_leave(prev);
+}
+
+/*
+ * Display a changed screen now, unless the UI is not keeping up.
+ */
+static void
+screen_disp_now(void)
+{
+    if (frame_id != NULL_IOID) {
+	RemoveTimeOut(frame_id);
+	frame_id = NULL_IOID;
+    }
+    if (ui_backed_up()) {
+	if (!screen_deferred) {
+	    vctrace(TC_UI, "UI output backed up, deferring screen updates\n");
+	    screen_deferred = true;
+	}
+	return;
+    }
+    screen_disp_cond(false);
+}
+
+/* The frame interval has expired. */
+static void
+frame_timeout(ioid_t id _is_unused)
+{
+    frame_id = NULL_IOID;
+    screen_disp(false);
+}
+
 /*
  * Display a changed screen.
+ * If the UI is not keeping up, hold off until its output queue drains. If
+ * the last update was less than a frame interval ago, hold off until the
+ * interval expires. The screen is diffed against what was last sent, so one
+ * deferred update covers any number of intermediate changes.
  */
 void
 screen_disp(bool erasing _is_unused)
 {
-    screen_disp_cond(false);
+    int rate = appres.b3270.max_frame_rate;
+
+    if (rate > 0 && !screen_unchanged()) {
+	unsigned long interval = 1000 / rate;
+	struct timeval now;
+	unsigned long elapsed;
+
+	if (frame_id != NULL_IOID) {
+	    /* Already waiting. */
+	    return;
+	}
+	gettimeofday(&now, NULL);
+	elapsed = ((now.tv_sec - last_frame.tv_sec) * 1000000L +
+		(now.tv_usec - last_frame.tv_usec)) / 1000L;
+	if (elapsed < interval) {
+	    frame_id = AddTimeOut(interval - elapsed, frame_timeout);
+	    return;
+	}
+    }
+    screen_disp_now();
+}
+
+/**
+ * Send any pending screen update immediately.
+ */
+void
+screen_flush(void)
+{
+    if (saved_ea == NULL) {
+	/* The screen has not been initialized yet. */
+	return;
+    }
+    screen_disp_now();
 }
 
 /*
- * Scroll the screen.
+ * The UI output queue has drained. Send any deferred screen update.
  */
 void
-screen_scroll(unsigned char fg, unsigned char bg)
+screen_ui_drained(void)
+{
+    if (screen_deferred) {
+	vctrace(TC_UI, "UI output drained, sending deferred screen update\n");
+	screen_deferred = false;
+	screen_disp_cond(false);
+    }
+}
+
+/*
+ * Check for the screen being obscured.
+ */
+bool
+screen_obscured(void)
+{
+    return false;
+}
+
+/*
+ * Scroll saved_ea and saved_s, and tell the UI.
+ */
+static void
+scroll_saved(unsigned char fg, unsigned char bg, int count)
 {
     int i;
 
@@ -1084,34 +1372,92 @@ screen_scroll(unsigned char fg, unsigned char bg)
 
     /* Scroll saved_ea. */
     if (!saved_ea_is_empty) {
-	memmove(saved_ea, saved_ea + COLS,
-		(ROWS - 1) * COLS * sizeof(struct ea));
-	memset(saved_ea + (ROWS - 1) * COLS, 0, COLS * sizeof(struct ea));
-	for (i = 0; i < COLS; i++) {
-	    saved_ea[((ROWS - 1) * COLS) + i].fg = 0xf0 | fg;
-	    saved_ea[((ROWS - 1) * COLS) + i].bg = 0xf0 | bg;
+	memmove(saved_ea, saved_ea + (count * COLS),
+		(ROWS - count) * COLS * sizeof(struct ea));
+	memset(saved_ea + (ROWS - count) * COLS, 0,
+		count * COLS * sizeof(struct ea));
+	for (i = (ROWS - count) * COLS; i < ROWS * COLS; i++) {
+	    saved_ea[i].fg = 0xf0 | fg;
+	    saved_ea[i].bg = 0xf0 | bg;
 	}
     }
 
     /* Scroll saved_s. */
-    memmove(saved_s, saved_s + COLS,
-	    (maxROWS - 1) * maxCOLS * sizeof(screen_t));
-    memset(saved_s + (maxROWS - 1) * maxCOLS, 0, maxCOLS * sizeof(screen_t));
-    for (i = 0; i < maxCOLS; i++) {
-	int j = ((maxROWS - 1) * maxCOLS) + i;
-
-	saved_s[j].ccode = ' ';
-	saved_s[j].fg = fg & ~0xf0;
-	saved_s[j].bg = bg & ~0xf0;
+    memmove(saved_s, saved_s + (count * maxCOLS),
+	    (ROWS - count) * maxCOLS * sizeof(screen_t));
+    memset(saved_s + (ROWS - count) * maxCOLS, 0,
+	    count * maxCOLS * sizeof(screen_t));
+    for (i = (ROWS - count) * maxCOLS; i < ROWS * maxCOLS; i++) {
+	saved_s[i].ccode = ' ';
+	saved_s[i].fg = fg & ~0xf0;
+	saved_s[i].bg = bg & ~0xf0;
     }
 
     /* Tell the UI. */
+    if (BINARY_MODE) {
+	uib_start(BinScroll);
+	uib_put8(fg & ~0xf0);
+	uib_put8(bg & ~0xf0);
+	uib_put16(count);
+	uib_end();
+	return;
+    }
     ui_leaf(IndScroll,
 	    AttrFg, AT_STRING, see_color(0xf0 | fg),
 	    AttrBg, AT_STRING, see_color(0xf0 | bg),
+	    AttrCount, (count > 1)? AT_INT: AT_SKIP_INT, (int64_t)count,
 	    NULL);
 }
 
+/*
+ * Scroll the screen.
+ */
+void
+screen_scroll(unsigned char fg, unsigned char bg)
+{
+    scroll_saved(fg, bg, 1);
+}
+
+/*
+ * Hold a scroll until the next screen update, if updates are being held.
+ * Called by ctlr_scroll() before it scrolls ea_buf.
+ *
+ * Returns true if the row about to be scrolled off has been saved, in which
+ * case the scroll will be sent with the next update.
+ */
+bool
+screen_scroll_hold(unsigned char fg, unsigned char bg)
+{
+    if (saved_ea == NULL) {
+	return false;
+    }
+
+    if (n_held == 0) {
+	/* Bring the UI up to date, unless the update is held. */
+	screen_disp(false);
+	if (frame_id == NULL_IOID && !screen_deferred) {
+	    return false;
+	}
+    }
+
+    if (held_cols != COLS) {
+	Replace(held_rows, (struct ea *)Malloc(MAX_HELD_ROWS * COLS *
+		    sizeof(struct ea)));
+	held_cols = COLS;
+	n_held = 0;
+    } else if (n_held == MAX_HELD_ROWS) {
+	/* Drop the oldest half. */
+	memmove(held_rows, held_rows + ((MAX_HELD_ROWS / 2) * COLS),
+		(MAX_HELD_ROWS / 2) * COLS * sizeof(struct ea));
+	n_held = MAX_HELD_ROWS / 2;
+    }
+    memcpy(held_rows + (n_held * COLS), ea_buf, COLS * sizeof(struct ea));
+    n_held++;
+    held_fg = fg;
+    held_bg = bg;
+    return true;
+}
+
 /* Left-to-right swap support. */
 void
 screen_flip(void)
@@ -1140,20 +1486,28 @@ enable_cursor(bool on)
 {
     if (on != cursor_enabled) {
 	if (!(cursor_enabled = on)) {
-	    if (XML_MODE) {
-		uix_push(IndScreen, NULL);
-	    } else {
-		uij_open_object(NULL);
-		uij_open_object(IndScreen);
-	    }
-	    ui_leaf(IndCursor,
-		AttrEnabled, AT_BOOLEAN, false,
-		NULL);
-	    if (XML_MODE) {
-		uix_pop();
+	    if (BINARY_MODE) {
+		uib_start(BinCursor);
+		uib_put8(false);
+		uib_put16(0);
+		uib_put16(0);
+		uib_end();
 	    } else {
-		uij_close_object();
-		uij_close_object();
+		if (XML_MODE) {
+		    uix_push(IndScreen, NULL);
+		} else {
+		    uij_open_object(NULL);
+		    uij_open_object(IndScreen);
+		}
+		ui_leaf(IndCursor,
+		    AttrEnabled, AT_BOOLEAN, false,
+		    NULL);
+		if (XML_MODE) {
+		    uix_pop();
+		} else {
+		    uij_close_object();
+		    uij_close_object();
+		}
 	    }
 	    sent_baddr = -1;
 	}
@@ -34,6 +34,7 @@
 #include "resources.h"
 
 #include "b3270proto.h"
+#include "bscreen.h"
 #include "ctlr.h"
 #include "kybd.h"
 #include "screen.h"
@@ -80,7 +81,7 @@ status_compose(bool on, ucs4_t ucs4, enum keytype keytype)
     is_on = on;
 
     ui_leaf(IndOia,
-	    AttrField, OiaCompose,
+	    AttrField, AT_STRING, OiaCompose,
 	    AttrValue, AT_BOOLEAN, on,
 	    AttrChar, AT_STRING, on? txAsprintf("U+%04x", ucs4): NULL,
 	    AttrType, AT_STRING, on? ((keytype == KT_STD)? "std": "ge"): NULL,
@@ -146,6 +147,8 @@ status_lu(const char *s)
 static void
 status_lock(char *msg)
 {
+    /* The UI needs to see the screen that goes with the new state first. */
+    screen_flush();
     Replace(saved_lock, msg);
     if (!scrolled && !flashing) {
 	ui_leaf(IndOia,
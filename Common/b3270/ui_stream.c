@@ -52,10 +52,12 @@
 #include "b3270proto.h"
 #include "bind-opt.h"
 #include "b_password.h"
+#include "bscreen.h"
 #include "json.h"
 #include "json_run.h"
 #include "oq.h"
 #include "popups.h"
+#include "profile.h"
 #include "resources.h"
 #include "screen.h"
 #include "task.h"
@@ -63,6 +65,7 @@
 #include "txa.h"
 #include "utf8.h"
 #include "utils.h"
+#include "varbuf.h"
 #include "winops.h"
 #include "xio.h"
 
@@ -183,6 +186,7 @@ static void xml_start(void *userData, const XML_Char *name,
 static void xml_end(void *userData, const XML_Char *name);
 static void xml_data(void *userData, const XML_Char *s, int len);
 static void uij_add_to_parent(const char *name, json_t *j);
+static bool uib_oia(va_list ap);
 
 /* Write to the UI socket. */
 static void
@@ -193,6 +197,7 @@ uprintf(const char *fmt, ...)
     static char *pending_trace = NULL;
     bool write_success;
     const char *errmsg;
+    prof_cat_t prev = prof_enter(PC_UI);
 
     va_start(ap, fmt);
     s = Vasprintf(fmt, ap);
@@ -223,6 +228,27 @@ uprintf(const char *fmt, ...)
     if (!write_success) {
 	vctrace(TC_UI, "Write failure: %s\n", errmsg);
     }
+    prof_leave(prev);
+}
+
+/* UI output queue backpressure callback. */
+static void
+ui_backpressure(bool backed_up)
+{
+    if (!backed_up) {
+	screen_ui_drained();
+    }
+}
+
+/**
+ * Check for UI output backpressure.
+ *
+ * @return true if the UI is not keeping up with output.
+ */
+bool
+ui_backed_up(void)
+{
+    return ui_oq != NULL && oq_backed_up(ui_oq);
 }
 
 /* Dump a string in HTML quoted format, if needed. */
@@ -359,6 +385,17 @@ ui_leaf(const char *name, ...)
 {
     va_list ap;
 
+    if (BINARY_MODE && !strcmp(name, IndOia)) {
+	bool sent;
+
+	va_start(ap, name);
+	sent = uib_oia(ap);
+	va_end(ap);
+	if (sent) {
+	    return;
+	}
+    }
+
     va_start(ap, name);
     if (XML_MODE) {
 	uix_vobject3(true, name, ap);
@@ -621,8 +658,10 @@ uij_close(void)
     uij_container_t *jc = uij.container;
 
     if (jc->next == NULL) {
+	prof_cat_t prev = prof_enter(PC_JSON);
 	char *s = json_write_o(jc->j, JW_OPTS);
 
+	prof_leave(prev);
 	uprintf("%s\n", s);
 	Free(s);
 	json_free(jc->j);
@@ -649,6 +688,220 @@ uij_close_array(void)
     uij_close();
 }
 
+/* Binary message under construction. */
+static varbuf_t uib_msg;
+static bool uib_open = false;
+
+/* OIA field names and their binary codes. */
+static struct {
+    const char *name;
+    unsigned char code;
+} uib_oia_fields[] = {
+    { OiaNotUndera,	BinOiaNotUndera },
+    { OiaCompose,	BinOiaCompose },
+    { OiaInsert,	BinOiaInsert },
+    { OiaLock,		BinOiaLock },
+    { OiaLu,		BinOiaLu },
+    { OiaReverseInput,	BinOiaReverseInput },
+    { OiaScreentrace,	BinOiaScreentrace },
+    { OiaScript,	BinOiaScript },
+    { OiaTiming,	BinOiaTiming },
+    { OiaTypeahead,	BinOiaTypeahead },
+    { OiaPrinterSession,BinOiaPrinterSession },
+    { NULL, 0 }
+};
+
+/* OIA value attribute names and their binary codes. */
+static struct {
+    const char *name;
+    unsigned char code;
+} uib_oia_attrs[] = {
+    { AttrValue,	BinOiaAttrValue },
+    { AttrChar,		BinOiaAttrChar },
+    { AttrType,		BinOiaAttrType },
+    { AttrLu,		BinOiaAttrLu },
+    { NULL, 0 }
+};
+
+/**
+ * Start a binary message.
+ *
+ * @param[in] type	Message type
+ */
+void
+uib_start(unsigned char type)
+{
+    char header[BinHeaderSize] = { BinMarker, 0, 0, 0, 0, 0 };
+
+    assert(!uib_open);
+    uib_open = true;
+    header[1] = type;
+    vb_reset(&uib_msg);
+    vb_append(&uib_msg, header, BinHeaderSize);
+}
+
+/**
+ * Add an 8-bit value to a binary message.
+ *
+ * @param[in] value	Value to add
+ */
+void
+uib_put8(unsigned value)
+{
+    char c = value & 0xff;
+
+    vb_append(&uib_msg, &c, 1);
+}
+
+/**
+ * Add a 16-bit value to a binary message.
+ *
+ * @param[in] value	Value to add
+ */
+void
+uib_put16(unsigned value)
+{
+    char c[2];
+
+    c[0] = (value >> 8) & 0xff;
+    c[1] = value & 0xff;
+    vb_append(&uib_msg, c, 2);
+}
+
+/**
+ * Add a 32-bit value to a binary message.
+ *
+ * @param[in] value	Value to add
+ */
+void
+uib_put32(unsigned long value)
+{
+    char c[4];
+
+    c[0] = (value >> 24) & 0xff;
+    c[1] = (value >> 16) & 0xff;
+    c[2] = (value >> 8) & 0xff;
+    c[3] = value & 0xff;
+    vb_append(&uib_msg, c, 4);
+}
+
+/**
+ * Add a UTF-8 string to a binary message.
+ *
+ * @param[in] s		String
+ * @param[in] len	Length of string
+ */
+void
+uib_put_string(const char *s, size_t len)
+{
+    if (len > 0xffff) {
+	len = 0xffff;
+    }
+    uib_put16((unsigned)len);
+    vb_append(&uib_msg, s, len);
+}
+
+/**
+ * Finish a binary message and send it.
+ */
+void
+uib_end(void)
+{
+    char *m = (char *)vb_buf(&uib_msg);
+    size_t len = vb_len(&uib_msg) - BinHeaderSize;
+    const char *errmsg;
+    prof_cat_t prev = prof_enter(PC_UI);
+
+    assert(uib_open);
+    uib_open = false;
+    m[2] = (len >> 24) & 0xff;
+    m[3] = (len >> 16) & 0xff;
+    m[4] = (len >> 8) & 0xff;
+    m[5] = len & 0xff;
+    vctrace(TC_UI, "> binary type %d, %u bytes\n", m[1], (unsigned)len);
+    if (!oq_write(ui_oq, m, vb_len(&uib_msg), &errmsg)) {
+	vctrace(TC_UI, "Write failure: %s\n", errmsg);
+    }
+    prof_leave(prev);
+}
+
+/*
+ * Send an OIA indication as a binary message.
+ * Returns false if it cannot be encoded, in which case nothing is sent.
+ */
+static bool
+uib_oia(va_list ap)
+{
+    const char *tag;
+    int i;
+
+    /* The field comes first. */
+    if ((tag = va_arg(ap, const char *)) == NULL ||
+	    strcmp(tag, AttrField) ||
+	    va_arg(ap, ui_attr_t) != AT_STRING) {
+	return false;
+    }
+    tag = va_arg(ap, const char *);
+    for (i = 0; uib_oia_fields[i].name != NULL; i++) {
+	if (!strcmp(tag, uib_oia_fields[i].name)) {
+	    break;
+	}
+    }
+    if (uib_oia_fields[i].name == NULL) {
+	return false;
+    }
+
+    /* Each value is tagged with its attribute. Absent values are omitted. */
+    uib_start(BinOia);
+    uib_put8(uib_oia_fields[i].code);
+    while ((tag = va_arg(ap, const char *)) != NULL) {
+	const char *s;
+	int j;
+
+	for (j = 0; uib_oia_attrs[j].name != NULL; j++) {
+	    if (!strcmp(tag, uib_oia_attrs[j].name)) {
+		break;
+	    }
+	}
+	if (uib_oia_attrs[j].name == NULL) {
+	    uib_open = false;
+	    return false;
+	}
+
+	switch (va_arg(ap, ui_attr_t)) {
+	case AT_STRING:
+	    if ((s = va_arg(ap, const char *)) != NULL) {
+		uib_put8(uib_oia_attrs[j].code);
+		uib_put8(BinValString);
+		uib_put_string(s, strlen(s));
+	    }
+	    break;
+	case AT_INT:
+	    uib_put8(uib_oia_attrs[j].code);
+	    uib_put8(BinValInt);
+	    uib_put32((unsigned long)va_arg(ap, int64_t));
+	    break;
+	case AT_SKIP_INT:
+	    (void) va_arg(ap, int64_t);
+	    break;
+	case AT_BOOLEAN:
+	    uib_put8(uib_oia_attrs[j].code);
+	    uib_put8(BinValBoolean);
+	    uib_put8(va_arg(ap, int) != 0);
+	    break;
+	case AT_SKIP_BOOLEAN:
+	    (void) va_arg(ap, int);
+	    break;
+	default:
+	    /* Not used for OIA fields. */
+	    uib_open = false;
+	    return false;
+	}
+    }
+    uib_end();
+    return true;
+}
+
 /* Action execution support. */
 
 /* Data callback. */
@@ -724,7 +977,7 @@ ui_action_done(task_cbh handle, bool success, bool abort)
      * Repaint the screen, so the effect of the action can be seen before
      * we indicate that the action is complete.
      */
-    screen_disp(false);
+    screen_flush();
 
     ui_leaf(IndRunResult,
 	    AttrRTag, AT_STRING, uia->tag,
@@ -1284,11 +1537,14 @@ handle_json_input(char *buf, size_t nr, size_t *offset)
     json_t *result;
     json_parse_error_t *error;
     json_t *element;
+    prof_cat_t prev;
 
     *offset = 0;
 
     /* Try parsing it as JSON. */
+    prev = prof_enter(PC_JSON);
     errcode = json_parse(buf, nr, &result, &error);
+    prof_leave(prev);
     if (errcode != JE_OK) {
 	*offset = error->offset;
 	if (errcode == JE_INCOMPLETE) {
@@ -1493,9 +1749,9 @@ process_input(const char *buf, ssize_t nr)
     }
 }
 
-/* UI input-ready function. */
+/* Process UI input. */
 static void
-ui_input(iosrc_t fd _is_unused, ioid_t id _is_unused)
+ui_input_body(void)
 {
     ssize_t nr;
     char buf[INBUF_SIZE];
@@ -1609,6 +1865,16 @@ ui_input(iosrc_t fd _is_unused, ioid_t id _is_unused)
     }
 }
 
+/* UI input-ready function. */
+static void
+ui_input(iosrc_t fd _is_unused, ioid_t id _is_unused)
+{
+    prof_cat_t prev = prof_enter(PC_UI);
+
+    ui_input_body();
+    prof_leave(prev);
+}
+
 #if defined(_WIN32) /*[*/
 /* stdin input thread */
 static DWORD WINAPI
@@ -1756,6 +2022,11 @@ ui_io_init(void)
     int flags, fd;
 #endif /*]*/
 
+    /* Binary messages cannot be embedded in an XML document. */
+    if (BINARY_MODE && XML_MODE && appres.b3270.wrapper_doc) {
+	Error(OptBinaryScreen " requires " OptJson " or " OptNoWrapperDoc);
+    }
+
     /* See if we need to call out or use stdin/stdout. */
     if (appres.scripting.callback != NULL) {
 	struct sockaddr *sa;
@@ -1815,11 +2086,13 @@ ui_io_init(void)
     } else {
 	ui_oq = oq_create_stdout("b3270-stdout", TC_UI);
     }
+    oq_set_backpressure(ui_oq, ui_backpressure);
 #else /*][*/
     /* Set up the peer thread. */
     if (ui_socket != INVALID_SOCKET) {
 	AddInputSocket(ui_socket, FD_READ | FD_CLOSE, ui_input);
 	ui_oq = oq_create_socket("b3270-callback", TC_UI, ui_socket);
+	oq_set_backpressure(ui_oq, ui_backpressure);
     } else {
 	peer_enable_event = CreateEvent(NULL, FALSE, TRUE, NULL);
 	assert(peer_enable_event != INVALID_HANDLE_VALUE);
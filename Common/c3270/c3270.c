@@ -78,6 +78,7 @@
 #include "keymap.h"
 #include "kybd.h"
 #include "login_macro.h"
+#include "metrics.h"
 #include "model.h"
 #include "names.h"
 #include "nvt.h"
@@ -88,6 +89,7 @@
 #include "prefer.h"
 #include "print_screen.h"
 #include "product.h"
+#include "profile.h"
 #include "proxy_toggle.h"
 #include "query.h"
 #include "resolver_pipe.h"
@@ -95,6 +97,7 @@
 #include "s3270_proto.h"
 #include "save_restore.h"
 #include "screen.h"
+#include "screen_text.h"
 #include "selectc.h"
 #include "sio_glue.h"
 #include "split_host.h"
@@ -693,6 +696,9 @@ main(int argc, char *argv[])
 #endif /*]*/
     resolver_pipe_register();
     oq_register();
+    metrics_register();
+    profile_register();
+    screen_text_register();
 
 #if !defined(_WIN32) /*[*/
     register_merge_profile(merge_profile);
@@ -1082,7 +1082,7 @@ decode_key(int k, ucs4_t ucs4, int hint)
 	}
     }
 
-    vb_init(&r);
+    vb_init_tx(&r);
     if (hint & KM_ALT) {
 	vb_appends(&r, "Alt");
     }
@@ -1119,7 +1119,7 @@ decode_key(int k, ucs4_t ucs4, int hint)
 	}
     } while (false);
 
-    return txdFree(vb_consume(&r));
+    return vb_consume(&r);
 }
 
 /* Dump the current keymap. */
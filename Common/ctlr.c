@@ -58,6 +58,7 @@
 #include "ft_dft.h"
 #include "host.h"
 #include "kybd.h"
+#include "metrics.h"
 #include "popups.h"
 #include "screen.h"
 #include "scroll.h"
@@ -139,9 +140,11 @@ static unsigned char code_table[64] = {
 
 #define ALL_CHANGED	{ \
 	screen_changed = true; \
+	task_wake(TE_SCREEN); \
 	if (IN_NVT) { first_changed = 0; last_changed = ROWS*COLS; } }
 #define REGION_CHANGED(f, l)	{ \
 	screen_changed = true; \
+	task_wake(TE_SCREEN); \
 	if (IN_NVT) { \
 	    if (first_changed == -1 || f < first_changed) first_changed = f; \
 	    if (last_changed == -1 || l > last_changed) last_changed = l; } }
@@ -2895,6 +2898,119 @@ ctlr_add_nvt(int baddr, ucs4_t ucs4, unsigned char cs)
     }
 }
 
+/*
+ * Change a run of characters in the 3270 buffer, NVT mode.
+ * The characters are ASCII in the base character set, with the given
+ * graphic rendition and colors. The run must not wrap past the end of the
+ * buffer.
+ * Equivalent to calling ctlr_add_nvt(), ctlr_add_gr(), ctlr_add_fg() and
+ * ctlr_add_bg() for each character, but marks the changed region only once.
+ */
+void
+ctlr_add_nvt_run(int baddr, const unsigned char *text, int count,
+	unsigned char gr, unsigned char fg, unsigned char bg)
+{
+    int first = -1;
+    int last = -1;
+    int i;
+
+    if ((fg & 0xf0) != 0xf0) {
+	fg = 0;
+    }
+    if ((bg & 0xf0) != 0xf0) {
+	bg = 0;
+    }
+
+    for (i = 0; i < count; i++) {
+	struct ea *ea = &ea_buf[baddr + i];
+	bool text_changed = ea->fa || ea->ucs4 != text[i] || ea->ec != 0 ||
+	    ea->cs != CS_BASE;
+
+	if (text_changed && trace_primed && !IsBlank(ea->ec)) {
+	    if (toggled(SCREEN_TRACE)) {
+		trace_screen(false);
+	    }
+	    scroll_save(maxROWS);
+	    trace_primed = false;
+	}
+	if (text_changed || ea->gr != gr ||
+		(mode3279 && (ea->fg != fg || ea->bg != bg))) {
+	    ea->ucs4 = text[i];
+	    ea->ec = 0;
+	    ea->cs = CS_BASE;
+	    ea->fa = 0;
+	    ea->gr = gr;
+	    if (mode3279) {
+		ea->fg = fg;
+		ea->bg = bg;
+	    }
+	    if (first < 0) {
+		first = baddr + i;
+	    }
+	    last = baddr + i;
+	}
+    }
+
+    if (first >= 0) {
+	if (area_is_selected(first, last - first + 1)) {
+	    unselect(first, last - first + 1);
+	}
+	REGION_CHANGED(first, last + 1);
+	if (gr & GR_BLINK) {
+	    blink_start();
+	}
+    }
+}
+
+/*
+ * Change a run of characters in the 3270 buffer, 3270 mode.
+ * The characters are in the base character set, with default colors and
+ * graphic rendition. The run must not wrap past the end of the buffer.
+ * Equivalent to calling ctlr_add(), ctlr_add_fg() and ctlr_add_gr() for
+ * each character, but marks the changed region only once.
+ */
+void
+ctlr_add_run(int baddr, const unsigned char *ebc, int count)
+{
+    int first = -1;
+    int last = -1;
+    int i;
+
+    for (i = 0; i < count; i++) {
+	struct ea *ea = &ea_buf[baddr + i];
+
+	if (ea->fa || ea->ucs4 || ea->ec != ebc[i] || ea->cs ||
+		(mode3279 && ea->fg) || ea->gr) {
+	    if (trace_primed && !IsBlank(ea->ec)) {
+		if (toggled(SCREEN_TRACE)) {
+		    trace_screen(false);
+		}
+		scroll_save(maxROWS);
+		trace_primed = false;
+	    }
+	    ea->ec = ebc[i];
+	    ea->cs = 0;
+	    ea->fa = 0;
+	    ea->ucs4 = 0;
+	    if (mode3279) {
+		ea->fg = 0;
+	    }
+	    ea->gr = 0;
+	    if (first < 0) {
+		first = baddr + i;
+	    }
+	    last = baddr + i;
+	}
+    }
+
+    if (first >= 0) {
+	if (area_is_selected(first, last - first + 1)) {
+	    unselect(first, last - first + 1);
+	}
+	REGION_CHANGED(first, last + 1);
+    }
+}
+
 /*
  * Set a field attribute in the 3270 buffer.
  */
@@ -3085,15 +3201,30 @@ ctlr_scroll(unsigned char fg, unsigned char bg)
 {
     int qty = (ROWS - 1) * COLS;
     bool obscured;
+    bool held = false;
     int i;
 
     /* Make sure nothing is selected. (later this can be fixed) */
     unselect(0, ROWS*COLS);
 
-    /* Synchronize pending changes prior to this. */
+    if ((fg & 0xf0) != 0xf0) {
+	fg = 0;
+    }
+    if ((bg & 0xf0) != 0xf0) {
+	bg = 0;
+    }
+
+    /*
+     * Synchronize pending changes prior to this, unless the screen is holding
+     * its updates. In that case it saves the row about to be scrolled off and
+     * sends the scroll along with its next update.
+     */
     obscured = screen_obscured();
-    if (!obscured && screen_changed) {
-	screen_disp(false);
+    if (!obscured) {
+	held = screen_scroll_hold(fg, bg);
+	if (!held && screen_changed) {
+	    screen_disp(false);
+	}
     }
 
     /* Move ea_buf. */
@@ -3101,19 +3232,13 @@ ctlr_scroll(unsigned char fg, unsigned char bg)
 
     /* Clear the last line. */
     memset((char *) &ea_buf[qty], 0, COLS * sizeof(struct ea));
-    if ((fg & 0xf0) != 0xf0) {
-	fg = 0;
-    }
-    if ((bg & 0xf0) != 0xf0) {
-	bg = 0;
-    }
     for (i = 0; i < COLS; i++) {
 	ea_buf[qty + i].fg = fg;
 	ea_buf[qty + i].bg = bg;
     }
 
     /* Update the screen. */
-    if (obscured) {
+    if (obscured || held) {
 	ALL_CHANGED;
     } else {
 	screen_scroll(fg, bg);
@@ -3264,6 +3389,7 @@ static struct timeval t_start;
 static bool ticking = false;
 static bool mticking = false;
 static bool ticking_anyway = false;
+static unsigned char tick_aid;
 static ioid_t tick_id;
 static struct timeval t_want;
 
@@ -3295,6 +3421,7 @@ ticking_start(bool anyway)
 {
     gettimeofday(&t_start, NULL);
     mticking = true;
+    tick_aid = aid;
 
     vstatus_untiming();
     if (ticking) {
@@ -3338,6 +3465,9 @@ ticking_stop(struct timeval *tp)
 	    ticking_anyway? "negotiation step": "operation",
 	    cs / 1000000L,
 	    cs % 1000000L);
+    if (!ticking_anyway && CONNECTED) {
+	metrics_host_response(tick_aid, cs);
+    }
     ticking_anyway = false;
 }
 
@@ -51,13 +51,17 @@
 #include "kybd.h"
 #include "names.h"
 #include "popups.h"
+#include "query.h"
 #include "resources.h"
 #include "task.h"
 #include "toggles.h"
+#include "txa.h"
 #include "utils.h"
 #include "varbuf.h"
 
 /* Macros. */
+#define TV_US(tv)	(((unsigned long long)(tv).tv_sec * 1000000ULL) + \
+			  (unsigned long long)(tv).tv_usec)
 
 /* Globals. */
 enum ft_state ft_state = FT_NONE;	/* File transfer state */
@@ -72,6 +76,22 @@ static bool gui_conf_initted = false;
 
 static struct timeval t0;		/* Starting time */
 
+/* Throughput statistics for the current or most recent transfer. */
+static struct {
+    bool valid;			/* true if a transfer has started */
+    bool running;		/* true if the transfer is still running */
+    bool receive;		/* true if receiving from the host */
+    bool is_cut;		/* true if CUT mode */
+    bool in_request;		/* true if processing a host request */
+    int buffer_size;		/* negotiated DFT buffer size */
+    unsigned long records;	/* data records transferred */
+    unsigned long round_trips;	/* host requests processed */
+    unsigned long long host_wait_us; /* time spent waiting for the host */
+    unsigned long long local_us; /* time spent processing locally */
+    unsigned long long elapsed_us; /* total elapsed time */
+    unsigned long long mark_us;	/* start of the current interval */
+} ftstat;
+
 /* Translation table: "ASCII" to EBCDIC, as seen by IND$FILE. */
 unsigned char i_asc2ft[256] = {
 0x00,0x01,0x02,0x03,0x37,0x2d,0x2e,0x2f,0x16,0x05,0x0a,0x0b,0x0c,0x0d,0x0e,0x0f,
@@ -168,6 +188,8 @@ static void ft_connected(bool ignored);
 static void ft_in3270(bool ignored);
 
 static action_t Transfer_action;
+static const char *ft_stats_dump(void);
+static void ft_stats_finish(void);
 
 /*
  * Toggle the buffer size.
@@ -206,6 +228,9 @@ ft_register(void)
     static action_table_t ft_actions[] = {
 	{ AnTransfer,	Transfer_action,	ACTION_KE }
     };
+    static query_t queries[] = {
+	{ KwTransferStats, ft_stats_dump, NULL, QF_HIDDEN },
+    };
 
     /* Register for state changes. */
     register_schange(ST_CONNECT, ft_connected);
@@ -218,6 +243,8 @@ ft_register(void)
     register_extended_toggle(ResFtBufferSize, toggle_ft_buffer_size, NULL,
 	    NULL, (void **)&appres.ft.dft_buffer_size, XRM_INT);
 
+    /* Register the query. */
+    register_queries(queries, array_count(queries));
 }
 
 /* Encode/decode for host type. */
@@ -512,6 +539,9 @@ ft_complete(const char *errmsg)
     }
     fts.local_file = NULL;
 
+    /* Freeze the statistics. */
+    ft_stats_finish();
+
     /* Clean up the state. */
     ft_state = FT_NONE;
     kybd_ft(false);
@@ -551,9 +581,15 @@ ft_complete(const char *errmsg)
 	bytes_sec = (double)fts.length /
 		((double)(t1.tv_sec - t0.tv_sec) +
 		 (double)(t1.tv_usec - t0.tv_usec) / 1.0e6);
-	buf = Asprintf(get_message("ftComplete"), fts.length,
-		display_scale(bytes_sec),
-		fts.is_cut ? "CUT" : "DFT");
+	buf = Asprintf("%s\n%s",
+		txAsprintf(get_message("ftComplete"), fts.length,
+		    display_scale(bytes_sec),
+		    fts.is_cut ? "CUT" : "DFT"),
+		txAsprintf(get_message("ftCompleteStats"), ftstat.records,
+		    ftstat.round_trips, (double)ftstat.host_wait_us / 1.0e6,
+		    (double)ftstat.local_us / 1.0e6,
+		    fts.is_cut? "": txAsprintf(", buffer size %d",
+			ftstat.buffer_size)));
 
 	/* Send the completion message to the UI. */
 	ft_gui_clear_progress();
@@ -565,6 +601,102 @@ ft_complete(const char *errmsg)
     }
 }
 
+/* Get the current time in microseconds. */
+static unsigned long long
+ft_now_us(void)
+{
+    struct timeval t;
+
+    gettimeofday(&t, NULL);
+    return TV_US(t);
+}
+
+/* Close the current statistics interval and stop the clock. */
+static void
+ft_stats_finish(void)
+{
+    unsigned long long now;
+
+    if (!ftstat.running) {
+	return;
+    }
+    now = ft_now_us();
+    if (ftstat.in_request) {
+	ftstat.local_us += now - ftstat.mark_us;
+	ftstat.in_request = false;
+    }
+    ftstat.elapsed_us = now - TV_US(t0);
+    ftstat.running = false;
+}
+
+/*
+ * A request has arrived from the host. The time since the last reply was
+ * spent waiting for the host.
+ */
+void
+ft_stats_host_request(void)
+{
+    unsigned long long now = ft_now_us();
+
+    if (ftstat.running && !ftstat.in_request) {
+	ftstat.host_wait_us += now - ftstat.mark_us;
+	ftstat.round_trips++;
+    }
+    ftstat.in_request = true;
+    ftstat.mark_us = now;
+}
+
+/*
+ * Processing of a host request is complete. The time since the request
+ * arrived was spent locally.
+ */
+void
+ft_stats_host_reply(void)
+{
+    unsigned long long now;
+
+    if (!ftstat.running || !ftstat.in_request) {
+	return;
+    }
+    now = ft_now_us();
+    ftstat.local_us += now - ftstat.mark_us;
+    ftstat.in_request = false;
+    ftstat.mark_us = now;
+}
+
+/* Count a data record. */
+void
+ft_stats_record(void)
+{
+    ftstat.records++;
+}
+
+/* Dump the transfer statistics, for Query(). */
+static const char *
+ft_stats_dump(void)
+{
+    unsigned long long elapsed_us;
+    double bytes_sec;
+
+    if (!ftstat.valid) {
+	return "no transfers";
+    }
+    elapsed_us = ftstat.running? ft_now_us() - TV_US(t0): ftstat.elapsed_us;
+    bytes_sec = elapsed_us? (double)fts.length * 1.0e6 / (double)elapsed_us:
+	0.0;
+    return txAsprintf("%s %s %s bytes %zu bytes/sec %.0f records %lu "
+	    "round-trips %lu host-wait %.3f local %.3f elapsed %.3f "
+	    "buffer-size %d",
+	    ftstat.running? "running": "complete",
+	    ftstat.receive? "receive": "send",
+	    ftstat.is_cut? "cut": "dft",
+	    fts.length, bytes_sec, ftstat.records, ftstat.round_trips,
+	    (double)ftstat.host_wait_us / 1.0e6,
+	    (double)ftstat.local_us / 1.0e6,
+	    (double)elapsed_us / 1.0e6,
+	    ftstat.buffer_size);
+}
+
 /* Update the bytes-transferred count on the progress pop-up. */
 void
 ft_update_length(void)
@@ -587,6 +719,16 @@ ft_running(bool is_cut)
     gettimeofday(&t0, NULL);
     fts.length = 0;
 
+    /* Reset the statistics. The acknowledgement is processed locally. */
+    memset(&ftstat, 0, sizeof(ftstat));
+    ftstat.valid = true;
+    ftstat.running = true;
+    ftstat.receive = ftc->receive_flag;
+    ftstat.is_cut = is_cut;
+    ftstat.buffer_size = is_cut? 0: ftc->dft_buffersize;
+    ftstat.in_request = true;
+    ftstat.mark_us = TV_US(t0);
+
     ft_gui_running(fts.length);
 }
 
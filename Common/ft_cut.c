@@ -392,6 +392,7 @@ void
 ft_cut_data(void)
 {
     if (ea_buf[O_SF].fa && FA_IS_SKIP(ea_buf[O_SF].fa)) {
+	ft_stats_host_request();
 	switch (ea_buf[O_FRAME_TYPE].ec) {
 	case FT_CONTROL_CODE:
 	    cut_control_code();
@@ -410,6 +411,7 @@ ft_cut_data(void)
 	    cut_abort(get_message("ftCutUnknownFrame"), SC_ABORT_XMIT);
 	    break;
 	}
+	ft_stats_host_reply();
     }
 }
 
@@ -538,6 +540,10 @@ cut_data_request(void)
 	return;
     }
 
+    if (count) {
+	ft_stats_record();
+    }
+
     /* Send special data for EOF. */
     if (!count && cut_eof) {
 	ctlr_add(O_UP_DATA, EOF_DATA1, 0);
@@ -641,6 +647,7 @@ cut_data(void)
 	Free(msg);
     } else {
 	fts.length += conv_length;
+	ft_stats_record();
 	ft_update_length();
 	cut_ack();
     }
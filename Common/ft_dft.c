@@ -100,6 +100,8 @@ ft_dft_data(unsigned char *data, int length _is_unused)
 	return;
     }
 
+    ft_stats_host_request();
+
     /* Get the length. */
     cp = (unsigned char *)(data_bufr->sf_length);
     GET16(data_length, cp);
@@ -132,6 +134,8 @@ ft_dft_data(unsigned char *data, int length _is_unused)
 	trace_ds(" Unsupported(0x%04x)\n", data_type);
 	break;
     }
+
+    ft_stats_host_reply();
 }
 
 /* Process an Open request. */
@@ -403,6 +407,7 @@ dft_data_insert(struct data_buffer *data_bufr)
 	}
 
 	/* Add up amount transferred. */
+	ft_stats_record();
 	ft_update_length();
     }
 
@@ -640,6 +645,7 @@ dft_get_request(void)
 	obptr += total_read;
 
 	fts.length += total_read;
+	ft_stats_record();
     } else {
 	trace_ds("> WriteStructuredField FileTransferData EOF\n");
 	*obptr++ = HIGH8(TR_GET_REQ);
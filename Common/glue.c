@@ -362,6 +362,8 @@ parse_command_line(int argc, const char **argv, const char **cl_hostname)
 
     /* Set up the resolver. */
     set_46(appres.prefer_ipv4, appres.prefer_ipv6);
+    set_resolver_cache_ttl(appres.resolver_cache_ttl,
+	    appres.resolver_cache_neg_ttl);
 
     /*
      * Reset the cached trace detail config, so any environment variable can be OR'd in
@@ -453,6 +455,9 @@ set_appres_defaults(void)
     appres.contention_resolution = true;
     appres.new_environ = true;
     appres.max_recent = 5;
+    appres.connect_attempt_delay = 250;
+    appres.resolver_cache_ttl = 60;
+    appres.resolver_cache_neg_ttl = 10;
     appres.xtwinops = true;
 
     appres.ft.dft_buffer_size = DFT_BUF;
@@ -470,6 +475,7 @@ set_appres_defaults(void)
 
     appres.unlock_delay = false;
     appres.unlock_delay_ms = 350;
+    appres.script_port_pipeline = 16;
 
     set_toggle(AID_WAIT, true);
     set_toggle(TYPEAHEAD, true);
@@ -857,6 +863,7 @@ static res_t base_resources[] = {
     { ResCharset,	aoffset(charset),	XRM_STRING },
     { ResCodePage,	aoffset(codepage),	XRM_STRING },
     { ResConfDir,	aoffset(conf_dir),	XRM_STRING },
+    { ResConnectAttemptDelay,aoffset(connect_attempt_delay),XRM_INT },
     { ResConnectTimeout,aoffset(connect_timeout),XRM_INT },
     { ResContentionResolution, aoffset(contention_resolution), XRM_BOOLEAN },
     { ResCrosshairColor,aoffset(interactive.crosshair_color), XRM_STRING },
@@ -915,10 +922,13 @@ static res_t base_resources[] = {
 #if defined(_WIN32) /*[*/
     { ResPrintDialog,	aoffset(interactive.print_dialog), XRM_BOOLEAN },
 #endif /*]*/
+    { ResProfile,	aoffset(profile),	XRM_BOOLEAN },
     { ResProxy,		aoffset(proxy),		XRM_STRING },
     { ResQrBgColor,	aoffset(qr_bg_color),	XRM_BOOLEAN },
     { ResQuit,		aoffset(linemode.quit),	XRM_STRING },
     { ResReconnect,	aoffset(reconnect),	XRM_BOOLEAN },
+    { ResResolverCacheNegTtl,aoffset(resolver_cache_neg_ttl),XRM_INT },
+    { ResResolverCacheTtl,aoffset(resolver_cache_ttl),XRM_INT },
     { ResRetry,		aoffset(retry),		XRM_BOOLEAN },
     { ResRprnt,		aoffset(linemode.rprnt), XRM_STRING },
     { ResScreenTraceFile,aoffset(screentrace.file),XRM_STRING },
@@ -928,6 +938,7 @@ static res_t base_resources[] = {
     { ResSbcsCgcsgid, aoffset(sbcs_cgcsgid),	XRM_STRING },
     { ResScriptPort,aoffset(script_port),	XRM_STRING },
     { ResScriptPortOnce,aoffset(script_port_once), XRM_BOOLEAN },
+    { ResScriptPortPipeline,aoffset(script_port_pipeline), XRM_INT },
     { ResSuppressActions,aoffset(suppress_actions),XRM_STRING },
     { ResTermName,	aoffset(termname),	XRM_STRING },
     { ResTraceDir,	aoffset(trace_dir),	XRM_STRING },
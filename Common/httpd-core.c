@@ -2242,7 +2242,14 @@ httpd_dyn_complete(void *dhandle, const char *format, ...)
 	    httpd_print(h, HP_BUFFER, "<html>\n");
 	}
 	va_start(ap, format);
-	httpd_vprint(h, HP_BUFFER, format, ap);
+	if (reg->flags & HF_RAW_NL) {
+	    char *buf = Vasprintf(format, ap);
+
+	    httpd_print_buf(h, HP_BUFFER, buf, strlen(buf));
+	    Free(buf);
+	} else {
+	    httpd_vprint(h, HP_BUFFER, format, ap);
+	}
 	va_end(ap);
 	if (reg->content_type == CT_HTML) {
 	    if (reg->flags & HF_TRAILER) {
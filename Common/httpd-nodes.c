@@ -44,6 +44,7 @@
 
 #include "fprint_screen.h"
 #include "json.h"
+#include "metrics.h"
 #include "s3270_proto.h"
 #include "txa.h"
 #include "varbuf.h"
@@ -681,6 +682,20 @@ rest_post_dyn(const char *url, void *dhandle)
     }
 }
 
+/**
+ * Callback for the metrics node (/3270/rest/metrics).
+ *
+ * @param[in] url	URL fragment
+ * @param[in] dhandle	daemon handle
+ *
+ * @return httpd_status_t
+ */
+static httpd_status_t
+rest_metrics_dyn(const char *url _is_unused, void *dhandle)
+{
+    return httpd_dyn_complete(dhandle, "%s", metrics_dump());
+}
+
 /**
  * Initialize the HTTP object hierarchy.
  */
@@ -725,4 +740,7 @@ httpd_objects_init(void)
     httpd_set_alias(nhandle, "json/Query()");
     httpd_register_dyn_term("/3270/rest/post", "REST POST interface",
 	    CT_UNSPECIFIED, "text/plain", VERB_POST, HF_NONE, rest_post_dyn);
+    httpd_register_dyn_term("/3270/rest/metrics", "Metrics",
+	    CT_TEXT, "text/plain; version=0.0.4", VERB_GET | VERB_HEAD,
+	    HF_RAW_NL, rest_metrics_dyn);
 }
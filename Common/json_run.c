@@ -34,8 +34,11 @@
 
 #include <inttypes.h>
 
+#include "appres.h"
 #include "b3270proto.h"
 #include "json.h"
+#include "names.h"
+#include "profile.h"
 #include "task.h"
 #include "trace.h"
 #include "utils.h"
@@ -220,6 +223,76 @@ fail:
     return false;
 }
 
+/**
+ * Parse a JSON-formatted batch of commands, an object with a 'batch' array
+ * and an optional 'continue' boolean. The result is the same as the
+ * equivalent array of commands, preceded by a Batch() command.
+ *
+ * @param[in] json	JSON object to split
+ * @param[in] batch	Batch array
+ * @param[out] cmds	Parsed actions and arguments
+ * @param[out] errmsg	Error message if parsing fails
+ *
+ * @return True for success
+ */
+static bool
+hjson_split_batch(const json_t *json, const json_t *batch, cmd_t ***cmds,
+	char **errmsg)
+{
+    const json_t *member;
+    const char *key;
+    size_t key_length;
+    bool cont = false;
+    unsigned array_length;
+    unsigned i;
+    cmd_t **c = NULL;
+
+    BEGIN_JSON_OBJECT_FOREACH(json, key, key_length, member) {
+	if (json_key_matches(key, key_length, AttrBatch)) {
+	    continue;
+	}
+	if (json_key_matches(key, key_length, AttrContinue)) {
+	    if (json_type(member) != JT_BOOLEAN) {
+		*errmsg = NewString("Invalid '" AttrContinue "' type");
+		return false;
+	    }
+	    cont = json_boolean_value(member);
+	    continue;
+	}
+	*errmsg = Asprintf("Unknown object member '%.*s'", (int)key_length,
+		key);
+	return false;
+    } END_JSON_OBJECT_FOREACH(j, key, key_length, member);
+
+    if (json_type(batch) != JT_ARRAY) {
+	*errmsg = NewString("Invalid '" AttrBatch "' type");
+	return false;
+    }
+    array_length = json_array_length(batch);
+
+    /* Allocate the vector, with the Batch() command first. */
+    c = (cmd_t **)Calloc(array_length + 2, sizeof(cmd_t *));
+    c[0] = (cmd_t *)Calloc(1, sizeof(cmd_t));
+    c[0]->action = NewString(AnBatch);
+    c[0]->args = (const char **)Calloc(2, sizeof(char *));
+    c[0]->args[0] = NewString(cont? KwContinue: KwStopOnError);
+
+    for (i = 0; i < array_length; i++) {
+	char *elt_error;
+
+	if (!hjson_parse_one(json_array_element(batch, i), &c[i + 1],
+		    &elt_error)) {
+	    *errmsg = Asprintf("Element %u: %s", i, elt_error);
+	    Free(elt_error);
+	    free_cmds(c);
+	    return false;
+	}
+    }
+
+    *cmds = c;
+    return true;
+}
+
 /**
  * Parse a JSON-formatted command or a set of commands.
  *
@@ -237,11 +310,18 @@ hjson_split(const json_t *json, cmd_t ***cmds, char **single, char **errmsg)
     unsigned i;
     cmd_t **c = NULL;
     size_t len;
+    json_t *batch;
 
     *cmds = NULL;
     *single = NULL;
     *errmsg = NULL;
 
+    /* An object can be a batch. */
+    if (json_type(json) == JT_OBJECT &&
+	    json_object_member(json, AttrBatch, NT, &batch)) {
+	return hjson_split_batch(json, batch, cmds, errmsg);
+    }
+
     /* The object can be a string, an object or an array of objects. */
     switch (json_type(json)) {
     case JT_STRING:
@@ -310,12 +390,15 @@ hjson_parse(const char *cmd, size_t cmd_len, cmd_t ***cmds, char **single,
     json_t *json;
     json_errcode_t errcode;
     json_parse_error_t *error;
+    prof_cat_t prev;
 
     *cmds = NULL;
     *errmsg = NULL;
 
     /* Parse the JSON. */
+    prev = prof_enter(PC_JSON);
     errcode = json_parse(cmd, cmd_len, &json, &error);
+    prof_leave(prev);
     if (errcode != JE_OK) {
 	*errmsg = Asprintf("JSON parse error: line %d, column %d: %s",
 		error->line, error->column, error->errmsg);
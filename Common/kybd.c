@@ -128,15 +128,30 @@ static char *temporary_compose_map_name = NULL;
 #define ak_eq(k1, k2)	(((k1).ucs4  == (k2).ucs4) && \
 			 ((k1).keytype == (k2).keytype))
 
-typedef struct ta {
-    struct ta *next;
-    const char *efn_name;
-    action_t *fn;
-    const char *parm1;
-    const char *parm2;
+/*
+ * Typeahead queue.
+ *
+ * Queued actions are kept in a fixed-size ring, with their parameters stored
+ * inline, so queuing a keystroke does not allocate memory. Numeric parameters
+ * (keystrokes and AIDs) are stored as a value and a format and expanded only
+ * when the action is run.
+ */
+#define TA_MAX		1024	/* maximum queue depth */
+#define TA_PARMS_MAX	32	/* space for inline parameters */
+typedef struct {
+    const char *efn_name;	/* action name, or NULL */
+    action_t *fn;		/* function, if efn_name is NULL */
+    const char *nfmt;		/* format for numeric parm1, or NULL */
+    unsigned long nval;		/* value for numeric parm1 */
+    unsigned char nparms;	/* number of parameters */
+    char parms[TA_PARMS_MAX];	/* NUL-terminated string parameters */
 } ta_t;
-ta_t *ta_head = (struct ta *) NULL;
-ta_t *ta_tail = (struct ta *) NULL;
+static ta_t *ta_ring = NULL;
+static unsigned ta_head = 0;	/* index of oldest entry */
+static unsigned ta_depth = 0;	/* number of entries */
+static unsigned ta_max_depth = 0; /* high-water mark */
+static unsigned long ta_dropped = 0; /* entries dropped for any reason */
+static unsigned long ta_overflowed = 0; /* entries dropped because full */
 
 static char dxl[] = "0123456789abcdef";
 #define FROM_HEX(c)	(int)(strchr(dxl, tolower((unsigned char)c)) - dxl)
@@ -262,15 +277,19 @@ static action_table_t kybd_dactions[] = {
 
 /*
  * Put a function or action on the typeahead queue.
+ * If nfmt is non-NULL, the first parameter is nval, expanded with nfmt.
  */
 static void
-enq_xta(const char *name, action_t *fn, const char *parm1, const char *parm2)
+enq_xta(const char *name, action_t *fn, const char *nfmt, unsigned long nval,
+	const char *parm1, const char *parm2)
 {
     ta_t *ta;
+    size_t len1 = 0, len2 = 0;
 
     /* If no connection, forget it. */
     if (!IN_3270 && !IN_NVT && !IN_SSCP) {
 	vctrace(TC_KYBD, "  dropped (not connected)\n");
+	ta_dropped++;
 	return;
     }
 
@@ -278,6 +297,7 @@ enq_xta(const char *name, action_t *fn, const char *parm1, const char *parm2)
     if (kybdlock & KL_OERR_MASK) {
 	ring_bell();
 	vctrace(TC_KYBD, "  dropped (operator error)\n");
+	ta_dropped++;
 	return;
     }
 
@@ -285,6 +305,7 @@ enq_xta(const char *name, action_t *fn, const char *parm1, const char *parm2)
     if (kybdlock & KL_SCROLLED) {
 	ring_bell();
 	vctrace(TC_KYBD, "  dropped (scrolled)\n");
+	ta_dropped++;
 	return;
     }
 
@@ -292,33 +313,65 @@ enq_xta(const char *name, action_t *fn, const char *parm1, const char *parm2)
     if (kybdlock & KL_FT) {
 	ring_bell();
 	vctrace(TC_KYBD, "  dropped (file transfer in progress)\n");
+	ta_dropped++;
 	return;
     }
 
     /* If typeahead disabled, complain and drop it. */
     if (!toggled(TYPEAHEAD)) {
 	vctrace(TC_KYBD, "  dropped (no typeahead)\n");
+	ta_dropped++;
+	return;
+    }
+
+    /* If the queue is full, complain and drop it. */
+    if (ta_depth >= TA_MAX) {
+	ring_bell();
+	vctrace(TC_KYBD, "  dropped (typeahead full)\n");
+	ta_dropped++;
+	ta_overflowed++;
+	return;
+    }
+
+    /* If the parameters don't fit, complain and drop it. */
+    if (nfmt == NULL && parm1 != NULL) {
+	len1 = strlen(parm1) + 1;
+    }
+    if ((nfmt != NULL || parm1 != NULL) && parm2 != NULL) {
+	len2 = strlen(parm2) + 1;
+    }
+    if (len1 + len2 > TA_PARMS_MAX) {
+	ring_bell();
+	vctrace(TC_KYBD, "  dropped (parameters too long)\n");
+	ta_dropped++;
 	return;
     }
 
-    ta = (ta_t *)Malloc(sizeof(*ta));
-    ta->next = NULL;
+    if (ta_ring == NULL) {
+	ta_ring = (ta_t *)Malloc(TA_MAX * sizeof(ta_t));
+    }
+    ta = &ta_ring[(ta_head + ta_depth) % TA_MAX];
     ta->efn_name = name;
     ta->fn = fn;
-    ta->parm1 = ta->parm2 = NULL;
-    if (parm1) {
-	ta->parm1 = NewString(parm1);
-	if (parm2) {
-	    ta->parm2 = NewString(parm2);
+    ta->nfmt = nfmt;
+    ta->nval = nval;
+    ta->nparms = 0;
+    if (nfmt != NULL || parm1 != NULL) {
+	ta->nparms++;
+	if (parm1 != NULL) {
+	    memcpy(ta->parms, parm1, len1);
+	}
+	if (parm2 != NULL) {
+	    ta->nparms++;
+	    memcpy(ta->parms + len1, parm2, len2);
 	}
     }
-    if (ta_head) {
-	ta_tail->next = ta;
-    } else {
-	ta_head = ta;
+    if (ta_depth++ == 0) {
 	vstatus_typeahead(true);
     }
-    ta_tail = ta;
+    if (ta_depth > ta_max_depth) {
+	ta_max_depth = ta_depth;
+    }
 
     vctrace(TC_KYBD, "  action queued (kybdlock 0x%x)\n", kybdlock);
 }
@@ -329,16 +382,27 @@ enq_xta(const char *name, action_t *fn, const char *parm1, const char *parm2)
 static void
 enq_ta(const char *efn_name, const char *parm1, const char *parm2)
 {
-    enq_xta(efn_name, NULL, parm1, parm2);
+    enq_xta(efn_name, NULL, NULL, 0, parm1, parm2);
+}
+
+/*
+ * Put an action with a numeric first parameter on the typeahead queue.
+ */
+static void
+enq_nta(const char *efn_name, const char *nfmt, unsigned long nval,
+	const char *parm2)
+{
+    enq_xta(efn_name, NULL, nfmt, nval, NULL, parm2);
 }
 
 /*
- * Put a function on the typeahead queue.
+ * Put a function with a numeric first parameter on the typeahead queue.
  */
 static void
-enq_fta(action_t *fn, const char *parm1, const char *parm2)
+enq_nfta(action_t *fn, const char *nfmt, unsigned long nval,
+	const char *parm2)
 {
-    enq_xta(NULL, fn, parm1, parm2);
+    enq_xta(NULL, fn, nfmt, nval, NULL, parm2);
 }
 
 /*
@@ -347,34 +411,46 @@ enq_fta(action_t *fn, const char *parm1, const char *parm2)
 bool
 run_ta(void)
 {
-    ta_t *ta;
+    ta_t ta;
+    char nbuf[32];
+    unsigned argc = 0;
+    const char *argv[2] = { NULL, NULL };
+    const char *p;
 
-    if (kybdlock || (ta = ta_head) == NULL) {
+    if (kybdlock || ta_depth == 0) {
 	return false;
     }
 
-    if ((ta_head = ta->next) == NULL) {
-	ta_tail = NULL;
+    /*
+     * Copy the entry out of the ring, since running it may queue something
+     * else into the same slot.
+     */
+    ta = ta_ring[ta_head];
+    ta_head = (ta_head + 1) % TA_MAX;
+    if (--ta_depth == 0) {
 	vstatus_typeahead(false);
     }
 
-    if (ta->efn_name) {
-	run_action(ta->efn_name, IA_TYPEAHEAD, ta->parm1, ta->parm2);
-    } else {
-	unsigned argc = 0;
-	const char *argv[2];
-
-	if (ta->parm1) {
-	    argv[argc++] = ta->parm1;
-	    if (ta->parm2) {
-		argv[argc++] = ta->parm2;
-	    }
+    /* Unpack the parameters. */
+    p = ta.parms;
+    if (ta.nparms > 0) {
+	if (ta.nfmt != NULL) {
+	    snprintf(nbuf, sizeof(nbuf), ta.nfmt, ta.nval);
+	    argv[argc++] = nbuf;
+	} else {
+	    argv[argc++] = p;
+	    p += strlen(p) + 1;
+	}
+	if (ta.nparms > 1) {
+	    argv[argc++] = p;
 	}
-	(*ta->fn)(IA_TYPEAHEAD, argc, argv);
     }
-    Free((char *)ta->parm1);
-    Free((char *)ta->parm2);
-    Free(ta);
+
+    if (ta.efn_name) {
+	run_action(ta.efn_name, IA_TYPEAHEAD, argv[0], argv[1]);
+    } else {
+	(*ta.fn)(IA_TYPEAHEAD, argc, argv);
+    }
 
     return true;
 }
@@ -386,21 +462,22 @@ run_ta(void)
 static bool
 flush_ta(void)
 {
-    ta_t *ta, *next;
-    bool any = false;
+    bool any = ta_depth != 0;
 
-    for (ta = ta_head; ta != NULL; ta = next) {
-	Free((char *)ta->parm1);
-	Free((char *)ta->parm2);
-	next = ta->next;
-	Free(ta);
-	any = true;
-    }
-    ta_head = ta_tail = NULL;
+    ta_head = ta_depth = 0;
     vstatus_typeahead(false);
     return any;
 }
 
+/* Dump the typeahead queue statistics. */
+static const char *
+typeahead_dump(void)
+{
+    return txAsprintf("depth %u max-depth %u capacity %u dropped %lu "
+	    "overflowed %lu", ta_depth, ta_max_depth, TA_MAX, ta_dropped,
+	    ta_overflowed);
+}
+
 /* Decode keyboard lock bits. */
 static const char *
 kybdlock_decode(const char *how, unsigned int bits)
@@ -433,7 +510,7 @@ kybdlock_decode(const char *how, unsigned int bits)
 	return txAsprintf("%s" LOCK_NONE, how);
     }
 
-    vb_init(&r);
+    vb_init_tx(&r);
     if (bits & KL_OERR_MASK) {
 	vb_appendf(&r, "%sOERR(", how);
 	switch(bits & KL_OERR_MASK) {
@@ -468,7 +545,7 @@ kybdlock_decode(const char *how, unsigned int bits)
 	vb_appendf(&r, "%s%s?0x%x", space, how, bits);
     }
 
-    return txdFree(vb_consume(&r));
+    return vb_consume(&r);
 }
 
 /* Set bits in the keyboard lock. */
@@ -490,6 +567,7 @@ kybdlock_set(unsigned int bits, const char *cause _is_unused)
 	    unlock_delay_time = time(NULL);
 	}
 	kybdlock = n;
+	task_wake(TE_KEYBOARD);
     }
 }
 
@@ -512,6 +590,7 @@ kybdlock_clr(unsigned int bits, const char *cause)
 	    unlock_delay_time = 0;
 	}
 	kybdlock = n;
+	task_wake(TE_KEYBOARD);
     }
 }
 
@@ -815,6 +894,7 @@ kybd_register(void)
     static query_t queries[] = {
 	{ KwKeyboardLock, kybdlock_dump, NULL, QF_TRACEHDR },
 	{ KwKeyboardLockDetail, kybdlock_dump_detail, NULL, QF_TRACEHDR },
+	{ KwTypeahead, typeahead_dump, NULL, QF_HIDDEN },
     };
 
     /* Register interest in connect and disconnect events. */
@@ -1174,6 +1254,46 @@ key_Character_wrapper(ia_t ia _is_unused, unsigned argc, const char **argv)
     return true;
 }
 
+/*
+ * Replace the NULs preceding baddr in the field starting at faddr with
+ * blanks, stopping at a preceding line that is entirely NULs.
+ */
+static void
+blank_fill(int baddr, int faddr)
+{
+    int baddr_fill = baddr;
+
+    DEC_BA(baddr_fill);
+    while (baddr_fill != faddr) {
+
+	/* Check for backward line wrap. */
+	if ((baddr_fill % COLS) == COLS - 1) {
+	    bool aborted = true;
+	    int baddr_scan = baddr_fill;
+
+	    /* Check the field within the preceeding line for NULs. */
+	    while (baddr_scan != faddr) {
+		if (ea_buf[baddr_scan].ec != EBC_null) {
+		    aborted = false;
+		    break;
+		}
+		if (!(baddr_scan % COLS)) {
+		    break;
+		}
+		DEC_BA(baddr_scan);
+	    }
+	    if (aborted) {
+		break;
+	    }
+	}
+
+	if (ea_buf[baddr_fill].ec == EBC_null) {
+	    ctlr_add(baddr_fill, EBC_space, 0);
+	}
+	DEC_BA(baddr_fill);
+    }
+}
+
 /*
  * Handle an ordinary displayable character key.  Lots of stuff to handle
  * insert-mode, protected fields and etc.
@@ -1198,12 +1318,9 @@ key_Character(unsigned ebc, bool with_ge, bool pasting, bool oerr_fail,
     }
 
     if (kybdlock) {
-	const char *codename;
-
-	codename = txAsprintf("%d", ebc |
+	enq_nfta(key_Character_wrapper, "%lu", ebc |
 		(with_ge ? GE_WFLAG : 0) |
-		(pasting ? PASTE_WFLAG : 0));
-	enq_fta(key_Character_wrapper, codename,
+		(pasting ? PASTE_WFLAG : 0),
 		oerr_fail ? KwFailOnError : KwNoFailOnError);
 	return true;
     }
@@ -1391,37 +1508,7 @@ key_Character(unsigned ebc, bool with_ge, bool pasting, bool oerr_fail,
 
     /* Replace leading nulls with blanks, if desired. */
     if (formatted && toggled(BLANK_FILL)) {
-	register int baddr_fill = baddr;
-
-	DEC_BA(baddr_fill);
-	while (baddr_fill != faddr) {
-
-	    /* Check for backward line wrap. */
-	    if ((baddr_fill % COLS) == COLS - 1) {
-		bool aborted = true;
-		register int baddr_scan = baddr_fill;
-
-		/* Check the field within the preceeding line for NULs. */
-		while (baddr_scan != faddr) {
-		    if (ea_buf[baddr_scan].ec != EBC_null) {
-			aborted = false;
-			break;
-		    }
-		    if (!(baddr_scan % COLS)) {
-			break;
-		    }
-		    DEC_BA(baddr_scan);
-		}
-		if (aborted) {
-		    break;
-		}
-	    }
-
-	    if (ea_buf[baddr_fill].ec == EBC_null) {
-		ctlr_add(baddr_fill, EBC_space, 0);
-	    }
-	    DEC_BA(baddr_fill);
-	}
+	blank_fill(baddr, faddr);
     }
 
     mdt_set(cursor_addr);
@@ -1486,10 +1573,8 @@ key_WCharacter(unsigned char ebc_pair[], bool oerr_fail)
     bool no_room = false;
 
     if (kybdlock) {
-	const char *codename;
-
-	codename = txAsprintf("%d", (ebc_pair[0] << 8) | ebc_pair[1]);
-	enq_fta(key_WCharacter_wrapper, codename,
+	enq_nfta(key_WCharacter_wrapper, "%lu",
+		(ebc_pair[0] << 8) | ebc_pair[1],
 		oerr_fail ? KwFailOnError : KwNoFailOnError);
 	return false;
     }
@@ -1778,7 +1863,7 @@ key_UCharacter(ucs4_t ucs4, enum keytype keytype, enum iaction cause,
 	const char *apl_name;
 
 	if (keytype == KT_STD) {
-	    enq_ta(AnKey, txAsprintf("U+%04x", ucs4),
+	    enq_nta(AnKey, "U+%04lx", ucs4,
 		    oerr_fail ? KwFailOnError : KwNoFailOnError);
 	} else {
 	    /* APL character */
@@ -3728,7 +3813,7 @@ do_pa(unsigned n)
 	return;
     }
     if (kybdlock) {
-	enq_ta(AnPA, txAsprintf("%d", n), NULL);
+	enq_nta(AnPA, "%lu", n, NULL);
 	return;
     }
     key_AID(pa_xlate[n-1]);
@@ -3743,7 +3828,7 @@ do_pf(unsigned n)
 	return;
     }
     if (kybdlock) {
-	enq_ta(AnPF, txAsprintf("%d", n), NULL);
+	enq_nta(AnPF, "%lu", n, NULL);
 	return;
     }
     key_AID(pf_xlate[n-1]);
@@ -3826,6 +3911,116 @@ ns_action(action_t action, enum iaction cause, const char *param)
 
 }
 
+/*
+ * Fast path for String(): add a run of ordinary text to the field at the
+ * cursor in one operation.
+ *
+ * This handles only the common case: 3270 mode with a formatted screen, the
+ * keyboard unlocked, insert mode, reverse input and DBCS off, and text that
+ * translates to plain EBCDIC, going into the unprotected field at the cursor.
+ * Anything else is left to key_UCharacter(). Blank fill is applied once to
+ * the whole run. Text that does not fit in the field is left for the next
+ * call.
+ *
+ * Returns the number of characters consumed, or 0 if the fast path does not
+ * apply.
+ */
+static size_t
+key_string_fill(const ucs4_t *ws, size_t xlen)
+{
+    static unsigned char *ebuf = NULL;
+    static size_t ebuf_len = 0;
+    int baddr = cursor_addr;
+    int faddr;
+    unsigned char fa;
+    bool numeric;
+    size_t n;
+    size_t i;
+
+    /* Find the run of ordinary characters. */
+    for (n = 0; n < xlen; n++) {
+	if (ws[n] < 0x20 || ws[n] == '\\' ||
+		(ws[n] >= UPRIV2 && ws[n] <= UPRIV_dup)) {
+	    break;
+	}
+    }
+    if (n < 2) {
+	return 0;
+    }
+
+    /* Check the global state. */
+    if (kybdlock || composing != NONE || !IN_3270 || IN_SSCP || !formatted ||
+	    dbcs || toggled(INSERT_MODE) || toggled(REVERSE_INPUT) ||
+	    baddr + (int)n >= ROWS * COLS) {
+	return 0;
+    }
+
+    /* Check the field. */
+    faddr = find_field_attribute(baddr);
+    fa = ea_buf[faddr].fa;
+    if (ea_buf[baddr].fa || FA_IS_PROTECTED(fa) ||
+	    ea_buf[faddr].cs == CS_APL || ea_buf[faddr].cs == CS_DBCS) {
+	return 0;
+    }
+
+    /*
+     * Stop at the end of the field. Whatever is left over will land in the
+     * next field.
+     */
+    for (i = 1; i < n; i++) {
+	if (ea_buf[baddr + i].fa) {
+	    n = i;
+	    break;
+	}
+    }
+
+    /* Translate the text. */
+    if (n > ebuf_len) {
+	ebuf_len = n;
+	ebuf = Realloc(ebuf, ebuf_len);
+    }
+    numeric = FA_IS_NUMERIC(fa) && appres.numeric_lock;
+    for (i = 0; i < n; i++) {
+	ebc_t ebc;
+	bool ge;
+
+	ebc = unicode_to_ebcdic_ge(ws[i], &ge, toggled(APL_MODE));
+	if (ebc < EBC_space || (ebc & 0xff00) || ge) {
+	    return 0;
+	}
+	if (numeric &&
+		!((ebc >= EBC_0 && ebc <= EBC_9) ||
+		  ebc == EBC_plus ||
+		  ebc == EBC_minus ||
+		  ebc == EBC_period ||
+		  ebc == EBC_comma)) {
+	    return 0;
+	}
+	ebuf[i] = (unsigned char)ebc;
+    }
+
+    /* Update the field. */
+    vctrace(TC_KYBD, " %s -> %u characters at %d\n", ia_name[IA_STRING],
+	    (unsigned)n, baddr);
+    ctlr_add_run(baddr, ebuf, (int)n);
+    if (toggled(BLANK_FILL)) {
+	blank_fill(baddr, faddr);
+    }
+    mdt_set(baddr);
+
+    /* Implement auto-skip, and don't land on attribute bytes. */
+    baddr += (int)n;
+    while (ea_buf[baddr].fa) {
+	if (FA_IS_SKIP(ea_buf[baddr].fa)) {
+	    baddr = next_unprotected(baddr);
+	} else {
+	    INC_BA(baddr);
+	}
+    }
+    cursor_move(baddr);
+    return n;
+}
+
 /*
  * Pretend that a sequence of keys was entered at the keyboard.
  *
@@ -3908,6 +4103,15 @@ emulate_uinput(const ucs4_t *ws, size_t xlen, bool pasting, bool margin)
 
 	switch (state) {
 	case BASE:
+	    if (!pasting) {
+		size_t nf = key_string_fill(ws, xlen);
+
+		if (nf) {
+		    ws += nf;
+		    xlen -= nf;
+		    continue;
+		}
+	    }
 	    switch (c) {
 	    case '\b':
 		ns_action(Left_action, ia, NULL);
@@ -3,10 +3,10 @@ LIB3270_OBJECTS = Malloc.o XtGlue.o actions.o b8.o child.o childscript.o \
 	codepage.o cookiefile.o ctlr.o defer.o devname.o event.o favicon.o \
 	find_console.o fprint_screen.o ft.o ft_cut.o ft_dft.o globals.o \
 	glue.o host.o httpd-core.o httpd-io.o httpd-nodes.o icmd.o idle.o \
-	json.o json_run.o kybd.o linemode.o llist.o login_macro.o model.o \
-	nvt.o oq.o output.o peerscript.o percent_decode.o print_screen.o \
-	query.o readres.o resolver_pipe.o resources.o rpq.o run_action.o \
-	s3common.o save_restore.o sched.o screentrace.o sf.o sio_glue.o \
-	source.o stdinscript.o stringscript.o task.o telnet.o \
-	telnet_new_environ.o telnet_sio.o timeouts.o toggles.o trace.o uri.o \
-	util.o vstatus.o xio.o
+	json.o json_run.o kybd.o linemode.o llist.o login_macro.o metrics.o \
+	model.o nvt.o oq.o output.o peerscript.o percent_decode.o \
+	print_screen.o profile.o query.o readres.o resolver_pipe.o \
+	resources.o rpq.o run_action.o s3common.o save_restore.o sched.o \
+	screen_text.o screentrace.o sf.o sio_glue.o source.o stdinscript.o \
+	stringscript.o task.o telnet.o telnet_new_environ.o telnet_sio.o \
+	timeouts.o toggles.o trace.o uri.o util.o vstatus.o xio.o
@@ -6,5 +6,5 @@ LIB3270STUBS_OBJECTS = ft_gui_stubs.o glue_gui_stubs1.o glue_gui_stubs2.o \
 	product_stubs2.o product_stubs3.o product_stubs4.o product_stubs6.o \
 	save_stubs.o screen_stubs1.o screen_stubs2.o screen_stubs3.o \
 	screen_stubs4.o screen_stubs5.o screen_stubs6.o screen_stubs7.o \
-	scroll_stubs.o select_stubs.o sio_none.o stats_stubs.o status_stubs.o \
+	screen_stubs8.o screen_stubs9.o scroll_stubs.o select_stubs.o sio_none.o stats_stubs.o status_stubs.o \
 	telnet_gui_stubs.o tls_passwd_gui_stubs.o trace_gui_stubs.o
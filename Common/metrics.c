@@ -0,0 +1,363 @@
+/*
+ * Copyright (c) 2026 Paul Mattes.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the names of Paul Mattes nor the names of his contributors
+ *       may be used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY PAUL MATTES "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL PAUL MATTES BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+ *      metrics.c
+ *              Metrics in text exposition format.
+ */
+
+#include "globals.h"
+
+#include "actions.h"
+#include "names.h"
+#include "oq.h"
+#include "query.h"
+#include "see.h"
+#include "task.h"
+#include "telnet.h"
+#include "timeouts.h"
+#include "toggles.h"
+#include "trace.h"
+#include "txa.h"
+#include "utils.h"
+#include "varbuf.h"
+
+#include "metrics.h"
+
+#define MP	"x3270_"	/* metric name prefix */
+
+/*
+ * Host response time histogram bucket upper bounds, in ms.
+ * The steps are fine enough for useful percentile estimates.
+ */
+static unsigned long response_bounds[] = {
+    1, 2, 3, 4, 5, 6, 8, 10, 12, 15, 20, 25, 30, 40, 50, 60, 80,
+    100, 120, 150, 200, 250, 300, 400, 500, 600, 800,
+    1000, 1200, 1500, 2000, 2500, 3000, 4000, 5000, 6000, 8000,
+    10000, 15000, 20000, 30000, 60000
+};
+#define N_RESPONSE_BUCKETS	array_count(response_bounds)
+
+/* Host response time histogram. The last bucket is +Inf. */
+typedef struct {
+    unsigned long buckets[N_RESPONSE_BUCKETS + 1];
+    unsigned long count;
+    unsigned long long usec;	/* sum */
+    unsigned long max_usec;
+} rt_hist_t;
+
+static rt_hist_t rt_all;		/* since startup or reset */
+static rt_hist_t rt_conn;		/* this connection */
+static rt_hist_t *rt_aid[256];		/* per AID, since startup or reset */
+
+/* Add a response time to a histogram. */
+static void
+rt_add(rt_hist_t *h, size_t bucket, unsigned long usec)
+{
+    h->buckets[bucket]++;
+    h->count++;
+    h->usec += usec;
+    if (usec > h->max_usec) {
+	h->max_usec = usec;
+    }
+}
+
+/*
+ * Estimate a percentile from a histogram, in microseconds.
+ * Interpolates within the bucket, and never exceeds the actual maximum.
+ */
+static unsigned long
+rt_percentile(const rt_hist_t *h, unsigned pct)
+{
+    unsigned long long rank;
+    unsigned long cum = 0;
+    size_t i;
+
+    if (h->count == 0) {
+	return 0;
+    }
+    rank = ((unsigned long long)h->count * pct + 99) / 100;
+    for (i = 0; i < N_RESPONSE_BUCKETS; i++) {
+	if (cum + h->buckets[i] >= rank) {
+	    unsigned long lo = i? response_bounds[i - 1] * 1000: 0;
+	    unsigned long hi = response_bounds[i] * 1000;
+	    unsigned long est = lo + (unsigned long)
+		((hi - lo) * (rank - cum) / h->buckets[i]);
+
+	    return (est < h->max_usec)? est: h->max_usec;
+	}
+	cum += h->buckets[i];
+    }
+    return h->max_usec;
+}
+
+/* Format microseconds as seconds. */
+static const char *
+rt_secs(unsigned long long usec)
+{
+    return txAsprintf("%llu.%03llu", usec / 1000000, (usec / 1000) % 1000);
+}
+
+/* Summarize a histogram. */
+static const char *
+rt_summary(const rt_hist_t *h)
+{
+    return txAsprintf("count %lu mean %s p50 %s p90 %s p99 %s max %s",
+	    h->count, rt_secs(h->count? h->usec / h->count: 0),
+	    rt_secs(rt_percentile(h, 50)), rt_secs(rt_percentile(h, 90)),
+	    rt_secs(rt_percentile(h, 99)), rt_secs(h->max_usec));
+}
+
+/**
+ * Record a host response time.
+ *
+ * @param[in] aid	AID that started the operation
+ * @param[in] usec	Response time, in microseconds
+ */
+void
+metrics_host_response(unsigned char aid, unsigned long usec)
+{
+    size_t i;
+
+    for (i = 0; i < N_RESPONSE_BUCKETS; i++) {
+	if (usec <= response_bounds[i] * 1000) {
+	    break;
+	}
+    }
+    if (rt_aid[aid] == NULL) {
+	rt_aid[aid] = (rt_hist_t *)Calloc(1, sizeof(rt_hist_t));
+    }
+    rt_add(&rt_all, i, usec);
+    rt_add(&rt_conn, i, usec);
+    rt_add(rt_aid[aid], i, usec);
+    vctrace(TC_INFRA, "Host %s response %ss, %s\n", see_aid(aid), rt_secs(usec),
+	    rt_summary(rt_aid[aid]));
+}
+
+/**
+ * Get the response time summary for the current connection.
+ *
+ * @param[out] count	Number of responses
+ * @param[out] p50_ms	Median response time, in ms
+ * @param[out] p99_ms	99th percentile response time, in ms
+ */
+void
+metrics_conn_response(unsigned long *count, unsigned long *p50_ms,
+	unsigned long *p99_ms)
+{
+    *count = rt_conn.count;
+    *p50_ms = rt_percentile(&rt_conn, 50) / 1000;
+    *p99_ms = rt_percentile(&rt_conn, 99) / 1000;
+}
+
+/* Reset the response time histograms. */
+static void
+rt_reset(void)
+{
+    int i;
+
+    memset(&rt_all, 0, sizeof(rt_all));
+    memset(&rt_conn, 0, sizeof(rt_conn));
+    for (i = 0; i < 256; i++) {
+	Replace(rt_aid[i], NULL);
+    }
+}
+
+/* ResetResponseTimes action. */
+static bool
+ResetResponseTimes_action(ia_t ia, unsigned argc, const char **argv)
+{
+    action_debug(AnResetResponseTimes, ia, argc, argv);
+    if (check_argc(AnResetResponseTimes, argc, 0, 0) < 0) {
+	return false;
+    }
+    rt_reset();
+    return true;
+}
+
+/* Query the response times. */
+static const char *
+rt_dump(void)
+{
+    varbuf_t r;
+    int i;
+
+    vb_init_tx(&r);
+    vb_appendf(&r, "all %s\nconnection %s", rt_summary(&rt_all),
+	    rt_summary(&rt_conn));
+    for (i = 0; i < 256; i++) {
+	if (rt_aid[i] != NULL) {
+	    vb_appendf(&r, "\n%s %s", see_aid(i), rt_summary(rt_aid[i]));
+	}
+    }
+    return vb_consume(&r);
+}
+
+/* Start a new per-connection histogram when a connection starts. */
+static void
+rt_connect(bool ignored _is_unused)
+{
+    static bool was_connected = false;
+
+    if (PCONNECTED && !was_connected) {
+	memset(&rt_conn, 0, sizeof(rt_conn));
+    }
+    was_connected = PCONNECTED;
+}
+
+/* Append the HELP and TYPE lines for a metric. */
+static void
+metric_header(varbuf_t *r, const char *name, const char *type,
+	const char *help)
+{
+    vb_appendf(r, "# HELP " MP "%s %s\n# TYPE " MP "%s %s\n", name, help,
+	    name, type);
+}
+
+/* Append a metric with a single unlabelled value. */
+static void
+metric(varbuf_t *r, const char *name, const char *type, const char *help,
+	unsigned long long value)
+{
+    metric_header(r, name, type, help);
+    vb_appendf(r, MP "%s %llu\n", name, value);
+}
+
+/**
+ * Dump all metrics in text exposition format.
+ *
+ * @return Metrics text
+ */
+const char *
+metrics_dump(void)
+{
+    varbuf_t r;
+    int i;
+    size_t j;
+    unsigned queues, tasks, waiting;
+    unsigned pending;
+    unsigned long fired;
+
+    vb_init_tx(&r);
+
+    metric_header(&r, "info", "gauge", "Emulator build information.");
+    vb_appendf(&r, MP "info{program=\"%s\",version=\"%s\"} 1\n", programname,
+	    build_rpq_version);
+
+    /* Connection. */
+    metric_header(&r, "connection_state", "gauge", "Connection state.");
+    for (i = 0; i < NUM_CSTATE; i++) {
+	vb_appendf(&r, MP "connection_state{state=\"%s\"} %d\n", state_name[i],
+		cstate == (enum cstate)i);
+    }
+    metric(&r, "bytes_sent_total", "counter",
+	    "Bytes sent to the host on this connection.", ns_bsent);
+    metric(&r, "bytes_received_total", "counter",
+	    "Bytes received from the host on this connection.", ns_brcvd);
+    metric(&r, "records_sent_total", "counter",
+	    "Records sent to the host on this connection.", ns_rsent);
+    metric(&r, "records_received_total", "counter",
+	    "Records received from the host on this connection.", ns_rrcvd);
+    metric(&r, "host_queued_bytes", "gauge",
+	    "Bytes waiting to be sent to the host.", ns_bqueued);
+
+    /* Host response time. */
+    metric_header(&r, "host_response_seconds", "histogram",
+	    "Time from sending an AID to the host finishing its answer.");
+    for (i = 0; i < 256; i++) {
+	rt_hist_t *h = rt_aid[i];
+	const char *aid;
+	unsigned long cum = 0;
+
+	if (h == NULL) {
+	    continue;
+	}
+	aid = see_aid(i);
+	for (j = 0; j < N_RESPONSE_BUCKETS; j++) {
+	    cum += h->buckets[j];
+	    vb_appendf(&r, MP "host_response_seconds_bucket{aid=\"%s\",le=\"%s\"} %lu\n",
+		    aid, rt_secs(response_bounds[j] * 1000ULL), cum);
+	}
+	vb_appendf(&r, MP "host_response_seconds_bucket{aid=\"%s\",le=\"+Inf\"} %lu\n",
+		aid, h->count);
+	vb_appendf(&r, MP "host_response_seconds_sum{aid=\"%s\"} %llu.%06llu\n",
+		aid, h->usec / 1000000, h->usec % 1000000);
+	vb_appendf(&r, MP "host_response_seconds_count{aid=\"%s\"} %lu\n",
+		aid, h->count);
+    }
+
+    /* Tasks and timeouts. */
+    task_stats(&queues, &tasks, &waiting);
+    metric(&r, "task_queues", "gauge", "Active task queues.", queues);
+    metric(&r, "tasks", "gauge", "Tasks on all task queues.", tasks);
+    metric(&r, "tasks_waiting", "gauge",
+	    "Task queues blocked waiting for an event.", waiting);
+    timeout_stats(&pending, &fired);
+    metric(&r, "timeouts_pending", "gauge", "Timeouts waiting to expire.",
+	    pending);
+    metric(&r, "timeouts_fired_total", "counter", "Timeouts that expired.",
+	    fired);
+
+    /* Output queues. */
+    metric(&r, "output_queued_bytes", "gauge",
+	    "Bytes waiting in script and UI output queues.", oq_queued());
+
+    /* Tracing. */
+    metric_header(&r, "tracing", "gauge", "Tracing state.");
+    vb_appendf(&r, MP "tracing{type=\"data\"} %d\n", toggled(TRACING));
+    vb_appendf(&r, MP "tracing{type=\"screen\"} %d\n", toggled(SCREEN_TRACE));
+
+    /* Allocator. */
+    metric(&r, "allocations_total", "counter", "Memory allocations.",
+	    alloc_count);
+    metric(&r, "reallocations_total", "counter", "Memory reallocations.",
+	    realloc_count);
+    metric(&r, "frees_total", "counter", "Memory frees.", free_count);
+    metric(&r, "allocations_live", "gauge", "Memory blocks allocated.",
+	    alloc_count - free_count);
+
+    return vb_consume(&r);
+}
+
+/**
+ * Register our actions, queries and state change handlers.
+ */
+void
+metrics_register(void)
+{
+    static action_table_t actions[] = {
+	{ AnResetResponseTimes,	ResetResponseTimes_action, 0 },
+    };
+    static query_t queries[] = {
+	{ KwResponseTimes, rt_dump, NULL, QF_TRACEHDR | QF_MULTILINE },
+    };
+
+    register_actions(actions, array_count(actions));
+    register_queries(queries, array_count(queries));
+    register_schange(ST_CONNECT, rt_connect);
+}
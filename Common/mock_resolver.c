@@ -48,6 +48,7 @@
 #include "mock_resolver.h"
 
 #define MGAI_SLOTS	10	/* number of mock resolver slots */
+#define MGAI_MAX_HA	4	/* maximum addresses per slot */
 
 /* Mock resolver state. */
 static struct mock_gai {
@@ -57,8 +58,9 @@ static struct mock_gai {
 #if defined(_WIN32) /*[*/
     HANDLE event;		/* event to signal */
 #endif /*]*/
-    sockaddr_46_t sa;		/* returned address */
-    socklen_t sa_len;		/* returned address length */
+    sockaddr_46_t sa[MGAI_MAX_HA]; /* returned addresses */
+    socklen_t sa_len[MGAI_MAX_HA]; /* returned address lengths */
+    int nr;			/* number of addresses */
     unsigned short port;	/* returned port */
     ioid_t id;			/* async event ID */
 } mock_gai[MGAI_SLOTS];
@@ -108,6 +110,7 @@ mock_collect_host_and_port(int slot, struct sockaddr *sa, size_t sa_len,
 	int *nr)
 {
     struct mock_gai *g;
+    int i;
 
     assert(slot >= gai_slots && slot <= gai_slots + MGAI_SLOTS);
     g = &mock_gai[slot - gai_slots];
@@ -117,10 +120,12 @@ mock_collect_host_and_port(int slot, struct sockaddr *sa, size_t sa_len,
 	*nr = 0;
     } else {
 	*errmsg = NULL;
-	memcpy(sa, &g->sa, g->sa_len);
-	*sa_rlen = g->sa_len;
+	for (i = 0; i < g->nr && i < max; i++) {
+	    memcpy((char *)sa + (i * sa_len), &g->sa[i], g->sa_len[i]);
+	    sa_rlen[i] = g->sa_len[i];
+	}
 	*pport = g->port;
-	*nr = 1;
+	*nr = i;
     }
 
     g->busy = false;
@@ -163,8 +168,8 @@ mock_async_done(ioid_t id _is_unused)
  * <spec> looks like:
  *  fail-sync
  *  fail-async
- *  succeed-sync=<numeric-address>
- *  succeed-asnyc=<numeric-address>
+ *  succeed-sync=<numeric-address>[,<numeric-address>...]
+ *  succeed-asnyc=<numeric-address>[,<numeric-address>...]
  * This code will incrementally scan the spec and do as it specifies. If it encounters an error, it will
  * stop scanning and return a synchronous failure.
  */
@@ -201,27 +206,48 @@ mock_resolve_host_and_port_async(const char *host, const char *portname, int pf,
 	mock_gai_wix = (mock_gai_wix + 1) % MGAI_SLOTS;
 	ret = RHP_PENDING;
     } else if ((is_sync = !strncmp("succeed-sync=", token, (tlen = 13))) || !strncmp("succeed-async=", token, (tlen = 14))) {
-	sockaddr_46_t *p_sa = (sockaddr_46_t *)sa;
-	bool is_v6 = strchr(token, ':') != NULL;
-	socklen_t socklen = is_v6? sizeof(p_sa->sin6): sizeof(p_sa->sin);
-	int p;
+	sockaddr_46_t addrs[MGAI_MAX_HA];
+	socklen_t lens[MGAI_MAX_HA];
+	unsigned short port = (portname != NULL)? atoi(portname): 0;
+	char *addr_list = NewString(token + tlen);
+	char *addr_saveptr = NULL;
+	char *addr;
+	int n = 0;
+	int i;
 
-	memset(p_sa, 0, socklen);
-	p = inet_pton(is_v6? AF_INET6: AF_INET, token + tlen, is_v6? (void *)&p_sa->sin6.sin6_addr: (void *)&p_sa->sin.sin_addr);
-	if (p == 1) {
-	    unsigned short port = (portname != NULL)? atoi(portname): 0;
+	for (addr = strtok_r(addr_list, ",", &addr_saveptr);
+		addr != NULL && n < MGAI_MAX_HA && n < max;
+		addr = strtok_r(NULL, ",", &addr_saveptr)) {
+	    sockaddr_46_t *p_sa = &addrs[n];
+	    bool is_v6 = strchr(addr, ':') != NULL;
 
+	    memset(p_sa, 0, sizeof(*p_sa));
+	    if (inet_pton(is_v6? AF_INET6: AF_INET, addr, is_v6? (void *)&p_sa->sin6.sin6_addr: (void *)&p_sa->sin.sin_addr) != 1) {
+		/* inet_pton() failed */
+		ret = RHP_FATAL;
+		break;
+	    }
 	    p_sa->sa.sa_family = is_v6? AF_INET6: AF_INET;
 	    if (is_v6) {
 		p_sa->sin6.sin6_port = htons(port);
 	    } else {
 		p_sa->sin.sin_port = htons(port);
 	    }
+	    lens[n++] = is_v6? sizeof(p_sa->sin6): sizeof(p_sa->sin);
+	}
+	Free(addr_list);
+	if (n == 0) {
+	    ret = RHP_FATAL;
+	}
+
+	if (ret != RHP_FATAL) {
 	    if (is_sync) {
 		*pport = port;
-		memcpy(sa, p_sa, sizeof(sockaddr_46_t));
-		*sa_rlen = socklen;
-		*nr = 1;
+		for (i = 0; i < n; i++) {
+		    memcpy((char *)sa + (i * sa_len), &addrs[i], sizeof(sockaddr_46_t));
+		    sa_rlen[i] = lens[i];
+		}
+		*nr = n;
 		ret = RHP_SUCCESS;
 	    } else {
 		m = &mock_gai[mock_gai_wix];
@@ -232,17 +258,15 @@ mock_resolve_host_and_port_async(const char *host, const char *portname, int pf,
 #if defined(_WIN32) /*[*/
 		m->event = event;
 #endif /*]*/
-		memcpy(&m->sa, p_sa, sizeof(sockaddr_46_t));
-		m->sa_len = socklen;
+		memcpy(m->sa, addrs, n * sizeof(sockaddr_46_t));
+		memcpy(m->sa_len, lens, n * sizeof(socklen_t));
+		m->nr = n;
 		m->port = port;
 		m->id = AddTimeOut(0, mock_async_done);
 		*slot = mock_gai_wix + gai_slots;
 		mock_gai_wix = (mock_gai_wix + 1) % MGAI_SLOTS;
 		ret = RHP_PENDING;
 	    }
-	} else {
-	    /* inet_pton() failed */
-	    ret = RHP_FATAL;
 	}
     } else {
 	/* unknown token */
@@ -2065,6 +2065,101 @@ nvt_process(unsigned int c)
     task_host_output();
 }
 
+/*
+ * Return the length of the span of plain printable ASCII at the start of
+ * buf that can be written directly to the screen, or 0 if the next byte
+ * needs to go through the state machine.
+ */
+static size_t
+nvt_printable_span(const unsigned char *buf, size_t len)
+{
+    size_t span;
+    int col = cursor_addr % COLS;
+
+    if (state != DATA ||
+	    pmi != 0 ||
+	    held_wrap ||
+	    insert_mode ||
+	    once_cset != -1 ||
+	    csd[cset] != CSD_US ||
+	    cursor_addr / COLS >= scroll_bottom ||
+	    toggled(SCREEN_TRACE)) {
+	return 0;
+    }
+
+    /* Stop at the end of the row. */
+    if (len > (size_t)(COLS - col)) {
+	len = COLS - col;
+    }
+    for (span = 0; span < len; span++) {
+	unsigned char c = buf[span];
+
+	if (c & 0x80 ||
+		nvt_fn[st[(int)DATA][c]] != &ansi_printing ||
+		ctlr_dbcs_state(cursor_addr + (int)span) != DBCS_NONE) {
+	    break;
+	}
+    }
+    return span;
+}
+
+/*
+ * Write a span of plain printable ASCII to the screen.
+ * Equivalent to running each byte through ansi_printing().
+ */
+static void
+nvt_print_span(const unsigned char *buf, size_t span)
+{
+    int last = cursor_addr + (int)span - 1;
+    size_t i;
+
+    scroll_to_bottom();
+    ctlr_add_nvt_run(cursor_addr, buf, (int)span, gr, fg, bg);
+
+    /* Leave the cursor where ansi_printing() would have. */
+    if ((last % COLS) != (COLS - 1)) {
+	cursor_move(last + 1);
+    } else {
+	cursor_move(last);
+	if (wraparound_mode) {
+	    held_wrap = true;
+	}
+    }
+
+    /* Let a blocked task go. */
+    for (i = 0; i < span; i++) {
+	task_store(buf[i]);
+    }
+    task_host_output();
+}
+
+/**
+ * Process a run of NVT data from the host.
+ *
+ * Runs of plain printable ASCII in the data state are written to the screen
+ * a row at a time. Anything else goes through the state machine a byte at a
+ * time.
+ *
+ * @param[in] buf	Data
+ * @param[in] len	Length of data
+ */
+void
+nvt_process_run(const unsigned char *buf, size_t len)
+{
+    while (len > 0) {
+	size_t span = nvt_printable_span(buf, len);
+
+	if (span > 0) {
+	    nvt_print_span(buf, span);
+	} else {
+	    nvt_process(*buf);
+	    span = 1;
+	}
+	buf += span;
+	len -= span;
+    }
+}
+
 void
 nvt_send_up(void)
 {
@@ -36,6 +36,7 @@
 #include <errno.h>
 #if !defined(_WIN32) /*[*/
 # include <fcntl.h>
+# include <sys/uio.h>
 #endif /*]*/
 #include "names.h"
 #include "query.h"
@@ -51,6 +52,8 @@
 #include "oq.h"
 
 #define OQ_MAX_DEFAULT	(size_t)(10 * 1024 * 1024)	/* 10 MiB maximum */
+#define OQ_HIGH_WATER	(size_t)(256 * 1024)	/* back up above 256 KiB */
+#define OQ_IOV_MAX	64			/* segments per gather write */
 
 #define GiB	(size_t)(1024LL * 1024LL * 1024LL)
 #define MiB	(size_t)(1024LL * 1024LL)
@@ -85,6 +88,13 @@ struct oq {
     size_t cur_bytes;	/* current bytes count */
     size_t max_bytes;	/* maximum number of bytes queued */
     size_t total_bytes; /* total number of bytes written */
+    size_t enq_bytes;	/* total number of bytes that had to be queued */
+    struct timeval blocked_since; /* when output last blocked */
+    unsigned long long blocked_ms; /* total time spent blocked, in ms */
+    size_t high_water;	/* backpressure high watermark */
+    size_t low_water;	/* backpressure low watermark */
+    bool backed_up;	/* true if above the high watermark */
+    oq_backpressure_fn *backpressure; /* backpressure callback */
 };
 
 /* The set of active output queues. */
@@ -96,6 +106,12 @@ static size_t max_bytes;
 /* The total number of bytes written by all queues. */
 static size_t total_bytes;
 
+/* The total number of bytes queued by all queues. */
+static size_t total_enq_bytes;
+
+/* The total time spent blocked by all queues, in ms. */
+static unsigned long long total_blocked_ms;
+
 /*
  * The maximum number of bytes to queue.
  * If < 0, do infinite queueing.
@@ -233,6 +249,16 @@ oq_create_common(const char *name, tc_t tc, socket_t socket, iosrc_t fd)
     oq->max_bytes = 0;
     oq->total_bytes = 0;
 
+    /*
+     * Producers are told to back off well before the queue hits the
+     * overflow limit, and to resume once most of the backlog is gone.
+     */
+    oq->high_water = OQ_HIGH_WATER;
+    if (OQ_FINITE && oq->high_water > oq_max / 2) {
+	oq->high_water = oq_max / 2;
+    }
+    oq->low_water = oq->high_water / 4;
+
     LLIST_APPEND(&oq->oq_list, oqs);
 
     return oq;
@@ -293,6 +319,59 @@ oq_create_stdout(const char *name, tc_t tc)
     return oq;
 }
 
+static void write_more(iosrc_t fd, ioid_t id);
+
+/* Output has blocked. Wait for space and start the clock. */
+static void
+oq_blocked(oq_t oq)
+{
+#if !defined(_WIN32) /*[*/
+    oq->id = AddOutput(oq->is_sock? oq->u.socket: oq->u.fd, write_more);
+#else /*][*/
+    oq->id = AddOutput(oq->u.socket, write_more);
+#endif /*]*/
+    gettimeofday(&oq->blocked_since, NULL);
+}
+
+/* Output is no longer blocked. Stop waiting and account for the time. */
+static void
+oq_unblocked(oq_t oq)
+{
+    struct timeval now;
+    unsigned long long ms;
+
+    if (oq->id == NULL_IOID) {
+	return;
+    }
+    RemoveOutput(oq->id);
+    oq->id = NULL_IOID;
+
+    gettimeofday(&now, NULL);
+    ms = ((now.tv_sec - oq->blocked_since.tv_sec) * 1000000LL +
+	    (now.tv_usec - oq->blocked_since.tv_usec)) / 1000LL;
+    oq->blocked_ms += ms;
+    total_blocked_ms += ms;
+}
+
+/* Tell the producer when the queue crosses a watermark. */
+static void
+oq_check_backpressure(oq_t oq)
+{
+    if (!oq->backed_up && oq->cur_bytes >= oq->high_water) {
+	oq->backed_up = true;
+	vctrace(oq->tc, "oq %s backed up at %zu\n", oq->name, oq->cur_bytes);
+	if (oq->backpressure != NULL) {
+	    (*oq->backpressure)(true);
+	}
+    } else if (oq->backed_up && oq->cur_bytes <= oq->low_water) {
+	oq->backed_up = false;
+	vctrace(oq->tc, "oq %s drained to %zu\n", oq->name, oq->cur_bytes);
+	if (oq->backpressure != NULL) {
+	    (*oq->backpressure)(false);
+	}
+    }
+}
+
 /* Flush pending data. */
 static void
 oq_flush(oq_t oq)
@@ -303,11 +382,9 @@ oq_flush(oq_t oq)
 	llist_unlink(&d->list);
 	Free(d);
     }
-    if (oq->id != NULL_IOID) {
-	RemoveOutput(oq->id);
-	oq->id = NULL_IOID;
-    }
+    oq_unblocked(oq);
     oq->cur_bytes = 0;
+    oq->backed_up = false;
 }
 
 /* There is output space available. */
@@ -331,17 +408,35 @@ write_more(iosrc_t fd _is_unused, ioid_t id)
     }
 
     while (!llist_isempty(&oq->data_list)) {
-	oq_data_t *d = (oq_data_t *)oq->data_list.next;
+	oq_data_t *d;
+	int nseg = 0;
+	size_t want = 0;
+	size_t left;
 
+#if !defined(_WIN32) /*[*/
+	/* Gather as many segments as possible into one write. */
+	struct iovec iov[OQ_IOV_MAX];
+
+	FOREACH_LLIST(&oq->data_list, d, oq_data_t *) {
+	    iov[nseg].iov_base = d->data;
+	    iov[nseg].iov_len = d->len;
+	    want += d->len;
+	    if (++nseg >= OQ_IOV_MAX) {
+		break;
+	    }
+	} FOREACH_LLIST_END(&oq->data_list, d, oq_data_t *);
+	nw = writev(oq->is_sock? oq->u.socket: oq->u.fd, iov, nseg);
+#else /*][*/
+	/* Winsock has no writev, so write one segment at a time. */
+	d = (oq_data_t *)oq->data_list.next;
+	nseg = 1;
+	want = d->len;
 	if (oq->is_sock) {
 	    nw = send(oq->u.socket, d->data, (int)d->len, 0);
 	} else {
-#if !defined(_WIN32) /*[*/
-	    nw = write(oq->u.fd, d->data, (int)d->len);
-#else /*][*/
 	    assert(false);
-#endif /*]*/
 	}
+#endif /*]*/
 	if (nw < 0) {
 	    const char *errmsg = socket_strerror(socket_errno());
 
@@ -356,23 +451,35 @@ write_more(iosrc_t fd _is_unused, ioid_t id)
 	    }
 	}
 
-	vctrace(oq->tc, "oq %s bg wrote %zd/%zu -> %zu\n", oq->name, nw, d->len, oq->cur_bytes - nw);
+	vctrace(oq->tc, "oq %s bg wrote %zd/%zu from %d segment%s -> %zu\n", oq->name, nw, want,
+		nseg, (nseg == 1)? "": "s", oq->cur_bytes - nw);
 	oq->cur_bytes -= nw;
-	if ((size_t)nw < d->len) {
-	    /* Short write, including 0 bytes (EWOULDBLOCK). */
-	    d->data += nw;
-	    d->len -= nw;
-	    return;
+
+	/* Retire the segments that were written completely. */
+	left = (size_t)nw;
+	while (!llist_isempty(&oq->data_list)) {
+	    d = (oq_data_t *)oq->data_list.next;
+	    if (left < d->len) {
+		d->data += left;
+		d->len -= left;
+		break;
+	    }
+	    left -= d->len;
+	    llist_unlink(&d->list);
+	    Free(d);
 	}
 
-	/* This chunk is complete. */
-	llist_unlink(&d->list);
-	Free(d);
+	if ((size_t)nw < want) {
+	    /* Short write, including 0 bytes (EWOULDBLOCK). */
+	    break;
+	}
     }
 
-    vctrace(oq->tc, "oq %s output queue empty\n", oq->name);
-    RemoveOutput(oq->id);
-    oq->id = NULL_IOID;
+    if (llist_isempty(&oq->data_list)) {
+	vctrace(oq->tc, "oq %s output queue empty\n", oq->name);
+	oq_unblocked(oq);
+    }
+    oq_check_backpressure(oq);
 }
 
 /* Set up a data segment. */
@@ -411,13 +518,12 @@ oq_enq(oq_t oq, const char *data, size_t len)
 
     LLIST_APPEND(&d->list, oq->data_list);
     if (oq->id == NULL_IOID) {
-#if !defined(_WIN32) /*[*/
-	oq->id = AddOutput(oq->is_sock? oq->u.socket: oq->u.fd, write_more);
-#else /*][*/
-	oq->id = AddOutput(oq->u.socket, write_more);
-#endif /*]*/
+	oq_blocked(oq);
     }
     (void) oq_incr_len(oq, len);
+    oq->enq_bytes += len;
+    total_enq_bytes += len;
+    oq_check_backpressure(oq);
 }
 
 /* Humanize the queueing limit. */
@@ -520,6 +626,52 @@ oq_errored(oq_t oq, const char **errmsg)
     return oq->errored;
 }
 
+/**
+ * Count the bytes waiting in all output queues.
+ *
+ * @return Number of bytes queued
+ */
+size_t
+oq_queued(void)
+{
+    oq_t oq;
+    size_t queued = 0;
+
+    FOREACH_LLIST(&oqs, oq, oq_t) {
+	queued += oq->cur_bytes;
+    } FOREACH_LLIST_END(&oqs, oq, oq_t);
+    return queued;
+}
+
+/**
+ * Register a backpressure callback for an output queue.
+ * The callback is called with true when the queue grows past its high
+ * watermark, and with false when it drains back below its low watermark.
+ * It is not called for Windows standard output, which is drained by a
+ * separate thread.
+ *
+ * @param[in] oq	Handle
+ * @param[in] fn	Callback function
+ */
+void
+oq_set_backpressure(oq_t oq, oq_backpressure_fn *fn)
+{
+    oq->backpressure = fn;
+}
+
+/**
+ * Check an output queue for backpressure.
+ *
+ * @param[in] oq	Handle
+ *
+ * @return true if the producer should hold off.
+ */
+bool
+oq_backed_up(oq_t oq)
+{
+    return oq->backed_up;
+}
+
 /**
  * Free an output queue, discarding any pending data.
  * @param[in,out] oq	Handle
@@ -716,7 +868,7 @@ oq_dump(void)
     size_t total_pending = 0;
     bool any = false;
 
-    vb_init(&r);
+    vb_init_tx(&r);
 
     if (oq_enabled) {
 	if (OQ_FINITE) {
@@ -726,15 +878,17 @@ oq_dump(void)
 	}
 	any = true;
 	FOREACH_LLIST(&oqs, oq, oq_t) {
-	    vb_appendf(&r, "%s%s queued %zd maximum-queued %zd written %zd",
-		    any? "\n": "", oq->name, oq->cur_bytes, oq->max_bytes, oq->total_bytes);
+	    vb_appendf(&r, "%s%s queued %zd maximum-queued %zd written %zd enqueued %zd blocked-ms %llu%s",
+		    any? "\n": "", oq->name, oq->cur_bytes, oq->max_bytes, oq->total_bytes,
+		    oq->enq_bytes, oq->blocked_ms, oq->backed_up? " backed-up": "");
 	    total_pending += oq->cur_bytes;
 	    any = true;
 	} FOREACH_LLIST_END(&oqs, oq, oq_t);
-	vb_appendf(&r, "%stotal queued %zd maximum-queued %zd written %zd",
-		any? "\n": "", total_pending, max_bytes, total_bytes);
+	vb_appendf(&r, "%stotal queued %zd maximum-queued %zd written %zd enqueued %zd blocked-ms %llu",
+		any? "\n": "", total_pending, max_bytes, total_bytes, total_enq_bytes,
+		total_blocked_ms);
 
-	return txdFree(vb_consume(&r));
+	return vb_consume(&r);
     } else {
 	return "queueing disabled";
     }
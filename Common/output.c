@@ -40,16 +40,17 @@
 #include "screen.h"
 #include "task.h"
 #include "trace.h"
+#include "txa.h"
 #include "utils.h"
 
 void
 action_output(const char *fmt, ...)
 {
     va_list args;
-    char *s;
+    const char *s;
 
     va_start(args, fmt);
-    s = Vasprintf(fmt, args);
+    s = txVasprintf(fmt, args);
     va_end(args);
     if (task_redirect()) {
 	task_info("%s", s);
@@ -57,5 +58,4 @@ action_output(const char *fmt, ...)
 	fprintf(stderr, "%s\n", s);
 	fflush(stderr);
     }
-    Free(s);
 }
@@ -47,6 +47,7 @@
 #include <fcntl.h>
 
 #include "actions.h"
+#include "appres.h"
 #include "json.h"
 #include "json_run.h"
 #include "kybd.h"
@@ -66,6 +67,7 @@
 #include "w3misc.h"
 #include "xio.h"
 
+static void peer_input(iosrc_t fd, ioid_t id);
 static void peer_data(task_cbh handle, const char *buf, size_t len,
 	bool success);
 static bool peer_done(task_cbh handle, bool success, bool abort);
@@ -126,6 +128,13 @@ static tcb_t interactive_cb = {
     peer_getxflags,
 };
 
+/* Queued request. */
+typedef struct {
+    llist_t llist;	/* list linkage */
+    size_t len;		/* length of text */
+    char *text;		/* text, without the newline */
+} peer_req_t;
+
 /* Peer script context. */
 typedef struct {
     llist_t llist;	/* list linkage */
@@ -135,9 +144,13 @@ typedef struct {
     peer_listen_t listener;
     ioid_t ioid;	/* I/O identifier */
     ioid_t toid;	/* timeout identifier */
-    char *buf;		/* pending command */
-    size_t buf_len;	/* length of pending command */
-    size_t pj_offset;	/* partial JSON offset */
+    llist_t reqs;	/* queued requests */
+    unsigned nreqs;	/* number of queued requests */
+    varbuf_t partial;	/* partial input line */
+    varbuf_t pj;	/* partial JSON request */
+    char *tag;		/* tag of the running request */
+    bool running;	/* a request is running */
+    bool eof;		/* no more input */
     bool enabled;	/* is this peer enabled? */
     char *name;		/* task name */
     unsigned capabilities; /* self-reported capabilities */
@@ -179,11 +192,19 @@ close_peer(peer_t *p, const char *errmsg)
 	p->ioid = NULL_IOID;
     }
     if (p->toid != NULL_IOID) {
-	RemoveInput(p->toid);
+	RemoveTimeOut(p->toid);
 	p->toid = NULL_IOID;
     }
     Replace(p->desc, NULL);
-    Replace(p->buf, NULL);
+    while (!llist_isempty(&p->reqs)) {
+	peer_req_t *r = (peer_req_t *)p->reqs.next;
+
+	llist_unlink(&r->llist);
+	Free(r);
+    }
+    vb_free(&p->partial);
+    vb_free(&p->pj);
+    Replace(p->tag, NULL);
     Replace(p->name, NULL);
 
     if (p->listener == NULL || p->listener->mode == PLM_ONCE) {
@@ -200,6 +221,20 @@ close_peer(peer_t *p, const char *errmsg)
     Free(p);
 }
 
+/**
+ * Set up a JSON result, tagged if the request was.
+ *
+ * @param[in,out] p	Peer state
+ */
+static void
+peer_json_init(peer_t *p)
+{
+    p->json_result = s3json_init();
+    if (p->tag != NULL) {
+	json_object_set(p->json_result, JRET_TAG, NT, json_string(p->tag, NT));
+    }
+}
+
 /**
  * Pushes a command, with possible JSON parsing.
  *
@@ -232,7 +267,7 @@ do_push(peer_t *p, const char *buf, size_t len)
 	ret = hjson_parse(s, len, &cmds, &single, &errmsg);
 	if (ret == HJ_OK) {
 	    /* Good JSON. */
-	    p->json_result = s3json_init();
+	    peer_json_init(p);
 	    if (cmds != NULL) {
 		name = push_cb_split(cmds, tcb, (task_cbh)p);
 	    } else {
@@ -248,7 +283,7 @@ do_push(peer_t *p, const char *buf, size_t len)
 
 	    /* Answer in JSON only if successfully parsed. */
 	    if (ret != HJ_BAD_SYNTAX) {
-		p->json_result = s3json_init();
+		peer_json_init(p);
 	    }
 	    Free(errmsg);
 	    name = push_cb(fail, strlen(fail), tcb, (task_cbh)p);
@@ -263,53 +298,91 @@ do_push(peer_t *p, const char *buf, size_t len)
 }
 
 /**
- * Run the next command in the peer buffer.
+ * Start or stop reading from a peer, depending on how many requests are
+ * queued.
+ *
+ * @param[in,out] p	Peer
+ */
+static void
+peer_arm(peer_t *p)
+{
+    unsigned limit = (appres.script_port_pipeline > 0)?
+	(unsigned)appres.script_port_pipeline: 1;
+
+    if (!p->eof && p->nreqs < limit) {
+	if (p->ioid == NULL_IOID) {
+#if defined(_WIN32) /*[*/
+	    p->ioid = AddInputSocket(p->socket, FD_READ | FD_CLOSE,
+		    peer_input);
+#else /*][*/
+	    p->ioid = AddInput(p->socket, peer_input);
+#endif /*]*/
+	}
+    } else if (p->ioid != NULL_IOID) {
+	if (!p->eof) {
+	    vctrace(TC_SCRIPT, "s3sock %s has %u requests queued, pausing "
+		    "input\n", p->desc, p->nreqs);
+	}
+	RemoveInput(p->ioid);
+	p->ioid = NULL_IOID;
+    }
+}
+
+/**
+ * Run the next queued request.
  *
  * @param[in,out] p	Peer
  *
- * @return true if command was run and command deleted from the buffer.
+ * @return true if a request was started.
  */
 static bool
 run_next(peer_t *p)
 {
-    size_t cmdlen;
-
-    while (true) {
-	/* Find the first newline in the buffer. */
-	for (cmdlen = p->pj_offset; cmdlen < p->buf_len; cmdlen++) {
-	    if (p->buf[cmdlen] == '\n') {
-		break;
+    while (!llist_isempty(&p->reqs)) {
+	peer_req_t *r = (peer_req_t *)p->reqs.next;
+	const char *text = r->text;
+	size_t len = r->len;
+	bool pushed;
+
+	llist_unlink(&r->llist);
+	p->nreqs--;
+
+	p->running = true;
+	if (vb_len(&p->pj)) {
+	    /* Continuing a multi-line JSON request. */
+	    vb_appends(&p->pj, "\n");
+	    vb_append(&p->pj, text, len);
+	    pushed = do_push(p, vb_buf(&p->pj), vb_len(&p->pj));
+	    if (pushed) {
+		vb_reset(&p->pj);
+	    }
+	} else {
+	    /* Pick off the tag. */
+	    Replace(p->tag, NULL);
+	    if (len > 0 && *text == TAG_PREFIX) {
+		size_t tag_len = 1;
+
+		while (tag_len < len &&
+			!isspace((unsigned char)text[tag_len])) {
+		    tag_len++;
+		}
+		p->tag = Asprintf("%.*s", (int)(tag_len - 1), text + 1);
+		text += tag_len;
+		len -= tag_len;
+	    }
+	    pushed = do_push(p, text, len);
+	    if (!pushed) {
+		/* Partial JSON. */
+		vb_append(&p->pj, text, len);
 	    }
 	}
-	if (cmdlen >= p->buf_len) {
-	    /* No newline. */
-	    return false;
-	}
-
-	/*
-	 * Run the first command.
-	 * cmdlen is the number of characters in the command, not including the
-	 * newline.
-	 */
-	if (do_push(p, p->buf, cmdlen)) {
-	    break;
+	Free(r);
+	if (pushed) {
+	    return true;
 	}
-
-	/* Partial JSON. */
-	p->pj_offset = cmdlen + 1;
+	p->running = false;
     }
-    p->pj_offset = 0;
-
-    /* If there is more, shift it over. */
-    cmdlen++; /* count the newline */
-    if (p->buf_len > cmdlen) {
-	memmove(p->buf, p->buf + cmdlen, p->buf_len - cmdlen);
-	p->buf_len = p->buf_len - cmdlen;
-    } else {
-	Replace(p->buf, NULL);
-	p->buf_len = 0;
-    }
-    return true;
+    return false;
 }
 
 /**
@@ -325,7 +398,8 @@ peer_input(iosrc_t fd _is_unused, ioid_t id)
     char buf[8192];
     size_t n2r;
     ssize_t nr;
-    ssize_t i;
+    const char *s;
+    const char *nl;
 
     /* Find the peer. */
     FOREACH_LLIST(&peer_scripts, p, peer_t *) {
@@ -348,43 +422,81 @@ peer_input(iosrc_t fd _is_unused, ioid_t id)
 #else /*][*/
 	vctrace(TC_SCRIPT, "s3sock %s recv: %s\n", p->desc, strerror(errno));
 #endif /*]*/
-	close_peer(p, NULL);
-	return;
+    } else {
+	vctrace(TC_SCRIPT, "Input for s3sock %s complete, nr=%d\n", p->desc, (int)nr);
     }
-    vctrace(TC_SCRIPT, "Input for s3sock %s complete, nr=%d\n", p->desc, (int)nr);
-    if (nr == 0) {
-	vctrace(TC_SCRIPT, "s3sock %s EOF\n", p->desc);
-	close_peer(p, NULL);
+    if (nr <= 0) {
+	if (nr == 0) {
+	    vctrace(TC_SCRIPT, "s3sock %s EOF\n", p->desc);
+	}
+
+	/* Let the running and queued requests finish first. */
+	p->eof = true;
+	peer_arm(p);
+	if (!p->running && !run_next(p)) {
+	    close_peer(p, NULL);
+	}
 	return;
     }
 
     vctrace(TC_SCRIPT, "s3sock %s got '%s'\n", p->desc, sncatv(buf, nr));
 
-    /* Append, filtering out CRs. */
-    p->buf = Realloc(p->buf, p->buf_len + nr + 1);
-    for (i = 0; i < nr; i++) {
-	char c = buf[i];
+    /* Split it into lines and queue them, removing the CR from CR/LF. */
+    s = buf;
+    while ((nl = memchr(s, '\n', nr - (s - buf))) != NULL) {
+	peer_req_t *r;
+	size_t len;
 
-	if (c != '\r') {
-	    p->buf[p->buf_len++] = c;
+	vb_append(&p->partial, s, nl - s);
+	len = vb_len(&p->partial);
+	if (len > 0 && vb_buf(&p->partial)[len - 1] == '\r') {
+	    len--;
+	}
+	r = (peer_req_t *)Malloc(sizeof(peer_req_t) + len + 1);
+	llist_init(&r->llist);
+	r->text = (char *)(r + 1);
+	if (len > 0) {
+	    memcpy(r->text, vb_buf(&p->partial), len);
 	}
+	r->text[len] = '\0';
+	r->len = len;
+	LLIST_APPEND(&r->llist, p->reqs);
+	p->nreqs++;
+	vb_reset(&p->partial);
+	s = nl + 1;
     }
+    vb_append(&p->partial, s, nr - (s - buf));
 
-    /* Disable further input. */
-    if (p->ioid != NULL_IOID) {
-	RemoveInput(p->ioid);
-	p->ioid = NULL_IOID;
+    /* Run the next command, unless one is already running. */
+    if (!p->running) {
+	run_next(p);
     }
+    peer_arm(p);
+}
 
-    /* Run the next command, if we have it all. */
-    if (!run_next(p) && p->ioid == NULL_IOID) {
-	/* Get more input. */
-#if defined(_WIN32) /*[*/
-	p->ioid = AddInputSocket(p->socket, FD_READ | FD_CLOSE, peer_input);
-#else /*][*/
-	p->ioid = AddInput(p->socket, peer_input);
-#endif /*]*/
+/**
+ * Prefix each line of a response with the tag of the running request.
+ *
+ * @param[in] p		Peer
+ * @param[in] s		Response
+ *
+ * @return Tagged response
+ */
+static const char *
+tag_lines(peer_t *p, const char *s)
+{
+    varbuf_t r;
+    const char *nl;
+
+    if (p->tag == NULL) {
+	return s;
+    }
+    vb_init_tx(&r);
+    while ((nl = strchr(s, '\n')) != NULL) {
+	vb_appendf(&r, "%c%s %.*s\n", TAG_PREFIX, p->tag, (int)(nl - s), s);
+	s = nl + 1;
     }
+    return vb_consume(&r);
 }
 
 /**
@@ -427,7 +539,9 @@ peer_data(task_cbh handle, const char *buf, size_t len, bool success)
 
     s3data(buf, len, success, p->capabilities, p->json_result, NULL, &cooked);
     if (cooked != NULL) {
-	check_send(p, cooked, strlen(cooked), "peer_data");
+	const char *tagged = tag_lines(p, cooked);
+
+	check_send(p, tagged, strlen(tagged), "peer_data");
 	Free(cooked);
     }
 
@@ -447,6 +561,7 @@ peer_reqinput(task_cbh handle, const char *buf, size_t len, bool echo)
 {
     peer_t *p = (peer_t *)handle;
     char *s;
+    const char *tagged;
     static bool recursing = false;
 
     if (recursing) {
@@ -455,7 +570,8 @@ peer_reqinput(task_cbh handle, const char *buf, size_t len, bool echo)
     recursing = true;
 
     s = Asprintf("%s%.*s\n", echo? INPUT_PREFIX: PWINPUT_PREFIX, (int)len, buf);
-    check_send(p, s, strlen(s), "peer_reqinput");
+    tagged = tag_lines(p, s);
+    check_send(p, tagged, strlen(tagged), "peer_reqinput");
     Free(s);
     recursing = false;
 }
@@ -481,17 +597,14 @@ run_next_deferred(ioid_t id)
     assert(found_peer);
 
     vctrace(TC_SCRIPT, "Processing %s next command\n", p->desc);
+    p->toid = NULL_IOID;
 
-    /* Run whatever is pending. If there was nothing to run, allow more input. */
-    bool new_child = run_next(p);
-    if (!new_child && p->ioid == NULL_IOID) {
-	/* Allow more input. */
-#if defined(_WIN32) /*[*/
-	p->ioid = AddInputSocket(p->socket, FD_READ | FD_CLOSE, peer_input);
-#else /*][*/
-	p->ioid = AddInput(p->socket, peer_input);
-#endif /*]*/
+    /* Run whatever is pending. */
+    if (!run_next(p) && p->eof) {
+	close_peer(p, NULL);
+	return;
     }
+    peer_arm(p);
 }
 
 /**
@@ -507,11 +620,16 @@ static bool
 peer_done(task_cbh handle, bool success, bool abort)
 {
     peer_t *p = (peer_t *)handle;
+    bool is_json = p->json_result != NULL;
     char *out;
+    const char *tagged;
 
     s3done(handle, success, &p->json_result, &out);
-    check_send(p, out, strlen(out), "peer_done");
+    tagged = is_json? out: tag_lines(p, out);
+    check_send(p, tagged, strlen(tagged), "peer_done");
     Free(out);
+    p->running = false;
+    Replace(p->tag, NULL);
 
     const char *errmsg = NULL;
     if (abort || !p->enabled || oq_errored(p->oq, &errmsg)) {
@@ -519,19 +637,17 @@ peer_done(task_cbh handle, bool success, bool abort)
 	return true;
     }
 
-    if (p->pj_offset < p->buf_len) {
+    if (!llist_isempty(&p->reqs)) {
 	vctrace(TC_SCRIPT, "Deferring %s next command\n", p->desc);
 	p->toid = AddTimeOut(0, run_next_deferred);
+	peer_arm(p);
 	return false;
+    } else if (p->eof) {
+	close_peer(p, NULL);
+	return true;
     } else {
 	/* Allow more input. */
-	if (p->ioid == NULL_IOID) {
-#if defined(_WIN32) /*[*/
-	    p->ioid = AddInputSocket(p->socket, FD_READ | FD_CLOSE, peer_input);
-#else /*][*/
-	    p->ioid = AddInput(p->socket, peer_input);
-#endif /*]*/
-	}
+	peer_arm(p);
 	return true;
     }
 }
@@ -760,8 +876,9 @@ peer_accepted(socket_t s, void *listener, const char *desc)
 #else /*][*/
     p->ioid = AddInput(p->socket, peer_input);
 #endif /*]*/
-    p->buf = NULL;
-    p->buf_len = 0;
+    llist_init(&p->reqs);
+    vb_init(&p->partial);
+    vb_init(&p->pj);
     p->enabled = true;
     task_cb_init_ir_state(&p->ir_state);
     LLIST_APPEND(&p->llist, peer_scripts);
@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2026 Paul Mattes.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the names of Paul Mattes nor the names of his contributors
+ *       may be used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY PAUL MATTES "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL PAUL MATTES BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+ *      profile.c
+ *              Per-subsystem allocation and CPU profiling.
+ */
+
+#include "globals.h"
+
+#if !defined(_WIN32) /*[*/
+# include <time.h>
+#endif /*]*/
+
+#include "appres.h"
+#include "boolstr.h"
+#include "names.h"
+#include "popups.h"
+#include "query.h"
+#include "resources.h"
+#include "toggles.h"
+#include "txa.h"
+#include "utils.h"
+#include "varbuf.h"
+
+#include "profile.h"
+
+/* Category names. */
+static const char *prof_names[NUM_PC] = {
+    "other", "ctlr", "screen", "tasks", "io", "json", "ui", "trace"
+};
+
+/* Per-category counters. */
+static struct {
+    unsigned long allocs;	/* allocations */
+    unsigned long long bytes;	/* bytes allocated */
+    unsigned long long cpu_usec; /* CPU time, in microseconds */
+} prof[NUM_PC];
+
+static bool active = false;	/* true if counting */
+static prof_cat_t current = PC_OTHER; /* category being charged */
+static unsigned long long last_usec; /* CPU time at the last switch */
+
+/* Get the CPU time used by this thread, in microseconds. */
+static unsigned long long
+cpu_usec(void)
+{
+#if !defined(_WIN32) /*[*/
+    struct timespec ts;
+
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) < 0) {
+	return 0;
+    }
+    return (unsigned long long)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+#else /*][*/
+    FILETIME create, exit, kernel, user;
+    ULARGE_INTEGER k, u;
+
+    if (!GetThreadTimes(GetCurrentThread(), &create, &exit, &kernel, &user)) {
+	return 0;
+    }
+    k.LowPart = kernel.dwLowDateTime;
+    k.HighPart = kernel.dwHighDateTime;
+    u.LowPart = user.dwLowDateTime;
+    u.HighPart = user.dwHighDateTime;
+    return (k.QuadPart + u.QuadPart) / 10ULL;
+#endif /*]*/
+}
+
+/* Charge an allocation to the current category. */
+static void
+prof_alloc(size_t len)
+{
+    prof[current].allocs++;
+    prof[current].bytes += len;
+}
+
+/* Start counting. */
+static void
+prof_start(void)
+{
+    memset(prof, 0, sizeof(prof));
+    current = PC_OTHER;
+    last_usec = cpu_usec();
+    alloc_hook = prof_alloc;
+    active = true;
+}
+
+/* Stop counting. */
+static void
+prof_stop(void)
+{
+    if (active) {
+	prof[current].cpu_usec += cpu_usec() - last_usec;
+	alloc_hook = NULL;
+	current = PC_OTHER;
+	active = false;
+    }
+}
+
+/**
+ * Switch to a new profiling category.
+ * Normally called through prof_enter() and prof_leave().
+ *
+ * @param[in] cat	New category
+ *
+ * @return Previous category
+ */
+prof_cat_t
+prof_switch(prof_cat_t cat)
+{
+    prof_cat_t prev = current;
+    unsigned long long now;
+
+    if (!active) {
+	/* Turned on from the command line. */
+	prof_start();
+	prev = current;
+    }
+    now = cpu_usec();
+    prof[current].cpu_usec += now - last_usec;
+    last_usec = now;
+    current = cat;
+    return prev;
+}
+
+/**
+ * Get the name of a profiling category.
+ *
+ * @param[in] cat	Category
+ *
+ * @return Name
+ */
+const char *
+prof_name(prof_cat_t cat)
+{
+    return prof_names[cat];
+}
+
+/**
+ * Get the counters for a profiling category.
+ *
+ * @param[in] cat	Category
+ * @param[out] allocs	Number of allocations
+ * @param[out] bytes	Bytes allocated
+ * @param[out] cpu_usec	CPU time, in microseconds
+ */
+void
+prof_get(prof_cat_t cat, unsigned long *allocs, unsigned long long *bytes,
+	unsigned long long *cpu_usec)
+{
+    if (active && cat == current) {
+	(void) prof_switch(current);
+    }
+    *allocs = prof[cat].allocs;
+    *bytes = prof[cat].bytes;
+    *cpu_usec = prof[cat].cpu_usec;
+}
+
+/* Toggle profiling. */
+static toggle_upcall_ret_t
+toggle_profile(const char *name _is_unused, const char *value,
+	unsigned flags _is_unused, ia_t ia _is_unused)
+{
+    bool b;
+    const char *errmsg = boolstr(value, &b);
+
+    if (errmsg != NULL) {
+	popup_an_error("'%s': %s", value, errmsg);
+	return TU_FAILURE;
+    }
+    if (b && !appres.profile) {
+	prof_start();
+    } else if (!b) {
+	prof_stop();
+    }
+    appres.profile = b;
+    return TU_SUCCESS;
+}
+
+/* Query the profile. */
+static const char *
+prof_dump(void)
+{
+    varbuf_t r;
+    int i;
+
+    if (!appres.profile) {
+	return "profiling disabled";
+    }
+
+    vb_init_tx(&r);
+    vb_appends(&r, "profiling enabled");
+    for (i = 0; i < NUM_PC; i++) {
+	unsigned long allocs;
+	unsigned long long bytes, usec;
+
+	prof_get(i, &allocs, &bytes, &usec);
+	vb_appendf(&r, "\n%s allocations %lu bytes %llu cpu-ms %llu",
+		prof_names[i], allocs, bytes, usec / 1000);
+    }
+    return vb_consume(&r);
+}
+
+/**
+ * Register our toggle and query.
+ */
+void
+profile_register(void)
+{
+    static query_t queries[] = {
+	{ KwProfile, prof_dump, NULL, QF_MULTILINE },
+    };
+
+    register_extended_toggle(ResProfile, toggle_profile, NULL, NULL,
+	    (void **)&appres.profile, XRM_BOOLEAN);
+    register_queries(queries, array_count(queries));
+}
@@ -51,7 +51,7 @@ proxy_dump(void)
     varbuf_t r;
     proxytype_t type;
 
-    vb_init(&r);
+    vb_init_tx(&r);
     for (type = PT_FIRST; type < PT_MAX; type++) {
 	int port = proxy_default_port(type);
 
@@ -62,7 +62,7 @@ proxy_dump(void)
 		(type < PT_MAX - 1)? "\n": "");
     }
 
-    return txdFree(vb_consume(&r));
+    return vb_consume(&r);
 }
 
 /*
@@ -129,7 +129,7 @@ get_codepages(void)
     int i, j;
     char *sep = "";
 
-    vb_init(&r);
+    vb_init_tx(&r);
     for (i = 0; c[i].name != NULL; i++) {
 	vb_appendf(&r, "%s%s %cbcs", sep, c[i].name, c[i].dbcs? 'd': 's');
 	sep = "\n";
@@ -139,7 +139,7 @@ get_codepages(void)
     }
 
     free_cpnames(c);
-    return txdFree(vb_consume(&r));
+    return vb_consume(&r);
 }
 
 static const char *
@@ -170,12 +170,12 @@ get_reply_mode(void)
     case SF_SRM_XFIELD:
 	return "extended-field";
     case SF_SRM_CHAR:
-	vb_init(&r);
+	vb_init_tx(&r);
 	vb_appends(&r, "character");
 	for (i = 0; i < crm_nattr; i++) {
 	    vb_appendf(&r, " +%s", see_efa_only(crm_attr[i]));
 	}
-	return txdFree(vb_consume(&r));
+	return vb_consume(&r);
     default:
 	return txAsprintf("0x%02x", reply_mode);
     }
@@ -230,9 +230,10 @@ get_tx(void)
 	return NULL;
     }
 
-    return IN_3270?
-	txAsprintf("records %u bytes %u", ns_rsent, ns_bsent):
-	txAsprintf("bytes %u", ns_bsent);
+    return txAsprintf("%s%s", IN_3270?
+	    txAsprintf("records %u bytes %u", ns_rsent, ns_bsent):
+	    txAsprintf("bytes %u", ns_bsent),
+	ns_bqueued? txAsprintf(" queued %zu", ns_bqueued): "");
 }
 
 const char *
@@ -382,11 +383,11 @@ query_all(void)
     varbuf_t r;
     const char *ret;
 
-    vb_init(&r);
+    vb_init_tx(&r);
     for (i = 0; strings[i] != NULL; i++) {
 	vb_appendf(&r, "%s%s", i? "\n": "", strings[i]);
     }
-    ret = txdFree(vb_consume(&r));
+    ret = vb_consume(&r);
     free_query_all(strings);
     return ret;
 }
@@ -439,7 +440,7 @@ query_common(const char *name, ia_t ia, unsigned argc, const char **argv)
 	    varbuf_t r;
 	    size_t sl = strlen(argv[0]);
 
-	    vb_init(&r);
+	    vb_init_tx(&r);
 
 	    /* Look for an inexact match. */
 	    for (i = 0; i < num_queries; i++) {
@@ -451,7 +452,7 @@ query_common(const char *name, ia_t ia, unsigned argc, const char **argv)
 	    }
 
 	    if (matches > 1) {
-		popup_an_error("%s(): Ambiguous parameter '%s': %s", name, argv[0], txdFree(vb_consume(&r)));
+		popup_an_error("%s(): Ambiguous parameter '%s': %s", name, argv[0], vb_consume(&r));
 		return false;
 	    }
 
@@ -510,11 +511,11 @@ get_special_characters(void)
     struct ctl_char *c = linemode_chars();
     int i;
 
-    vb_init(&r);
+    vb_init_tx(&r);
     for (i = 0; c[i].name; i++) {
 	vb_appendf(&r, "%s%s %s", i? " ": "", c[i].name, c[i].value);
     }
-    return txdFree(vb_consume(&r));
+    return vb_consume(&r);
 }
 
 /* Get the command line. */
@@ -597,6 +598,7 @@ query_register(void)
 	{ KwTraceFile, get_tracefile, NULL, 0 },
 	{ KwTls, net_query_tls, NULL, QF_TRACEHDR },
 	{ KwTlsCertInfo, net_server_cert_info, NULL, QF_MULTILINE },
+	{ KwTlsHandshakes, net_query_tls_handshakes, NULL, QF_HIDDEN },
 	{ KwTlsSubjectNames, net_server_subject_names, NULL, QF_MULTILINE },
 	{ KwTlsProvider, net_sio_provider, NULL, QF_TRACEHDR },
 	{ KwTlsSessionInfo, net_session_info, NULL, QF_MULTILINE | QF_TRACEHDR },
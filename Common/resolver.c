@@ -45,8 +45,10 @@
 #include "gai_strerror.h"
 #include "resolver.h"
 #include "mock_resolver.h"
+#include "sockaddr_46.h"
 #include "txa.h"
 #include "utils.h"
+#include "varbuf.h"
 #if defined(_WIN32) /*[*/
 # include "w3misc.h"
 # include "winvers.h"
@@ -65,6 +67,7 @@ static struct gai {
     int pipe;			/* pipe to write status into */
     char *host;			/* host name */
     char *port;			/* port name */
+    int pf;			/* protocol family */
 # if !defined(_WIN32) /*[*/
     struct gaicb gaicb;		/* control block */
     struct gaicb *gaicbs;	/* control blocks (just one) */
@@ -108,6 +111,236 @@ want_pf(void)
     }
 }
 
+/*
+ * Resolver cache.
+ *
+ * Successful lookups are remembered for rc_ttl seconds and failed ones for
+ * rc_neg_ttl seconds, so a burst of connects or reconnects to the same host
+ * does not turn into a burst of DNS queries. A TTL of 0 turns off caching
+ * for that kind of result.
+ */
+#define RC_SIZE		32	/* maximum number of entries */
+#define RC_MAX_HA	8	/* maximum number of addresses per entry */
+#define RC_TTL		60	/* default seconds to keep a successful lookup */
+#define RC_NEG_TTL	10	/* default seconds to keep a failed lookup */
+static int rc_ttl = RC_TTL;
+static int rc_neg_ttl = RC_NEG_TTL;
+typedef struct {
+    char *host;			/* host name, NULL if slot is empty */
+    char *port;			/* port name, or NULL */
+    int pf;			/* protocol family */
+    time_t expires;		/* expiration time */
+    unsigned long hits;		/* number of times used */
+    rhp_t rv;			/* result */
+    char *errmsg;		/* error message, if failed */
+    unsigned short pport;	/* resolved port */
+    int nr;			/* number of addresses */
+    bool complete;		/* true if nr is all of the addresses */
+    sockaddr_46_t sa[RC_MAX_HA]; /* addresses */
+    socklen_t sa_rlen[RC_MAX_HA]; /* address lengths */
+} rc_entry_t;
+static rc_entry_t rc[RC_SIZE];
+static unsigned long rc_hits, rc_misses;
+
+/* Compare a possibly-NULL port name. */
+static bool
+rc_port_eq(const char *a, const char *b)
+{
+    return (a == NULL && b == NULL) || (a != NULL && b != NULL && !strcmp(a, b));
+}
+
+/* Empty a cache entry. */
+static void
+rc_clear(rc_entry_t *e)
+{
+    Replace(e->host, NULL);
+    Replace(e->port, NULL);
+    Replace(e->errmsg, NULL);
+}
+
+/*
+ * Look up a name in the resolver cache.
+ * Returns true if found, with the results filled in.
+ */
+static bool
+rc_lookup(const char *host, const char *portname, int pf,
+	unsigned short *pport, struct sockaddr *sa, size_t sa_len,
+	socklen_t *sa_rlen, const char **errmsg, int max, int *nr, rhp_t *rv)
+{
+    time_t now = time(NULL);
+    int i;
+
+    if (rc_ttl == 0 && rc_neg_ttl == 0) {
+	/* Cache is disabled. */
+	return false;
+    }
+
+    for (i = 0; i < RC_SIZE; i++) {
+	rc_entry_t *e = &rc[i];
+	int j;
+
+	if (e->host == NULL) {
+	    continue;
+	}
+	if (e->expires <= now) {
+	    rc_clear(e);
+	    continue;
+	}
+	if (e->pf != pf || strcmp(e->host, host) ||
+		!rc_port_eq(e->port, portname)) {
+	    continue;
+	}
+	if (!RHP_IS_ERROR(e->rv) && !e->complete && e->nr < max) {
+	    /* Not enough addresses saved. */
+	    break;
+	}
+
+	/* Found it. */
+	e->hits++;
+	rc_hits++;
+	*rv = e->rv;
+	*nr = 0;
+	if (RHP_IS_ERROR(e->rv)) {
+	    if (errmsg != NULL) {
+		*errmsg = txAsprintf("%s", e->errmsg);
+	    }
+	    return true;
+	}
+	*pport = e->pport;
+	for (j = 0; j < e->nr && j < max; j++) {
+	    memcpy((char *)sa + (j * sa_len), &e->sa[j], e->sa_rlen[j]);
+	    sa_rlen[j] = e->sa_rlen[j];
+	}
+	*nr = j;
+	return true;
+    }
+    rc_misses++;
+    return false;
+}
+
+/* Add a result to the resolver cache. */
+static void
+rc_add(const char *host, const char *portname, int pf, rhp_t rv,
+	const char *errmsg, unsigned short *pport, struct sockaddr *sa,
+	size_t sa_len, socklen_t *sa_rlen, int max, int nr)
+{
+    rc_entry_t *e = NULL;
+    time_t now = time(NULL);
+    int i;
+
+    /* Internal errors are not worth remembering. */
+    if (rv != RHP_SUCCESS && rv != RHP_CANNOT_RESOLVE) {
+	return;
+    }
+
+    /* Neither are results whose TTL is 0. */
+    if ((rv == RHP_SUCCESS)? (rc_ttl == 0): (rc_neg_ttl == 0)) {
+	return;
+    }
+
+    /*
+     * Replace an existing entry for the same name, or else an empty one, or
+     * else the one that expires soonest.
+     */
+    for (i = 0; i < RC_SIZE; i++) {
+	rc_entry_t *f = &rc[i];
+
+	if (f->host != NULL && f->pf == pf && !strcmp(f->host, host) &&
+		rc_port_eq(f->port, portname)) {
+	    e = f;
+	    break;
+	}
+	if (e == NULL || (e->host != NULL &&
+		    (f->host == NULL || f->expires < e->expires))) {
+	    e = f;
+	}
+    }
+    rc_clear(e);
+
+    e->host = NewString(host);
+    e->port = portname? NewString(portname): NULL;
+    e->pf = pf;
+    e->rv = rv;
+    e->hits = 0;
+    if (rv == RHP_SUCCESS) {
+	e->expires = now + rc_ttl;
+	e->pport = *pport;
+	for (i = 0; i < nr && i < RC_MAX_HA; i++) {
+	    memcpy(&e->sa[i], (char *)sa + (i * sa_len), sa_rlen[i]);
+	    e->sa_rlen[i] = sa_rlen[i];
+	}
+	e->nr = i;
+	e->complete = nr < max && nr <= RC_MAX_HA;
+    } else {
+	e->expires = now + rc_neg_ttl;
+	e->errmsg = NewString(errmsg? errmsg: "Cannot resolve");
+	e->nr = 0;
+	e->complete = true;
+    }
+}
+
+/**
+ * Set the resolver cache TTLs.
+ *
+ * @param[in] ttl	Seconds to keep a successful lookup, 0 to not cache them
+ * @param[in] neg_ttl	Seconds to keep a failed lookup, 0 to not cache them
+ */
+void
+set_resolver_cache_ttl(int ttl, int neg_ttl)
+{
+    rc_ttl = (ttl > 0)? ttl: 0;
+    rc_neg_ttl = (neg_ttl > 0)? neg_ttl: 0;
+    resolver_cache_flush();
+}
+
+/**
+ * Flush the resolver cache.
+ */
+void
+resolver_cache_flush(void)
+{
+    int i;
+
+    for (i = 0; i < RC_SIZE; i++) {
+	rc_clear(&rc[i]);
+    }
+}
+
+/**
+ * Dump the resolver cache.
+ *
+ * @returns Text describing the cache contents, one line per entry
+ */
+const char *
+resolver_cache_dump(void)
+{
+    time_t now = time(NULL);
+    varbuf_t r;
+    int i;
+
+    vb_init_tx(&r);
+    vb_appendf(&r, "hits %lu misses %lu ttl %d negative-ttl %d", rc_hits,
+	    rc_misses, rc_ttl, rc_neg_ttl);
+    for (i = 0; i < RC_SIZE; i++) {
+	rc_entry_t *e = &rc[i];
+
+	if (e->host == NULL || e->expires <= now) {
+	    continue;
+	}
+	vb_appendf(&r, "\n%s/%s %s", e->host, e->port? e->port: "(none)",
+		(e->pf == PF_INET)? "ipv4":
+		    ((e->pf == PF_INET6)? "ipv6": "any"));
+	if (RHP_IS_ERROR(e->rv)) {
+	    vb_appends(&r, " failed");
+	} else {
+	    vb_appendf(&r, " addresses %d", e->nr);
+	}
+	vb_appendf(&r, " expires %ds hits %lu", (int)(e->expires - now),
+		e->hits);
+    }
+    return vb_consume(&r);
+}
+
 /* Local version of xscatv. */
 static char *lscatv(const char *s)
 {
@@ -265,7 +498,7 @@ async_resolve(LPVOID parameter)
     gaip->done = true;
     memset(&hints, '\0', sizeof(struct addrinfo));
     hints.ai_flags = 0;
-    hints.ai_family = want_pf();
+    hints.ai_family = gaip->pf;
     hints.ai_socktype = SOCK_STREAM;
     hints.ai_protocol = IPPROTO_TCP;
     gaip->rc = getaddrinfo(gaip->host, gaip->port, &hints, &gaip->result);
@@ -317,6 +550,7 @@ resolve_host_and_port_internal_async(const char *host, const char *portname, int
 	int pipe, iosrc_t event)
 {
     static bool initted = false;
+    rhp_t rv;
 # if !defined(_WIN32) /*[*/
     int rc;
 # else /*][*/
@@ -328,6 +562,13 @@ resolve_host_and_port_internal_async(const char *host, const char *portname, int
 		max, nr, slot, pipe, event);
     }
 
+    /* Check the cache. */
+    if (rc_lookup(host, portname, (pf != PF_UNSPEC)? pf: want_pf(), pport,
+		sa, sa_len, sa_rlen, errmsg, max, nr, &rv)) {
+	*slot = -1;
+	return rv;
+    }
+
     if (!initted) {
 	int i;
 	for (i = 0; i < GAI_SLOTS; i++) {
@@ -381,10 +622,11 @@ resolve_host_and_port_internal_async(const char *host, const char *portname, int
 
     gai[*slot].host = NewString(host);
     gai[*slot].port = portname? NewString(portname) : NULL;
+    gai[*slot].pf = (pf != PF_UNSPEC)? pf: want_pf();
 
 # if !defined(_WIN32) /*[*/
     gai[*slot].hints.ai_flags = AI_ADDRCONFIG;
-    gai[*slot].hints.ai_family = (pf != PF_UNSPEC)? pf: want_pf();
+    gai[*slot].hints.ai_family = gai[*slot].pf;
     gai[*slot].hints.ai_socktype = SOCK_STREAM;
     gai[*slot].hints.ai_protocol = IPPROTO_TCP;
 
@@ -434,8 +676,8 @@ resolve_host_and_port_internal_async(const char *host, const char *portname, int
 #endif /*]*/
 
 /* Collect the status for a slot. */
-rhp_t
-collect_host_and_port(int slot, struct sockaddr *sa, size_t sa_len,
+static rhp_t
+collect_host_and_port_internal(int slot, struct sockaddr *sa, size_t sa_len,
 	socklen_t *sa_rlen, unsigned short *pport, const char **errmsg, int max,
 	int *nr)
 {
@@ -448,10 +690,6 @@ collect_host_and_port(int slot, struct sockaddr *sa, size_t sa_len,
     void *rsa = sa;
     struct gai *gaip;
 
-    if (slot >= GAI_SLOTS) {
-	return mock_collect_host_and_port(slot, sa, sa_len, sa_rlen, pport, errmsg, max, nr);
-    }
-
     gaip = &gai[slot];
     assert(gaip->busy == true);
     assert(gaip->done == true);
@@ -488,8 +726,8 @@ collect_host_and_port(int slot, struct sockaddr *sa, size_t sa_len,
 	    gaip->gaicb.ar_result = NULL;
 	}
 	if (*nr) {
-	    Replace(gai->host, NULL);
-	    Replace(gai->port, NULL);
+	    Replace(gaip->host, NULL);
+	    Replace(gaip->port, NULL);
 	    return RHP_SUCCESS;
 	} else {
 	    if (errmsg) {
@@ -500,8 +738,8 @@ collect_host_and_port(int slot, struct sockaddr *sa, size_t sa_len,
 		Free(sh);
 		Free(sp);
 	    }
-	    Replace(gai->host, NULL);
-	    Replace(gai->port, NULL);
+	    Replace(gaip->host, NULL);
+	    Replace(gaip->port, NULL);
 	    return RHP_CANNOT_RESOLVE;
 	}
     case EAI_INPROGRESS:	/* still pending, should not happen */
@@ -511,8 +749,8 @@ collect_host_and_port(int slot, struct sockaddr *sa, size_t sa_len,
 	    freeaddrinfo(gaip->gaicb.ar_result);
 	    gaip->gaicb.ar_result = NULL;
 	}
-	Replace(gai->host, NULL);
-	Replace(gai->port, NULL);
+	Replace(gaip->host, NULL);
+	Replace(gaip->port, NULL);
 	return RHP_FATAL;
     default:			/* failure */
 	if (gaip->gaicb.ar_result != NULL) {
@@ -527,8 +765,8 @@ collect_host_and_port(int slot, struct sockaddr *sa, size_t sa_len,
 	    Free(sh);
 	    Free(sp);
 	}
-	Replace(gai->host, NULL);
-	Replace(gai->port, NULL);
+	Replace(gaip->host, NULL);
+	Replace(gaip->port, NULL);
 	return RHP_CANNOT_RESOLVE;
     }
 
@@ -543,8 +781,8 @@ collect_host_and_port(int slot, struct sockaddr *sa, size_t sa_len,
 	    Free(sh);
 	    Free(sp);
 	}
-	Replace(gai->host, NULL);
-	Replace(gai->port, NULL);
+	Replace(gaip->host, NULL);
+	Replace(gaip->port, NULL);
 	return RHP_CANNOT_RESOLVE;
     }
 
@@ -572,8 +810,8 @@ collect_host_and_port(int slot, struct sockaddr *sa, size_t sa_len,
 		    Free(sh);
 		}
 		freeaddrinfo(gaip->result);
-		Replace(gai->host, NULL);
-		Replace(gai->port, NULL);
+		Replace(gaip->host, NULL);
+		Replace(gaip->port, NULL);
 		return RHP_FATAL;
 	    }
 	}
@@ -583,8 +821,8 @@ collect_host_and_port(int slot, struct sockaddr *sa, size_t sa_len,
     }
 
     freeaddrinfo(gaip->result);
-    Replace(gai->host, NULL);
-    Replace(gai->port, NULL);
+    Replace(gaip->host, NULL);
+    Replace(gaip->port, NULL);
     return RHP_SUCCESS;
 # endif /*]*/
 #else /*][*/
@@ -596,6 +834,41 @@ collect_host_and_port(int slot, struct sockaddr *sa, size_t sa_len,
 #endif /*]*/
 }
 
+/* Collect the status for a slot, and remember it in the cache. */
+rhp_t
+collect_host_and_port(int slot, struct sockaddr *sa, size_t sa_len,
+	socklen_t *sa_rlen, unsigned short *pport, const char **errmsg, int max,
+	int *nr)
+{
+#if defined(ASYNC_RESOLVER) /*[*/
+    char *host, *port;
+    int pf;
+    const char *emsg = NULL;
+    rhp_t rv;
+
+    if (slot >= GAI_SLOTS) {
+	return mock_collect_host_and_port(slot, sa, sa_len, sa_rlen, pport,
+		errmsg, max, nr);
+    }
+
+    host = NewString(gai[slot].host);
+    port = gai[slot].port? NewString(gai[slot].port): NULL;
+    pf = gai[slot].pf;
+    rv = collect_host_and_port_internal(slot, sa, sa_len, sa_rlen, pport,
+	    &emsg, max, nr);
+    rc_add(host, port, pf, rv, emsg, pport, sa, sa_len, sa_rlen, max, *nr);
+    Free(host);
+    Free(port);
+    if (errmsg != NULL) {
+	*errmsg = emsg;
+    }
+    return rv;
+#else /*][*/
+    return collect_host_and_port_internal(slot, sa, sa_len, sa_rlen, pport,
+	    errmsg, max, nr);
+#endif /*]*/
+}
+
 /* Clean up a canceled request. */
 void
 cleanup_host_and_port(int slot)
@@ -642,6 +915,33 @@ cleanup_host_and_port(int slot)
 #endif /*]*/
 }
 
+/*
+ * Resolve a hostname and port, using the cache.
+ * Synchronous version.
+ */
+static rhp_t
+resolve_host_and_port_cached(const char *host, const char *portname, int pf,
+	unsigned short *pport, struct sockaddr *sa, size_t sa_len,
+	socklen_t *sa_rlen, const char **errmsg, int max, int *nr)
+{
+    int cpf = (pf != PF_UNSPEC)? pf: want_pf();
+    const char *emsg = NULL;
+    rhp_t rv;
+
+    if (rc_lookup(host, portname, cpf, pport, sa, sa_len, sa_rlen, errmsg,
+		max, nr, &rv)) {
+	return rv;
+    }
+    rv = resolve_host_and_port_internal_blocking(host, portname, pf,
+	    RHPF_ALLOW_DELAY, pport, sa, sa_len, sa_rlen, &emsg, max, nr);
+    rc_add(host, portname, cpf, rv, emsg, pport, sa, sa_len, sa_rlen, max,
+	    *nr);
+    if (errmsg != NULL) {
+	*errmsg = emsg;
+    }
+    return rv;
+}
+
 /**
  * Mock the behavior of the synchronous resolver.
  *
@@ -738,7 +1038,7 @@ resolve_host_and_port_blocking(const char *host, const char *portname, int pf, u
 	return mock_sync_resolver(m, host, portname, pport, sa, sa_len,
 		sa_rlen, errmsg, max, nr);
     }
-    return resolve_host_and_port_internal_blocking(host, portname, pf, RHPF_ALLOW_DELAY, pport, sa, sa_len,
+    return resolve_host_and_port_cached(host, portname, pf, pport, sa, sa_len,
 	    sa_rlen, errmsg, max, nr);
 }
 
@@ -774,6 +1074,6 @@ resolve_host_and_port_async(const char *host, const char *portname, int pf, unsi
     }
 #endif /*]*/
     *slot = -1;
-    return resolve_host_and_port_internal_blocking(host, portname, pf, RHPF_ALLOW_DELAY, pport, sa, sa_len,
+    return resolve_host_and_port_cached(host, portname, pf, pport, sa, sa_len,
 	    sa_rlen, errmsg, max, nr);
 }
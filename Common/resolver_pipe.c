@@ -38,6 +38,7 @@
 # include <netinet/in.h>
 #endif /*]*/
 
+#include "actions.h"
 #include "names.h"
 #include "popups.h"
 #include "query.h"
@@ -407,14 +408,34 @@ resolver_dump(void)
 	    n_complete? display_us(max_us): "-");
 }
 
+/* Flush the resolver cache. */
+static bool
+FlushResolverCache_action(ia_t ia, unsigned argc, const char **argv)
+{
+    action_debug(AnFlushResolverCache, ia, argc, argv);
+    if (check_argc(AnFlushResolverCache, argc, 0, 0) < 0) {
+	return false;
+    }
+    vctrace(TC_DNS, "Flushing resolver cache\n");
+    resolver_cache_flush();
+    return true;
+}
+
 /* Module registration. */
 void
 resolver_pipe_register(void)
 {
     static query_t queries[] = {
         { KwResolver, resolver_dump, NULL, QF_HIDDEN | QF_TRACEHDR },
+        { KwResolverCache, resolver_cache_dump, NULL, QF_HIDDEN | QF_MULTILINE },
+    };
+    static action_table_t actions[] = {
+	{ AnFlushResolverCache, FlushResolverCache_action, 0 },
     };
 
     /* Register our queries. */
     register_queries(queries, array_count(queries));
+
+    /* Register our actions. */
+    register_actions(actions, array_count(actions));
 }
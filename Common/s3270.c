@@ -62,6 +62,7 @@
 #include "kybd.h"
 #include "login_macro.h"
 #include "min_version.h"
+#include "metrics.h"
 #include "model.h"
 #include "names.h"
 #include "nvt.h"
@@ -73,12 +74,14 @@
 #include "prefer.h"
 #include "print_screen.h"
 #include "product.h"
+#include "profile.h"
 #include "proxy_toggle.h"
 #include "query.h"
 #include "resolver_pipe.h"
 #include "rpq.h"
 #include "save_restore.h"
 #include "screen.h"
+#include "screen_text.h"
 #include "selectc.h"
 #include "sio_glue.h"
 #include "task.h"
@@ -264,6 +267,9 @@ main(int argc, char *argv[])
 #endif /*]*/
     resolver_pipe_register();
     oq_register();
+    metrics_register();
+    profile_register();
+    screen_text_register();
 
     argc = parse_command_line(argc, (const char **)argv, &cl_hostname);
 
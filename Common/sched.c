@@ -38,6 +38,7 @@
 #endif /*]*/
 #include "glue.h"
 #include "appres.h"
+#include "profile.h"
 #include "task.h"
 #include "timeouts.h"
 #include "trace.h"
@@ -855,6 +856,7 @@ process_some_events(bool block, bool *processed_any)
     bool any_events_pending;
     int i;
     const char *tmo_str;
+    prof_cat_t prev;
     char tmo_buf[256];
 
 #if defined(_WIN32) /*[*/
@@ -1084,7 +1086,9 @@ process_some_events(bool block, bool *processed_any)
 		(ip->condition == WantWrite  && WRITE_READY(i, ip)) ||
 		(ip->condition == WantExcept && EXCEPT_READY(i, ip))) {
 		vcdtrace(TC_SCHED, "Running 0x%lx\n", (unsigned long)(size_t)ip->source);
+		prev = prof_enter(PC_IO);
 		(*ip->proc)(ip->source, (ioid_t)ip);
+		prof_leave(prev);
 #if defined(WIN32_HEAP_CHECK) /*[*/
 		assert(_heapchk() == _HEAPOK);
 #endif /*]*/
@@ -0,0 +1,611 @@
+/*
+ * Copyright (c) 2026 Paul Mattes.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the names of Paul Mattes nor the names of his contributors
+ *       may be used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY PAUL MATTES "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL PAUL MATTES BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+ *      screen_text.c
+ *              Incrementally maintained text mirror of the screen.
+ *
+ * Screen-scraping actions like Ascii() and Wait(StringAt) used to convert
+ * every cell they looked at from EBCDIC or NVT Unicode to multibyte text,
+ * every time. This module keeps the converted text for each row, along with
+ * a copy of the cells it was converted from. A read compares each row with
+ * its copy and converts only the rows that changed, so reading an unchanged
+ * screen is just a memcmp of the buffer and a copy of the text.
+ *
+ * Rows are validated by comparison rather than by hooking every writer of
+ * ea_buf, because ea_buf is modified in several places outside of ctlr.c.
+ *
+ * The mirror also backs screen searches.
+ */
+
+#include "globals.h"
+
+#if !defined(_WIN32) /*[*/
+# include <regex.h>
+#endif /*]*/
+
+#include "3270ds.h"
+#include "ctlr.h"
+#include "toggles.h"
+
+#include "ctlrc.h"
+#include "names.h"
+#include "nvt.h"
+#include "popups.h"
+#include "screen_text.h"
+#include "toupper.h"
+#include "txa.h"
+#include "unicodec.h"
+#include "utils.h"
+#include "varbuf.h"
+
+#define MB_MAX	16	/* maximum bytes for one cell */
+
+/* One row of the mirror. */
+typedef struct {
+    varbuf_t text;	/* converted text */
+    size_t *offset;	/* byte offset of each cell in text, plus the end */
+    unsigned char fa;	/* field attribute in effect at the start of the row */
+    unsigned char fa_cs; /* field character set at the start of the row */
+    unsigned char next_ec; /* EBCDIC code of the cell after the row */
+    bool valid;		/* true if text is current */
+} mirror_row_t;
+
+/* A mirror of the whole screen, for one encoding. */
+typedef struct {
+    int rows, cols;	/* dimensions */
+    bool monocase;	/* monocase setting */
+    struct ea *snap;	/* copy of the cells the text was converted from */
+    mirror_row_t *row;	/* rows */
+} mirror_t;
+
+/* Mirrors, indexed by force_utf8. */
+static mirror_t mirror[2];
+
+/* A parsed screen search. */
+struct screen_search {
+    char *pattern;	/* pattern */
+    size_t pattern_len;	/* length of pattern */
+    bool force_utf8;	/* true if pattern is UTF-8 */
+    enum {
+	SF_ANY,		/* any field */
+	SF_PROTECTED,	/* protected fields only */
+	SF_UNPROTECTED	/* unprotected fields only */
+    } fields;
+    int row, col;	/* region origin */
+    int rows, cols;	/* region size, or 0 for the whole screen */
+#if !defined(_WIN32) /*[*/
+    bool is_regex;	/* true if pattern is a regular expression */
+    regex_t regex;	/* compiled regular expression */
+#endif /*]*/
+};
+
+/**
+ * Convert one screen cell to multibyte text.
+ *
+ * @param[in] buf	Screen buffer
+ * @param[in] baddr	Buffer address
+ * @param[in,out] is_zero True if the current field is non-display, updated
+ *			if baddr is a field attribute
+ * @param[in,out] fa_cs	Character set of the current field, updated if baddr
+ *			is a field attribute
+ * @param[in] force_utf8 true to force UTF-8 output
+ * @param[out] mb	Returned text
+ * @param[in] mb_len	Size of mb
+ *
+ * @return Number of bytes in mb. The right half of a DBCS character
+ * returns 0.
+ */
+size_t
+screen_text_cell(struct ea *buf, int baddr, bool *is_zero, int *fa_cs,
+	bool force_utf8, char *mb, size_t mb_len)
+{
+    ucs4_t uc;
+    size_t xlen;
+    enum dbcs_state d = ctlr_dbcs_state(baddr);
+
+    if (buf[baddr].fa) {
+	*fa_cs = buf[baddr].cs;
+	*is_zero = FA_IS_ZERO(buf[baddr].fa);
+	mb[0] = ' ';
+	return 1;
+    }
+    if (*is_zero) {
+	mb[0] = ' ';
+	return 1;
+    }
+    if (IS_RIGHT(d)) {
+	if (d == DBCS_RIGHT_WRAP) {
+	    mb[0] = ' ';
+	    return 1;
+	}
+	return 0;
+    }
+
+    if (is_nvt(&buf[baddr], false, &uc)) {
+	/* NVT-mode text. */
+	if (uc >= UPRIV2_Aunderbar && uc <= UPRIV2_Zunderbar) {
+	    uc -= UPRIV2;
+	}
+	if (toggled(MONOCASE)) {
+	    uc = u_toupper(uc);
+	}
+	xlen = unicode_to_multibyte_f(uc, mb, mb_len, force_utf8);
+    } else if (IS_LEFT(d)) {
+	/* 3270-mode DBCS text. */
+	xlen = ebcdic_to_multibyte_f((buf[baddr].ec << 8) |
+		buf[baddr + 1].ec, mb, mb_len, force_utf8);
+    } else {
+	/* 3270-mode text. */
+	xlen = ebcdic_to_multibyte_fx(buf[baddr].ec,
+		*fa_cs? *fa_cs: buf[baddr].cs, mb, mb_len,
+		EUO_BLANK_UNDEF | (toggled(MONOCASE)? EUO_TOUPPER: 0),
+		&uc, force_utf8);
+    }
+
+    /* The returned length includes the terminating NUL. */
+    return xlen? xlen - 1: 0;
+}
+
+/* Discard a mirror. */
+static void
+mirror_free(mirror_t *m)
+{
+    int i;
+
+    for (i = 0; i < m->rows; i++) {
+	vb_free(&m->row[i].text);
+	Free(m->row[i].offset);
+    }
+    Replace(m->row, NULL);
+    Replace(m->snap, NULL);
+    m->rows = 0;
+    m->cols = 0;
+}
+
+/* Convert one row. */
+static void
+render_row(mirror_t *m, int row, bool force_utf8)
+{
+    mirror_row_t *r = &m->row[row];
+    int base = row * COLS;
+    bool is_zero = FA_IS_ZERO(r->fa);
+    int fa_cs = r->fa_cs;
+    int col;
+
+    vb_reset(&r->text);
+    for (col = 0; col < COLS; col++) {
+	char mb[MB_MAX];
+	size_t nb;
+
+	r->offset[col] = vb_len(&r->text);
+	nb = screen_text_cell(ea_buf, base + col, &is_zero, &fa_cs,
+		force_utf8, mb, sizeof(mb));
+	vb_append(&r->text, mb, nb);
+    }
+    r->offset[COLS] = vb_len(&r->text);
+    memcpy(&m->snap[base], &ea_buf[base], COLS * sizeof(struct ea));
+    r->valid = true;
+}
+
+/**
+ * Bring the mirror for an encoding up to date with the screen.
+ *
+ * @param[in] force_utf8 true for the UTF-8 mirror, false for the local
+ *			encoding
+ */
+void
+screen_text_sync(bool force_utf8)
+{
+    mirror_t *m = &mirror[force_utf8];
+    int attr;
+    unsigned char fa, fa_cs;
+    int row;
+
+    if (m->rows != ROWS || m->cols != COLS) {
+	mirror_free(m);
+	m->rows = ROWS;
+	m->cols = COLS;
+	m->snap = (struct ea *)Malloc(ROWS * COLS * sizeof(struct ea));
+	m->row = (mirror_row_t *)Calloc(ROWS, sizeof(mirror_row_t));
+	for (row = 0; row < ROWS; row++) {
+	    vb_init(&m->row[row].text);
+	    m->row[row].offset = (size_t *)Malloc((COLS + 1) * sizeof(size_t));
+	}
+    }
+    if (m->monocase != toggled(MONOCASE)) {
+	m->monocase = toggled(MONOCASE);
+	for (row = 0; row < ROWS; row++) {
+	    m->row[row].valid = false;
+	}
+    }
+
+    /* Find the field attribute in effect at the top of the screen. */
+    attr = find_field_attribute_ea(0, ea_buf);
+    fa = ea_buf[attr].fa;
+    fa_cs = ea_buf[attr].cs;
+
+    for (row = 0; row < ROWS; row++) {
+	mirror_row_t *r = &m->row[row];
+	int base = row * COLS;
+	unsigned char next_ec = (row < ROWS - 1)? ea_buf[base + COLS].ec: 0;
+	int col;
+
+	if (!r->valid ||
+		r->fa != fa ||
+		r->fa_cs != fa_cs ||
+		r->next_ec != next_ec ||
+		memcmp(&m->snap[base], &ea_buf[base],
+		    COLS * sizeof(struct ea))) {
+	    r->fa = fa;
+	    r->fa_cs = fa_cs;
+	    r->next_ec = next_ec;
+	    render_row(m, row, force_utf8);
+	}
+
+	/* Carry the last field attribute in this row to the next one. */
+	for (col = COLS - 1; col >= 0; col--) {
+	    if (ea_buf[base + col].fa) {
+		fa = ea_buf[base + col].fa;
+		fa_cs = ea_buf[base + col].cs;
+		break;
+	    }
+	}
+    }
+}
+
+/**
+ * Return the text for part of a row.
+ * The mirror must have been brought up to date with screen_text_sync().
+ *
+ * @param[in] row	Row
+ * @param[in] col	Starting column
+ * @param[in] ncols	Number of columns
+ * @param[in] force_utf8 true for the UTF-8 mirror
+ * @param[out] len	Returned length
+ *
+ * @return Text, not NUL-terminated. Valid until the next sync.
+ */
+const char *
+screen_text_span(int row, int col, int ncols, bool force_utf8, size_t *len)
+{
+    mirror_row_t *r = &mirror[force_utf8].row[row];
+
+    *len = r->offset[col + ncols] - r->offset[col];
+    return vb_buf(&r->text) + r->offset[col];
+}
+
+/**
+ * Grab a string from the screen, starting at a buffer address and wrapping
+ * around the end of the screen, until it is at least len bytes long.
+ *
+ * @param[in] baddr	Buffer address
+ * @param[in] len	Minimum length
+ * @param[in] force_utf8 true to force UTF-8
+ *
+ * @return Malloc'd string
+ */
+char *
+screen_text_grab(int baddr, size_t len, bool force_utf8)
+{
+    varbuf_t r;
+    int n = ROWS * COLS;
+    int since_text = 0;
+
+    screen_text_sync(force_utf8);
+    vb_init(&r);
+    while (vb_len(&r) < len && since_text < n) {
+	size_t nb;
+	const char *s = screen_text_span(baddr / COLS, baddr % COLS, 1,
+		force_utf8, &nb);
+
+	vb_append(&r, s, nb);
+	since_text = nb? 0: since_text + 1;
+	baddr = (baddr + 1) % n;
+    }
+    return vb_consume(&r);
+}
+
+/* Find the column for a byte offset in a row, or -1. */
+static int
+byte_to_col(const mirror_row_t *r, size_t offset, int col, int ncols)
+{
+    int lo = col, hi = col + ncols;
+
+    /* Find the first column whose offset is >= the target. */
+    while (lo < hi) {
+	int mid = (lo + hi) / 2;
+
+	if (r->offset[mid] < offset) {
+	    lo = mid + 1;
+	} else {
+	    hi = mid;
+	}
+    }
+    return (r->offset[lo] == offset)? lo: -1;
+}
+
+/* Check a match against the field restriction. */
+static bool
+fields_ok(const screen_search_t *ss, int baddr, int len)
+{
+    int fa_addr;
+    bool protected;
+    int i;
+
+    if (ss->fields == SF_ANY) {
+	return true;
+    }
+
+    /* An unformatted screen is all unprotected. */
+    fa_addr = find_field_attribute(baddr);
+    protected = fa_addr >= 0 && FA_IS_PROTECTED(ea_buf[fa_addr].fa);
+    if ((ss->fields == SF_PROTECTED) != protected) {
+	return false;
+    }
+
+    /* The match cannot include a field attribute. */
+    for (i = 0; i < len; i++) {
+	if (ea_buf[baddr + i].fa) {
+	    return false;
+	}
+    }
+    return true;
+}
+
+/* Find the next match in a span of text, returning its offset and length. */
+static bool
+match_next(const screen_search_t *ss, const char *text, size_t text_len,
+	size_t start, size_t *match_start, size_t *match_len)
+{
+#if !defined(_WIN32) /*[*/
+    if (ss->is_regex) {
+	regmatch_t m;
+
+	if (regexec(&ss->regex, text + start, 1, &m,
+		    start? REG_NOTBOL: 0) != 0) {
+	    return false;
+	}
+	*match_start = start + m.rm_so;
+	*match_len = m.rm_eo - m.rm_so;
+	return true;
+    }
+#endif /*]*/
+
+    while (start + ss->pattern_len <= text_len) {
+	const char *s = memchr(text + start, ss->pattern[0],
+		text_len - start - ss->pattern_len + 1);
+
+	if (s == NULL) {
+	    return false;
+	}
+	if (!memcmp(s, ss->pattern, ss->pattern_len)) {
+	    *match_start = s - text;
+	    *match_len = ss->pattern_len;
+	    return true;
+	}
+	start = (s - text) + 1;
+    }
+    return false;
+}
+
+/**
+ * Parse a screen search.
+ *
+ * The arguments are zero or more options followed by the pattern. The
+ * options are:
+ *  Regex				pattern is an extended regular expression
+ *  Protected				match protected fields only
+ *  Unprotected				match unprotected fields only
+ *  Region,row,col,rows,cols		search only part of the screen
+ * Rows and columns are 0-origin.
+ *
+ * @param[in] action	Action name, for error messages
+ * @param[in] argc	Argument count
+ * @param[in] argv	Arguments
+ * @param[in] force_utf8 true if the pattern is UTF-8
+ *
+ * @return Parsed search, or NULL for an error (which has been popped up)
+ */
+screen_search_t *
+screen_search_new(const char *action, unsigned argc, const char **argv,
+	bool force_utf8)
+{
+    screen_search_t *ss;
+    unsigned i;
+    bool is_regex = false;
+
+    if (argc < 1) {
+	popup_an_error("%s(): Missing pattern", action);
+	return NULL;
+    }
+
+    ss = (screen_search_t *)Calloc(1, sizeof(screen_search_t));
+    ss->force_utf8 = force_utf8;
+    for (i = 0; i < argc - 1; i++) {
+	if (!strcasecmp(argv[i], KwRegex)) {
+	    is_regex = true;
+	} else if (!strcasecmp(argv[i], KwProtected)) {
+	    ss->fields = SF_PROTECTED;
+	} else if (!strcasecmp(argv[i], KwUnprotected)) {
+	    ss->fields = SF_UNPROTECTED;
+	} else if (!strcasecmp(argv[i], KwRegion)) {
+	    if (i + 4 >= argc - 1) {
+		popup_an_error("%s(): " KwRegion " requires 4 arguments",
+			action);
+		goto fail;
+	    }
+	    ss->row = atoi(argv[++i]);
+	    ss->col = atoi(argv[++i]);
+	    ss->rows = atoi(argv[++i]);
+	    ss->cols = atoi(argv[++i]);
+	    if (ss->row < 0 || ss->col < 0 || ss->rows <= 0 || ss->cols <= 0 ||
+		    ss->row + ss->rows > ROWS || ss->col + ss->cols > COLS) {
+		popup_an_error("%s(): Invalid " KwRegion, action);
+		goto fail;
+	    }
+	} else {
+	    popup_an_error("%s(): Unknown option '%s'", action, argv[i]);
+	    goto fail;
+	}
+    }
+
+    ss->pattern = NewString(argv[argc - 1]);
+    ss->pattern_len = strlen(ss->pattern);
+    if (is_regex) {
+#if !defined(_WIN32) /*[*/
+	int rc = regcomp(&ss->regex, ss->pattern, REG_EXTENDED);
+
+	if (rc != 0) {
+	    char errbuf[256];
+
+	    regerror(rc, &ss->regex, errbuf, sizeof(errbuf));
+	    popup_an_error("%s(): Invalid regular expression: %s", action,
+		    errbuf);
+	    goto fail;
+	}
+	ss->is_regex = true;
+#else /*][*/
+	popup_an_error("%s(): " KwRegex " is not supported on this platform",
+		action);
+	goto fail;
+#endif /*]*/
+    } else if (!ss->pattern_len) {
+	popup_an_error("%s(): Empty pattern", action);
+	goto fail;
+    }
+    return ss;
+
+fail:
+    screen_search_free(ss);
+    return NULL;
+}
+
+/**
+ * Free a screen search.
+ *
+ * @param[in] ss	Search to free
+ */
+void
+screen_search_free(screen_search_t *ss)
+{
+    if (ss == NULL) {
+	return;
+    }
+#if !defined(_WIN32) /*[*/
+    if (ss->is_regex) {
+	regfree(&ss->regex);
+    }
+#endif /*]*/
+    Free(ss->pattern);
+    Free(ss);
+}
+
+/**
+ * Search the screen.
+ *
+ * Matches do not span rows.
+ *
+ * @param[in] ss	Search
+ * @param[in] found	Function to call for each match, or NULL to stop at
+ *			the first one
+ *
+ * @return Number of matches
+ */
+unsigned
+screen_search(const screen_search_t *ss, screen_search_fn *found)
+{
+    mirror_t *m = &mirror[ss->force_utf8];
+    int row0 = ss->row, col0 = ss->col;
+    int rows = ss->rows? ss->rows: ROWS;
+    int cols = ss->cols? ss->cols: COLS;
+    unsigned n = 0;
+    int row;
+
+    /* A region set up for a different screen size matches nothing. */
+    if (row0 + rows > ROWS || col0 + cols > COLS) {
+	return 0;
+    }
+
+    screen_text_sync(ss->force_utf8);
+    for (row = row0; row < row0 + rows; row++) {
+	const mirror_row_t *r = &m->row[row];
+	size_t base = r->offset[col0];
+	size_t text_len = r->offset[col0 + cols] - base;
+	const char *text = vb_buf(&r->text) + base;
+	size_t start = 0;
+	size_t mstart, mlen;
+
+#if !defined(_WIN32) /*[*/
+	if (ss->is_regex) {
+	    /* regexec() needs a NUL-terminated string. */
+	    char *t = txalloc(text_len + 1);
+
+	    memcpy(t, text, text_len);
+	    t[text_len] = '\0';
+	    text = t;
+	}
+#endif /*]*/
+
+	while (start <= text_len &&
+		match_next(ss, text, text_len, start, &mstart, &mlen)) {
+	    int c0 = byte_to_col(r, base + mstart, col0, cols);
+	    int c1 = byte_to_col(r, base + mstart + mlen, col0, cols);
+
+	    start = mstart + (mlen? mlen: 1);
+	    if (c0 < 0 || c1 < 0 || !mlen ||
+		    !fields_ok(ss, (row * COLS) + c0, c1 - c0)) {
+		continue;
+	    }
+	    n++;
+	    if (found == NULL) {
+		return n;
+	    }
+	    (*found)(row, c0, c1 - c0);
+	}
+    }
+    return n;
+}
+
+/* The code page or screen dimensions changed. */
+static void
+screen_text_invalidate(bool ignored _is_unused)
+{
+    mirror_free(&mirror[false]);
+    mirror_free(&mirror[true]);
+}
+
+/**
+ * Module registration.
+ */
+void
+screen_text_register(void)
+{
+    register_schange(ST_CODEPAGE, screen_text_invalidate);
+    register_schange(ST_REMODEL, screen_text_invalidate);
+}
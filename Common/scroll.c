@@ -50,6 +50,7 @@
 #include "toggles.h"
 #include "trace.h"
 #include "utils.h"
+#include "varbuf.h"
 #include "vstatus.h"
 
 /* Globals */
@@ -57,19 +58,49 @@ bool	scroll_initted = false;
 
 /* Statics */
 
-/* Saved screens. */
-static struct ea **ea_save = (struct ea **) NULL;
+/*
+ * Saved lines.
+ *
+ * Lines that have scrolled off the top of the screen are kept in a compact
+ * encoded form, in a ring of chunks of SB_CHUNK_ROWS lines each. When the
+ * ring is full, the oldest chunk is discarded as a unit and its buffer is
+ * re-used.
+ *
+ * Each encoded line starts with a 16-bit count of the cells that were
+ * stored; cells past that are implicitly defaults_buf. The cells are stored
+ * as a sequence of runs, each starting with a type byte and a count-1 byte:
+ *  SR_EC:     attributes, then one EBCDIC byte per cell (ucs4 is 0)
+ *  SR_UCS1:   attributes, then one Unicode byte per cell (ec is 0)
+ *  SR_REPEAT: one struct ea, repeated count times
+ *  SR_FULL:   count complete struct eas
+ * The attributes are the fa, fg, bg, gr, cs, ic and db fields of struct ea.
+ */
+#define SB_CHUNK_ROWS	256	/* lines per chunk */
+#define SR_EC		0	/* EBCDIC characters with common attributes */
+#define SR_UCS1		1	/* 8-bit Unicode characters with common attributes */
+#define SR_REPEAT	2	/* repeated cell */
+#define SR_FULL		3	/* uncompressed cells */
+#define SR_MAX		256	/* maximum cells in one run */
+#define SR_MIN_REPEAT	4	/* minimum length of a repeated run */
+#define SR_ATTRS	7	/* number of attribute bytes */
+typedef struct {
+    varbuf_t data;			/* encoded lines */
+    unsigned offset[SB_CHUNK_ROWS];	/* offset of each line in data */
+} sb_chunk_t;
+static sb_chunk_t *sb_chunks = NULL;
+static int      sb_nchunks = 0;
+static unsigned char *sb_encbuf = NULL;	/* encoding scratch buffer */
+
+/* Saved screen image, maxROWS * maxCOLS cells. */
+static struct ea *ea_image = NULL;
 
 /* Number of lines saved. */
 static int      n_saved = 0;
-static int      scroll_next = 0;
+static unsigned long sb_total = 0;	/* total lines stored since reset */
 
 static int      scrolled_back = 0;
 static bool  need_saving = true;
 static bool  vscreen_swapped = false;
-static char    *sbuf = NULL;
-static int      sa_bufsize;
-static char    *zbuf = NULL;
 static struct ea *defaults_buf = NULL;
 
 /* Thumb state: */
@@ -90,15 +121,206 @@ static void sync_scroll(int sb);
 static void save_image(void);
 static void scroll_reset(void);
 
+/*
+ * Compare the attributes (everything but the character) of two cells.
+ */
+static bool
+ea_attrs_equal(const struct ea *a, const struct ea *b)
+{
+    return a->fa == b->fa && a->fg == b->fg && a->bg == b->bg &&
+	a->gr == b->gr && a->cs == b->cs && a->ic == b->ic && a->db == b->db;
+}
+
+/*
+ * Compare two cells.
+ */
+static bool
+ea_equal(const struct ea *a, const struct ea *b)
+{
+    return a->ec == b->ec && a->ucs4 == b->ucs4 && ea_attrs_equal(a, b);
+}
+
+/*
+ * Classify a cell by how its character can be encoded.
+ */
+static int
+ea_run_type(const struct ea *ea)
+{
+    if (ea->ucs4 == 0) {
+	return SR_EC;
+    }
+    if (ea->ec == 0 && ea->ucs4 < 0x100) {
+	return SR_UCS1;
+    }
+    return SR_FULL;
+}
+
+/*
+ * Returns the number of identical cells starting at ea, up to n.
+ */
+static int
+repeat_len(const struct ea *ea, int n)
+{
+    int j;
+
+    for (j = 1; j < n && ea_equal(&ea[j], ea); j++) {
+    }
+    return j;
+}
+
+/*
+ * Encode a line and append it to the save area.
+ */
+static void
+sb_put(const struct ea *ea, int ncells)
+{
+    unsigned long line = sb_total++;
+    sb_chunk_t *c = &sb_chunks[(line / SB_CHUNK_ROWS) % sb_nchunks];
+    unsigned char *s = sb_encbuf;
+    int i = 0;
+
+    /* Starting a chunk discards the oldest lines. */
+    if (!(line % SB_CHUNK_ROWS)) {
+	vb_reset(&c->data);
+    }
+    c->offset[line % SB_CHUNK_ROWS] = (unsigned)vb_len(&c->data);
+
+    /* Trailing default cells are implicit. */
+    while (ncells > 0 && ea_equal(&ea[ncells - 1], defaults_buf)) {
+	ncells--;
+    }
+    *s++ = ncells & 0xff;
+    *s++ = (ncells >> 8) & 0xff;
+
+    while (i < ncells) {
+	int type = ea_run_type(&ea[i]);
+	int n = repeat_len(ea + i,
+		(ncells - i < SR_MAX)? ncells - i: SR_MAX);
+	int j;
+
+	if (n >= SR_MIN_REPEAT) {
+	    *s++ = SR_REPEAT;
+	    *s++ = n - 1;
+	    memcpy(s, &ea[i], sizeof(struct ea));
+	    s += sizeof(struct ea);
+	    i += n;
+	    continue;
+	}
+
+	/*
+	 * Gather cells of the same type and attributes, stopping at the start
+	 * of a repeated run.
+	 */
+	for (j = i + 1;
+	     j < ncells && j - i < SR_MAX &&
+		ea_run_type(&ea[j]) == type &&
+		(type == SR_FULL || ea_attrs_equal(&ea[j], &ea[i])) &&
+		repeat_len(ea + j, (ncells - j < SR_MIN_REPEAT)?
+		    ncells - j: SR_MIN_REPEAT) < SR_MIN_REPEAT;
+	     j++) {
+	}
+	n = j - i;
+	*s++ = type;
+	*s++ = n - 1;
+	if (type == SR_FULL) {
+	    memcpy(s, &ea[i], n * sizeof(struct ea));
+	    s += n * sizeof(struct ea);
+	} else {
+	    *s++ = ea[i].fa;
+	    *s++ = ea[i].fg;
+	    *s++ = ea[i].bg;
+	    *s++ = ea[i].gr;
+	    *s++ = ea[i].cs;
+	    *s++ = ea[i].ic;
+	    *s++ = ea[i].db;
+	    for (j = 0; j < n; j++) {
+		*s++ = (type == SR_EC)? ea[i + j].ec:
+		    (unsigned char)ea[i + j].ucs4;
+	    }
+	}
+	i += n;
+    }
+
+    vb_append(&c->data, (char *)sb_encbuf, s - sb_encbuf);
+}
+
+/*
+ * Decode a saved line into cols cells, counting back from the most recent
+ * line (1 is the most recently saved line).
+ */
+static void
+sb_get(int back, struct ea *ea, int cols)
+{
+    unsigned long line = sb_total - back;
+    sb_chunk_t *c = &sb_chunks[(line / SB_CHUNK_ROWS) % sb_nchunks];
+    const unsigned char *s = (const unsigned char *)vb_buf(&c->data) +
+	c->offset[line % SB_CHUNK_ROWS];
+    int ncells;
+    int i = 0;
+    int j;
+
+    ncells = s[0] | (s[1] << 8);
+    s += 2;
+    while (i < ncells) {
+	int type = *s++;
+	int n = *s++ + 1;
+
+	switch (type) {
+	case SR_REPEAT:
+	    for (j = 0; j < n && i + j < cols; j++) {
+		memcpy(&ea[i + j], s, sizeof(struct ea));
+	    }
+	    s += sizeof(struct ea);
+	    break;
+	case SR_FULL:
+	    if (i < cols) {
+		memcpy(&ea[i], s,
+			((n < cols - i)? n: cols - i) * sizeof(struct ea));
+	    }
+	    s += n * sizeof(struct ea);
+	    break;
+	default: {
+	    struct ea t;
+
+	    memset(&t, 0, sizeof(t));
+	    t.fa = s[0];
+	    t.fg = s[1];
+	    t.bg = s[2];
+	    t.gr = s[3];
+	    t.cs = s[4];
+	    t.ic = s[5];
+	    t.db = s[6];
+	    s += SR_ATTRS;
+	    for (j = 0; j < n; j++) {
+		if (type == SR_EC) {
+		    t.ec = s[j];
+		} else {
+		    t.ucs4 = s[j];
+		}
+		if (i + j < cols) {
+		    ea[i + j] = t;
+		}
+	    }
+	    s += n;
+	    break;
+	}
+	}
+	i += n;
+    }
+
+    /* Fill out the rest of the line. */
+    if (ncells < cols) {
+	memcpy(ea + ncells, defaults_buf, (cols - ncells) * sizeof(struct ea));
+    }
+}
+
 /*
  * Initialize (or re-initialize) the scrolling parameters and save area.
  */
 void
 scroll_buf_init(void)
 {
-    register int i;
-    int sa_size;
-    unsigned char *s;
+    int i;
 
     /* Set the number of rows to save, as a multiple of maxROWS. */
     scroll_max = appres.interactive.save_lines;
@@ -108,19 +330,27 @@ scroll_buf_init(void)
     if (scroll_max < maxROWS * 5) {
 	scroll_max = maxROWS * 5;
     }
-    if (sbuf != NULL) {
-	Free(sbuf);
-	Free(zbuf);
+    if (ea_image != NULL) {
+	for (i = 0; i < sb_nchunks; i++) {
+	    vb_free(&sb_chunks[i].data);
+	}
+	Free(sb_chunks);
+	Free(sb_encbuf);
 	Free(defaults_buf);
-	Free(ea_save);
-    }
-    sa_size = scroll_max + maxROWS;
-    ea_save = (struct ea **)Calloc(sizeof(struct ea *), sa_size);
-    sa_bufsize = (sa_size *
-	    (sizeof(unsigned char) + sizeof(struct ea))) * maxCOLS;
-    sbuf = Malloc(sa_bufsize);
-    zbuf = Malloc(maxCOLS);
-    memset(zbuf, '\0', maxCOLS);
+	Free(ea_image);
+    }
+
+    /*
+     * Allocate one more chunk than needed, so that discarding the oldest
+     * chunk still leaves scroll_max lines.
+     */
+    sb_nchunks = ((scroll_max + SB_CHUNK_ROWS - 1) / SB_CHUNK_ROWS) + 1;
+    sb_chunks = (sb_chunk_t *)Calloc(sizeof(sb_chunk_t), sb_nchunks);
+    for (i = 0; i < sb_nchunks; i++) {
+	vb_init(&sb_chunks[i].data);
+    }
+    sb_encbuf = Malloc(2 + (maxCOLS * (2 + sizeof(struct ea))));
+    ea_image = (struct ea *)Calloc(sizeof(struct ea), maxROWS * maxCOLS);
     defaults_buf = Calloc(maxCOLS, sizeof(struct ea));
     for (i = 0; i < maxCOLS; i++) {
 	/*
@@ -131,10 +361,6 @@ scroll_buf_init(void)
 	defaults_buf[i].bg = HOST_COLOR_NEUTRAL_BLACK;
 	defaults_buf[i].gr = GR_SBMARGIN;
     }
-    s = (unsigned char *)sbuf;
-    for (i = 0; i < sa_size; s += (maxCOLS * sizeof(struct ea)), i++) {
-	ea_save[i] = (struct ea *)s;
-    }
     scroll_reset();
     scroll_initted = true;
 }
@@ -160,8 +386,12 @@ screen_set_thumb_traced(float top, float shown, int saved, int screen,
 static void
 scroll_reset(void)
 {
-    memset(sbuf, 0, sa_bufsize);
-    scroll_next = 0;
+    int i;
+
+    for (i = 0; i < sb_nchunks; i++) {
+	vb_reset(&sb_chunks[i].data);
+    }
+    sb_total = 0;
     n_saved = 0;
     scrolled_back = 0;
     thumb_top_base = thumb_top = 0.0;
@@ -193,28 +423,16 @@ scroll_save(int n)
     /* Save the screen contents. */
     for (row = 0; row < n; row++) {
 	if (row < ROWS) {
-	    memmove(ea_save[scroll_next],
-		    ea_buf + (row * COLS),
-		    COLS * sizeof(struct ea));
-	    if (COLS < maxCOLS) {
-		memcpy(ea_save[scroll_next] + COLS, defaults_buf,
-			(maxCOLS - COLS) * sizeof(struct ea));
-	    }
+	    sb_put(ea_buf + (row * COLS), COLS);
 	} else {
-	    memcpy(ea_save[scroll_next], defaults_buf,
-		    maxCOLS * sizeof(struct ea));
+	    sb_put(defaults_buf, 0);
 	}
-	scroll_next = (scroll_next + 1) % scroll_max;
 	if (n_saved < scroll_max) {
 	    n_saved++;
 	}
     }
     if (n == ROWS && n < maxROWS) {
-	for (row = n; row < maxROWS; row++) {
-	    memcpy(ea_save[scroll_next], defaults_buf,
-		    maxCOLS * sizeof(struct ea));
-	}
-	scroll_next = (scroll_next + 1) % scroll_max;
+	sb_put(defaults_buf, 0);
 	if (n_saved < scroll_max) {
 	    n_saved++;
 	}
@@ -225,13 +443,11 @@ scroll_save(int n)
      * non-screenful boundary, this must be scrolled NVT data. Pad with blank
      * lines to get a screenful.
      */
-    if (n != 1 && (scroll_next % maxROWS)) {
+    if (n != 1 && (sb_total % maxROWS)) {
 	int pad;
 
-	for (pad = maxROWS - (scroll_next % maxROWS); pad; pad--) {
-	    memcpy(ea_save[scroll_next], defaults_buf,
-		    maxCOLS * sizeof(struct ea));
-	    scroll_next = (scroll_next + 1) % scroll_max;
+	for (pad = maxROWS - (sb_total % maxROWS); pad; pad--) {
+	    sb_put(defaults_buf, 0);
 	    if (n_saved < scroll_max) {
 		n_saved++;
 	    }
@@ -281,7 +497,7 @@ save_image(void)
 #endif /*]*/
 
     for (i = 0; i < maxROWS; i++) {
-	memmove(ea_save[scroll_max + i],
+	memmove(ea_image + (i * maxCOLS),
 		(ea_buf + (i * COLS)), COLS * sizeof(struct ea));
     }
     need_saving = false;
@@ -295,7 +511,6 @@ sync_scroll(int sb)
 {
     int slop;
     int i;
-    int scroll_first;
     float tt0;
 
 #if defined(SCROLL_DEBUG) /*[*/
@@ -349,20 +564,13 @@ sync_scroll(int sb)
 	vscreen_swapped = false;
     }
 
-    scroll_first = (scroll_next + scroll_max - sb) % scroll_max;
-#if defined(SCROLL_DEBUG) /*[*/
-    vtrace("sync_scroll: scroll_first is %d\n", scroll_first);
-#endif /*]*/
-
     /* Update the screen. */
     for (i = 0; i < maxROWS; i++) {
 	if (i < sb) {
-	    memmove((ea_buf + (i * COLS)),
-		    ea_save[(scroll_first + i) % scroll_max],
-		    COLS * sizeof(struct ea));
+	    sb_get(sb - i, ea_buf + (i * COLS), COLS);
 	} else {
 	    memmove((ea_buf + (i * COLS)),
-		    ea_save[scroll_max + i - sb],
+		    ea_image + ((i - sb) * maxCOLS),
 		    COLS * sizeof(struct ea));
 	}
     }
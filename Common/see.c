@@ -207,7 +207,7 @@ see_attr(unsigned char fa)
     varbuf_t r;
     const char *sep = "(";
 
-    vb_init(&r);
+    vb_init_tx(&r);
 
     if (fa & FA_PROTECT) {
 	vb_appendf(&r, "%sprotected", sep);
@@ -246,7 +246,7 @@ see_attr(unsigned char fa)
 	vb_appends(&r, "(default)");
     }
 
-    return txdFree(vb_consume(&r));
+    return vb_consume(&r);
 }
 
 /**
@@ -270,7 +270,7 @@ see_highlight(unsigned char setting)
 	varbuf_t r;
 	char *sep = "";
 
-	vb_init(&r);
+	vb_init_tx(&r);
 	if ((setting & XAH_BLINK) == XAH_BLINK) {
 	    vb_appendf(&r, "%s%s", sep, "blink");
 	    sep = ",";
@@ -288,7 +288,7 @@ see_highlight(unsigned char setting)
 	    sep = ",";
 	}
 
-	return txdFree(vb_consume(&r));
+	return vb_consume(&r);
     }
 }
 
@@ -402,7 +402,7 @@ see_validation(unsigned char setting)
     varbuf_t r;
     const char *sep = "(";
 
-    vb_init(&r);
+    vb_init_tx(&r);
     if (setting & XAV_FILL) {
 	vb_appendf(&r, "%sfill", sep);
 	sep = ",";
@@ -420,7 +420,7 @@ see_validation(unsigned char setting)
     } else {
 	vb_appends(&r, "(none)");
     }
-    return txdFree(vb_consume(&r));
+    return vb_consume(&r);
 }
 
 /**
@@ -436,7 +436,7 @@ see_outline(unsigned char setting)
     varbuf_t r;
     const char *sep = "(";
 
-    vb_init(&r);
+    vb_init_tx(&r);
     if (setting & XAO_UNDERLINE) {
 	vb_appendf(&r, "%sunderline", sep);
 	sep = ",";
@@ -458,7 +458,7 @@ see_outline(unsigned char setting)
     } else {
 	vb_appends(&r, "(none)");
     }
-    return txdFree(vb_consume(&r));
+    return vb_consume(&r);
 }
 
 /**
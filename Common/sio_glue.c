@@ -93,6 +93,10 @@ static flagged_res_t sio_flagged_res[] = {
 	{ ResTlsMaxProtocol, aoffset(tls.max_protocol), XRM_STRING } },
     { TLS_OPT_SECURITY_LEVEL,
 	{ ResTlsSecurityLevel, aoffset(tls.security_level), XRM_STRING } },
+    { TLS_OPT_SESSION_CACHE_FILE,
+	{ ResTlsSessionCacheFile, aoffset(tls.session_cache_file), XRM_STRING } },
+    { TLS_OPT_KERNEL_OFFLOAD,
+	{ ResTlsKernelOffload, aoffset(tls.kernel_offload), XRM_BOOLEAN } },
 };
 static int n_sio_flagged_res = (int)array_count(sio_flagged_res);
 
@@ -160,6 +164,14 @@ add_tls_opts(void)
 	    { OptTlsMaxProtocol, OPT_STRING, false, ResTlsMaxProtocol,
 		aoffset(tls.max_protocol),
 		TLS_PROTOCOLS, "TLS maximum protocol version" } },
+	{ TLS_OPT_SESSION_CACHE_FILE,
+	    { OptTlsSessionCacheFile, OPT_STRING, false, ResTlsSessionCacheFile,
+		aoffset(tls.session_cache_file),
+		"<filename>", "File to share cached TLS sessions in" } },
+	{ TLS_OPT_KERNEL_OFFLOAD,
+	    { OptTlsKernelOffload, OPT_BOOLEAN, true, ResTlsKernelOffload,
+		aoffset(tls.kernel_offload),
+		NULL, "Have the kernel encrypt and decrypt TLS records" } },
     };
     int n_opts = (int)array_count(flagged_opts);
     unsigned n_tls_opts = 0;
@@ -326,7 +338,7 @@ sio_option_names(void)
     varbuf_t v;
     char *sep = "";
 
-    vb_init(&v);
+    vb_init_tx(&v);
     FOREACH_TLS_OPTS(opt) {
 	if (options & opt) {
 	    const char *opt_name = sio_option_name(opt);
@@ -338,7 +350,7 @@ sio_option_names(void)
 	}
     } FOREACH_TLS_OPTS_END(opt);
 
-    return txdFree(vb_consume(&v));
+    return vb_consume(&v);
 }
 
 /*
@@ -470,6 +482,24 @@ sio_toggle(const char *name, const char *value, unsigned flags, ia_t ia)
 	    appres.tls.security_level = NewString(value);
 	}
 	break;
+    case TLS_OPT_SESSION_CACHE_FILE:
+	if (connected) {
+	    toggle_save_disconnect_set(name, value, ia);
+	} else {
+	    Replace(appres.tls.session_cache_file, value[0]? NewString(value): NULL);
+	}
+	break;
+    case TLS_OPT_KERNEL_OFFLOAD:
+	if ((errmsg = boolstr(value, &b)) != NULL) {
+	    popup_an_error("%s %s", name, errmsg);
+	    return TU_FAILURE;
+	}
+	if (connected) {
+	    toggle_save_disconnect_set(name, TrueFalse(b), ia);
+	} else {
+	    appres.tls.kernel_offload = b;
+	}
+	break;
     default:
 	popup_an_error("Unknown name '%s'", name);
 	return TU_FAILURE;
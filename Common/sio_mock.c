@@ -232,6 +232,12 @@ sio_secure_unverified(sio_t sio)
     return false;
 }
 
+bool
+sio_session_resumed(sio_t sio)
+{
+    return false;
+}
+
 unsigned
 sio_options_supported(void)
 {
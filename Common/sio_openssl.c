@@ -37,8 +37,13 @@
 #endif /*]*/
 
 #include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <netinet/in.h>
 #include <openssl/ssl.h>
 #include <openssl/err.h>
+#include <openssl/evp.h>
 #include <openssl/conf.h>
 #include <openssl/x509v3.h>
 
@@ -49,7 +54,9 @@
 #include "varbuf.h"	/* must precede sioc.h */
 #include "resources.h"
 #include "sioc.h"
+#include "sockaddr_46.h"
 #include "trace.h"
+#include "txa.h"
 #include "utils.h"
 
 #if !defined(LIBRESSL_VERSION_NUMBER) /*[*/
@@ -61,6 +68,10 @@
 # endif /*]*/
 #endif /*]*/
 
+#if defined(SSL_OP_ENABLE_KTLS) && !defined(OPENSSL_NO_KTLS) /*[*/
+# define HAVE_KTLS
+#endif /*]*/
+
 #define CN_EQ		"CN = "
 #define CN_EQ_SIZE	strlen(CN_EQ)
 
@@ -82,6 +93,9 @@ typedef struct {
     char *server_subjects;
     bool negotiate_pending;
     bool negotiated;
+    char *session_key;
+    bool ktls_send;
+    bool ktls_recv;
 } ssl_sio_t;
 
 static ssl_sio_t *current_sio;
@@ -94,6 +108,9 @@ static ssl_sio_t *current_sio;
 static int proto_map[] = { -1, SSL3_VERSION, TLS1_VERSION, TLS1_1_VERSION, TLS1_2_VERSION, TLS1_3_VERSION };
 
 static void client_info_callback(INFO_CONST SSL *s, int where, int ret);
+#if defined(OPENSSL110) /*[*/
+static int new_session_callback(SSL *ssl, SSL_SESSION *session);
+#endif /*]*/
 #if !defined(OPENSSL102) /*[*/
 static char *spc_verify_cert_hostname(X509 *cert, const char *hostname);
 #endif /*]*/
@@ -470,6 +487,321 @@ spc_verify_cert_hostname(X509 *cert, const char *hostname)
 }
 #endif /*]*/
 
+#if defined(OPENSSL110) /*[*/
+/*
+ * Client-side TLS session cache, keyed by host:port and a digest of the TLS
+ * configuration (see session_config_digest()).
+ * Sessions are kept in memory, and optionally in a file that can be shared by
+ * several emulators. Each line of the file is "key hex-DER-session".
+ */
+#define SESSION_CACHE_SIZE	16
+static struct {
+    char *key;			/* host:port/config-digest */
+    SSL_SESSION *session;	/* cached session */
+} session_cache[SESSION_CACHE_SIZE];
+static int session_cache_next = 0;	/* next slot to reuse */
+
+/* Returns true if a session has expired. */
+static bool
+session_expired(SSL_SESSION *session)
+{
+    return SSL_SESSION_get_time(session) + SSL_SESSION_get_timeout(session) <=
+	(long)time(NULL);
+}
+
+/* Store a session in memory. The cache takes over the caller's reference. */
+static void
+session_cache_store(const char *key, SSL_SESSION *session)
+{
+    int i;
+    int slot = -1;
+
+    for (i = 0; i < SESSION_CACHE_SIZE; i++) {
+	if (session_cache[i].key != NULL && !strcmp(session_cache[i].key, key)) {
+	    slot = i;
+	    break;
+	}
+	if (slot < 0 && session_cache[i].key == NULL) {
+	    slot = i;
+	}
+    }
+    if (slot < 0) {
+	slot = session_cache_next;
+	session_cache_next = (session_cache_next + 1) % SESSION_CACHE_SIZE;
+    }
+
+    if (session_cache[slot].session != NULL) {
+	SSL_SESSION_free(session_cache[slot].session);
+    }
+    Replace(session_cache[slot].key, NewString(key));
+    session_cache[slot].session = session;
+}
+
+/* Look up a session in memory. */
+static SSL_SESSION *
+session_cache_find(const char *key)
+{
+    int i;
+
+    for (i = 0; i < SESSION_CACHE_SIZE; i++) {
+	if (session_cache[i].key != NULL && !strcmp(session_cache[i].key, key)) {
+	    if (session_expired(session_cache[i].session)) {
+		SSL_SESSION_free(session_cache[i].session);
+		session_cache[i].session = NULL;
+		Replace(session_cache[i].key, NULL);
+		return NULL;
+	    }
+	    return session_cache[i].session;
+	}
+    }
+    return NULL;
+}
+
+/* Load a session from the cache file into memory. */
+static SSL_SESSION *
+session_file_load(const char *file, const char *key)
+{
+    FILE *f;
+    char *line = NULL;
+    size_t line_size = 0;
+    size_t key_len = strlen(key);
+    SSL_SESSION *session = NULL;
+
+    if ((f = fopen(file, "r")) == NULL) {
+	return NULL;
+    }
+    while (session == NULL && getline(&line, &line_size, f) > 0) {
+	char *hex;
+	unsigned char *der, *dp;
+	const unsigned char *cdp;
+	size_t hex_len, i;
+
+	if (strncmp(line, key, key_len) || line[key_len] != ' ') {
+	    continue;
+	}
+	hex = line + key_len + 1;
+	hex_len = strcspn(hex, "\r\n");
+	if (hex_len == 0 || hex_len % 2) {
+	    continue;
+	}
+	dp = der = (unsigned char *)Malloc(hex_len / 2);
+	for (i = 0; i < hex_len; i += 2) {
+	    unsigned u;
+
+	    if (sscanf(hex + i, "%2x", &u) != 1) {
+		break;
+	    }
+	    *dp++ = (unsigned char)u;
+	}
+	cdp = der;
+	if (i == hex_len &&
+		(session = d2i_SSL_SESSION(NULL, &cdp, (long)(hex_len / 2))) != NULL &&
+		session_expired(session)) {
+	    SSL_SESSION_free(session);
+	    session = NULL;
+	}
+	Free(der);
+    }
+    free(line);
+    fclose(f);
+
+    if (session != NULL) {
+	vctrace(TC_TLS, "Loaded TLS session for %s from %s\n", key, file);
+	session_cache_store(key, session);
+    }
+    return session;
+}
+
+/*
+ * Save a session in the cache file, replacing any other entry for its key.
+ *
+ * The file holds session secrets, so it is only ever readable by its owner.
+ * The new contents are written to a uniquely-named temporary file in the same
+ * directory and renamed into place, and concurrent writers are serialized by
+ * a lock on a separate lock file, so no update is lost or torn.
+ */
+static void
+session_file_save(const char *file, const char *key, SSL_SESSION *session)
+{
+    char *lock_name;
+    char *temp;
+    int lock_fd, fd;
+    FILE *f, *t;
+    char *line = NULL;
+    size_t line_size = 0;
+    size_t key_len = strlen(key);
+    int der_len;
+    unsigned char *der, *dp;
+    int i;
+
+    if ((der_len = i2d_SSL_SESSION(session, NULL)) <= 0) {
+	return;
+    }
+
+    lock_name = Asprintf("%s.lock", file);
+    lock_fd = open(lock_name, O_RDWR | O_CREAT | O_NOFOLLOW, 0600);
+    if (lock_fd < 0 || lockf(lock_fd, F_LOCK, 0) < 0) {
+	vctrace(TC_TLS, "Cannot lock TLS session cache %s: %s\n", lock_name,
+		strerror(errno));
+	if (lock_fd >= 0) {
+	    close(lock_fd);
+	}
+	Free(lock_name);
+	return;
+    }
+    Free(lock_name);
+
+    temp = Asprintf("%s.XXXXXX", file);
+    if ((fd = mkstemp(temp)) < 0 ||
+	    fchmod(fd, 0600) < 0 ||
+	    (t = fdopen(fd, "w")) == NULL) {
+	vctrace(TC_TLS, "Cannot write TLS session cache %s: %s\n", temp,
+		strerror(errno));
+	if (fd >= 0) {
+	    close(fd);
+	    unlink(temp);
+	}
+	Free(temp);
+	close(lock_fd);
+	return;
+    }
+
+    dp = der = (unsigned char *)Malloc(der_len);
+    i2d_SSL_SESSION(session, &dp);
+
+    /* Copy the other entries. */
+    if ((f = fopen(file, "r")) != NULL) {
+	while (getline(&line, &line_size, f) > 0) {
+	    if (strncmp(line, key, key_len) || line[key_len] != ' ') {
+		fputs(line, t);
+	    }
+	}
+	free(line);
+	fclose(f);
+    }
+
+    /* Add this one. */
+    fprintf(t, "%s ", key);
+    for (i = 0; i < der_len; i++) {
+	fprintf(t, "%02x", der[i]);
+    }
+    fputc('\n', t);
+    OPENSSL_cleanse(der, der_len);
+    Free(der);
+
+    if (fclose(t) != 0 || rename(temp, file) < 0) {
+	vctrace(TC_TLS, "Cannot update TLS session cache %s: %s\n", file,
+		strerror(errno));
+	unlink(temp);
+    }
+    Free(temp);
+
+    /* Closing the lock file releases the lock. */
+    close(lock_fd);
+}
+
+/* OpenSSL callback for a new session that can be resumed later. */
+static int
+new_session_callback(SSL *ssl, SSL_SESSION *session)
+{
+    ssl_sio_t *s = (ssl_sio_t *)SSL_get_app_data(ssl);
+
+    if (s == NULL || s->session_key == NULL) {
+	return 0;
+    }
+    vctrace(TC_TLS, "Caching TLS session for %s\n", s->session_key);
+    if (s->config->session_cache_file != NULL) {
+	session_file_save(s->config->session_cache_file, s->session_key,
+		session);
+    }
+    session_cache_store(s->session_key, session);
+    return 1;
+}
+
+/*
+ * Compute a digest of the parts of the TLS configuration a session depends on:
+ * how the server is verified, and the client's identity.
+ *
+ * A resumed session carries the verification result and client certificate
+ * of the connection that created it, so a session is only ever resumed under
+ * the same configuration.
+ *
+ * Returns the digest in hex, in a temporary buffer.
+ */
+static const char *
+session_config_digest(tls_config_t *config)
+{
+    const char *fields[] = {
+	config->verify_host_cert? "verify": "noverify",
+	config->accept_hostname,
+	config->ca_dir,
+	config->ca_file,
+	config->cert_file,
+	config->cert_file_type,
+	config->chain_file,
+	config->key_file,
+	config->key_file_type,
+	config->client_cert,
+    };
+    EVP_MD_CTX *ctx;
+    unsigned char md[EVP_MAX_MD_SIZE];
+    unsigned md_len = 0;
+    varbuf_t r;
+    size_t i;
+
+    ctx = EVP_MD_CTX_new();
+    EVP_DigestInit_ex(ctx, EVP_sha256(), NULL);
+    for (i = 0; i < array_count(fields); i++) {
+	/* Include the NUL, so adjacent fields cannot run together. */
+	if (fields[i] != NULL) {
+	    EVP_DigestUpdate(ctx, "+", 1);
+	    EVP_DigestUpdate(ctx, fields[i], strlen(fields[i]) + 1);
+	} else {
+	    EVP_DigestUpdate(ctx, "-", 1);
+	}
+    }
+    EVP_DigestFinal_ex(ctx, md, &md_len);
+    EVP_MD_CTX_free(ctx);
+
+    vb_init_tx(&r);
+    for (i = 0; i < md_len; i++) {
+	vb_appendf(&r, "%02x", md[i]);
+    }
+    return vb_consume(&r);
+}
+
+/*
+ * Try to resume an earlier session with the same host, port and TLS
+ * configuration.
+ */
+static void
+session_resume(ssl_sio_t *s)
+{
+    sockaddr_46_t sa;
+    socklen_t len = sizeof(sa);
+    unsigned short port;
+    SSL_SESSION *session;
+
+    if (getpeername(s->sock, &sa.sa, &len) < 0) {
+	return;
+    }
+    port = ntohs((sa.sa.sa_family == AF_INET)? sa.sin.sin_port:
+	    sa.sin6.sin6_port);
+    Replace(s->session_key, Asprintf("%s:%u/%s", s->hostname, port,
+		session_config_digest(s->config)));
+
+    session = session_cache_find(s->session_key);
+    if (session == NULL && s->config->session_cache_file != NULL) {
+	session = session_file_load(s->config->session_cache_file,
+		s->session_key);
+    }
+    if (session != NULL && SSL_set_session(s->con, session) == 1) {
+	vctrace(TC_TLS, "Trying to resume TLS session for %s\n",
+		s->session_key);
+    }
+}
+#endif /*]*/
+
 /*
  * Create a new OpenSSL connection.
  */
@@ -519,6 +851,11 @@ sio_init(tls_config_t *config, const char *password, sio_t *sio_ret)
 	goto fail;
     }
     SSL_CTX_set_info_callback(s->ctx, client_info_callback);
+#if defined(OPENSSL110) /*[*/
+    SSL_CTX_set_session_cache_mode(s->ctx,
+	    SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(s->ctx, new_session_callback);
+#endif /*]*/
     SSL_CTX_set_default_passwd_cb_userdata(s->ctx, s);
     SSL_CTX_set_default_passwd_cb(s->ctx, passwd_cb);
     if (config->security_level != NULL && config->security_level[0] != '\0') {
@@ -650,6 +987,19 @@ sio_init(tls_config_t *config, const char *password, sio_t *sio_ret)
 	goto fail;
     }
     SSL_set_verify_depth(s->con, 64);
+    SSL_set_app_data(s->con, s);
+
+    /*
+     * Let a blocked write be retried from a different address (the caller's
+     * transmit queue may move) and with more data appended.
+     */
+    SSL_set_mode(s->con, SSL_MODE_ENABLE_PARTIAL_WRITE |
+	    SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+#if defined(HAVE_KTLS) /*[*/
+    if (s->config->kernel_offload) {
+	SSL_set_options(s->con, SSL_OP_ENABLE_KTLS);
+    }
+#endif /*]*/
 
     /* Success. */
     *sio_ret = (sio_t *)s;
@@ -791,11 +1141,22 @@ display_cert(varbuf_t *v, X509 *cert, int level, const char *who)
 
 /* Display session info. */
 static void
-display_session(varbuf_t *v, SSL *con)
+display_session(varbuf_t *v, ssl_sio_t *s)
 {
+    SSL *con = s->con;
+
     vb_appendf(v, "Version: %s\n", SSL_get_version(con));
     vb_appendf(v, "Cipher: %s\n", SSL_get_cipher_name(con));
     vb_appendf(v, "Security level: %d\n", SSL_get_security_level(con));
+    vb_appendf(v, "Session resumed: %s\n", SSL_session_reused(con)? "yes": "no");
+    if (s->ktls_send || s->ktls_recv) {
+	vb_appendf(v, "Record encryption: kernel (%s)\n",
+		(s->ktls_send && s->ktls_recv)? "send and receive":
+		    (s->ktls_send? "send only": "receive only"));
+    } else {
+	vb_appendf(v, "Record encryption: user space%s\n",
+		s->config->kernel_offload? " (kernel offload unavailable)": "");
+    }
 }
 
 /* Display server certificate info. */
@@ -958,6 +1319,10 @@ sio_negotiate(sio_t sio, socket_t sock, const char *hostname, bool *data)
 	    vctrace(TC_TLS, "OpenSSL sio_negotiate: can't set fd\n");
 	    return SIG_FAILURE;
 	}
+
+#if defined(OPENSSL110) /*[*/
+	session_resume(s);
+#endif /*]*/
     }
 
     current_sio = s;
@@ -1010,9 +1375,22 @@ sio_negotiate(sio_t sio, socket_t sock, const char *hostname, bool *data)
     }
 #endif /*]*/
 
+#if defined(HAVE_KTLS) /*[*/
+    /*
+     * See if the kernel took over record encryption. It will not if the tls
+     * module is not loaded or it does not support the negotiated cipher.
+     */
+    if (s->config->kernel_offload) {
+	s->ktls_send = BIO_get_ktls_send(SSL_get_wbio(s->con));
+	s->ktls_recv = BIO_get_ktls_recv(SSL_get_rbio(s->con));
+	vctrace(TC_TLS, "Kernel TLS: send %s, receive %s\n",
+		s->ktls_send? "on": "off", s->ktls_recv? "on": "off");
+    }
+#endif /*]*/
+
     /* Display the session info. */
     vb_init(&v);
-    display_session(&v, s->con);
+    display_session(&v, s);
     s->session_info = vb_consume(&v);
     len = strlen(s->session_info);
     if (len > 0 && s->session_info[len - 1] == '\n') {
@@ -1089,7 +1467,8 @@ sio_read(sio_t sio, char *buf, size_t buflen)
 
 /*
  * Write encrypted data on the socket.
- * Returns the data length or SIO_FATAL_ERROR.
+ * Returns the data length, SIO_EWOULDBLOCK if the socket is full, or
+ * SIO_FATAL_ERROR.
  */
 int
 sio_write(sio_t sio, const char *buf, size_t buflen)
@@ -1114,6 +1493,10 @@ sio_write(sio_t sio, const char *buf, size_t buflen)
 	unsigned long e;
 	char err_buf[120];
 
+	if (SSL_get_error(s->con, nw) == SSL_ERROR_WANT_WRITE) {
+	    vctrace(TC_TLS, "SSL_write: EWOULDBLOCK\n");
+	    return SIO_EWOULDBLOCK;
+	}
 	e = ERR_get_error();
 	ERR_error_string(e, err_buf);
 	vctrace(TC_TLS, "RCVD SSL_write error %ld (%s)\n", e, err_buf);
@@ -1155,6 +1538,7 @@ sio_close(sio_t sio)
 	Free(s->server_subjects);
 	s->server_subjects = NULL;
     }
+    Replace(s->session_key, NULL);
 
     if (s->con != NULL) {
 	SSL_shutdown(s->con);
@@ -1177,6 +1561,16 @@ sio_secure_unverified(sio_t sio)
     return (s != NULL)? s->secure_unverified: false;
 }
 
+/*
+ * Returns true if the current connection resumed an earlier session.
+ */
+bool
+sio_session_resumed(sio_t sio)
+{
+    ssl_sio_t *s = (ssl_sio_t *)sio;
+    return (s != NULL && s->negotiated)? SSL_session_reused(s->con) != 0: false;
+}
+
 /*
  * Returns a bitmap of the supported options.
  */
@@ -1186,7 +1580,14 @@ sio_options_supported(void)
     return TLS_OPT_CA_DIR | TLS_OPT_CA_FILE | TLS_OPT_CERT_FILE
 	| TLS_OPT_CERT_FILE_TYPE | TLS_OPT_CHAIN_FILE | TLS_OPT_KEY_FILE
 	| TLS_OPT_KEY_FILE_TYPE | TLS_OPT_KEY_PASSWD | TLS_OPT_MIN_PROTOCOL
-	| TLS_OPT_MAX_PROTOCOL | TLS_OPT_SECURITY_LEVEL;
+	| TLS_OPT_MAX_PROTOCOL | TLS_OPT_SECURITY_LEVEL
+#if defined(OPENSSL110) /*[*/
+	| TLS_OPT_SESSION_CACHE_FILE
+#endif /*]*/
+#if defined(HAVE_KTLS) /*[*/
+	| TLS_OPT_KERNEL_OFFLOAD
+#endif /*]*/
+	;
 }
 
 /*
@@ -1247,6 +1247,16 @@ sio_secure_unverified(sio_t sio)
     return s? s->secure_unverified: false;
 }
 
+/*
+ * Returns true if the current connection resumed an earlier session.
+ * Session resumption is not implemented here.
+ */
+bool
+sio_session_resumed(sio_t sio _is_unused)
+{
+    return false;
+}
+
 /*
  * Returns a bitmap of the supported options.
  */
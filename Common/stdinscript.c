@@ -96,6 +96,7 @@ static json_t *pj_out;		/* pending JSON output state */
 static unsigned stdin_capabilities;
 
 static oq_t stdout_oq;
+static bool stdin_paused = false;	/* input paused for stdout backpressure */
 
 /**
  * Check a string for (possibly incremental) JSON.
@@ -330,6 +331,43 @@ stdin_data(task_cbh handle _is_unused, const char *buf, size_t len, bool success
     Free(cooked);
 }
 
+/**
+ * Resume reading commands from stdin.
+ */
+static void
+stdin_resume(void)
+{
+#if !defined(_WIN32) /*[*/
+    if (stdin_eof) {
+	x3270_exit(0);
+    }
+    stdin_id = AddInput(fileno(stdin), stdin_input);
+#else /*][*/
+    stdin_nr = 0;
+    SetEvent(stdin_enable_event);
+    if (stdin_id == NULL_IOID) {
+	stdin_id = AddInput(stdin_done_event, stdin_input);
+    }
+#endif /*]*/
+}
+
+/**
+ * Backpressure callback for stdout.
+ *
+ * @param[in] backed_up	True if output is backed up
+ */
+static void
+stdout_backpressure(bool backed_up)
+{
+    if (!backed_up && stdin_paused) {
+	vctrace(TC_SCRIPT, "s3stdin output drained, resuming input\n");
+	stdin_paused = false;
+	if (enabled) {
+	    stdin_resume();
+	}
+    }
+}
+
 /**
  * Callback for completion of one command executed from stdin.
  *
@@ -354,20 +392,14 @@ stdin_done(task_cbh handle, bool success, bool abort)
     Free(out);
     pushed_wait = false;
 
-    /* Allow more. */
+    /* Allow more, unless stdout is not keeping up. */
     if (enabled) {
-#if !defined(_WIN32) /*[*/
-	if (stdin_eof) {
-	    x3270_exit(0);
-	}
-	stdin_id = AddInput(fileno(stdin), stdin_input);
-#else /*][*/
-	stdin_nr = 0;
-	SetEvent(stdin_enable_event);
-	if (stdin_id == NULL_IOID) {
-	    stdin_id = AddInput(stdin_done_event, stdin_input);
+	if (oq_backed_up(stdout_oq)) {
+	    vctrace(TC_SCRIPT, "s3stdin output backed up, pausing input\n");
+	    stdin_paused = true;
+	} else {
+	    stdin_resume();
 	}
-#endif /*]*/
     }
 
     const char *errmsg;
@@ -460,6 +492,7 @@ stdin_init(void)
 
     /* Set up the stdout output queue. */
     stdout_oq = oq_create_stdout(txAsprintf("%s-stdout", programname), TC_SCRIPT);
+    oq_set_backpressure(stdout_oq, stdout_backpressure);
 
     /* If not connected yet, wait for one before enabling input. */
     /* XXX: We might need to add a Wait(Connect) action. */
@@ -72,8 +72,10 @@
 #include "popups.h"
 #include "pr3287_session.h"
 #include "product.h"
+#include "profile.h"
 #include "s3270_proto.h"
 #include "screen.h"
+#include "screen_text.h"
 #include "source.h"
 #include "split_host.h"
 #include "stdinscript.h"
@@ -140,6 +142,10 @@ typedef struct task {
 	TS_WAIT_CURSOR_AT, /* awaiting cursor at a specific location */
 	TS_WAIT_STRING_AT, /* awaiting string string a specific location */
 	TS_WAIT_IFIELD_AT, /* awaiting an input field at a specific location */
+	TS_WAIT_SEARCH,	/* awaiting a screen search match */
+	TS_WAIT_FIELD_COUNT, /* awaiting a specific number of fields */
+	TS_WAIT_CURSOR_IN_FIELD, /* awaiting the cursor in a specific field */
+	TS_WAIT_OIA,	/* awaiting an OIA condition */
     } state;
     bool success;
     bool accumulated;	/* accumulated time flag */
@@ -160,6 +166,8 @@ typedef struct task {
 	int baddr;	/* location for wait operations */
 	char *string;	/* string to wait for */
 	bool force_utf8;/* true if string is UTF-8 */
+	screen_search_t *search; /* screen search to wait for */
+	int value;	/* field count, field number or OIA condition */
     } match;
 
     /* Expect() fields. */
@@ -176,6 +184,13 @@ typedef struct task {
 	cmd_t **cmd_next; /*          next command to run */
 #	define LAST_BUF 64
 	char	last[LAST_BUF]; /* last command */
+	struct {	/* Batch() state: */
+	    bool active;	/*  batch mode is on */
+	    bool cont;	/*  keep going after a failure */
+	    bool pending; /*  a command has not been reported yet */
+	    bool failed; /*  some command failed */
+	    unsigned count; /*  number of commands run */
+	} batch;
     } macro;
 
     /* cb fields. */
@@ -186,6 +201,7 @@ typedef struct task {
 
 } task_t;
 static task_t *current_task = NULL;	/* the current task */
+unsigned task_events = TE_ALL;	/* events since the last run_tasks() */
 static int passthru_index = 0;
 static peer_listen_t global_peer_listen = NULL;
 
@@ -200,6 +216,12 @@ typedef struct _taskq {
     unsigned short index;	/* index, for debug display */
     bool deleted;	/* delete flag */
     bool output_wait_needed; /* should Wait(Output) block? */
+    struct {		/* parked (blocked) top task: */
+	bool is_parked;	/*  parked at the end of the last pass */
+	task_t *task;	/*  task, NULL if freed since */
+	enum task_state state; /*  its state when parked */
+	unsigned wake_on; /*  events that wake it */
+    } parked;
 } taskq_t;
 static llist_t taskq = LLIST_INIT(taskq);
 static unsigned short taskq_index = 1;
@@ -233,6 +255,10 @@ static const char *task_state_name[] = {
     "WAIT_CURSOR_AT",
     "WAIT_STRING_AT",
     "WAIT_IFIELD_AT",
+    "WAIT_SEARCH",
+    "WAIT_FIELD_COUNT",
+    "WAIT_CURSOR_IN_FIELD",
+    "WAIT_OIA",
 };
 
 static struct macro_def *macro_last = (struct macro_def *) NULL;
@@ -244,6 +270,7 @@ static const char *st_name[NUM_ST] = {
     "Callback"		/* CB */
 };
 static const char *stsname(task_t *s);
+static void task_result(task_t *s, const char *msg, bool success);
 #define TASK_NAME_FMT	"%s[#%u.%d]"
 #define TASK_sNAME(s)	stsname(s), (s)->taskq->index, (s)->depth
 #define TASK_NAME	TASK_sNAME(current_task)
@@ -255,6 +282,7 @@ static void call_run(task_t *s);
 static void task_done(bool success);
 static void task_pop(void);
 static void wait_timed_out(ioid_t id);
+static bool wait_screen_cond(enum task_state state, int value);
 static task_t *task_redirect_to(void);
 static bool expect_matches(task_t *task);
 
@@ -310,13 +338,37 @@ static struct {
     { KwCursorAt,      1, 2, TS_WAIT_CURSOR_AT },
     { KwStringAt,      2, 3, TS_WAIT_STRING_AT },
     { KwInputFieldAt,  1, 2, TS_WAIT_IFIELD_AT },
+    { KwSearch,        1, 9, TS_WAIT_SEARCH },
+    { KwFieldCount,    1, 1, TS_WAIT_FIELD_COUNT },
+    { KwCursorInField, 1, 1, TS_WAIT_CURSOR_IN_FIELD },
+    { KwOia,           1, 1, TS_WAIT_OIA },
     { NULL, 0, 0 }
 };
 
+/* Wait(Oia) conditions. */
+enum oia_cond {
+    OC_LOCKED,		/* keyboard locked */
+    OC_UNLOCKED,	/* keyboard unlocked */
+    OC_FORMATTED,	/* screen formatted */
+    OC_UNFORMATTED,	/* screen unformatted */
+    OC_PROTECTED,	/* cursor in a protected field */
+    OC_UNPROTECTED	/* cursor in an unprotected field */
+};
+static const char *oia_cond_names[] = {
+    KwLocked,
+    KwUnlocked,
+    KwFormatted,
+    KwUnformatted,
+    KwProtected,
+    KwUnprotected,
+    NULL
+};
+
 static action_t Abort_action;
 static action_t Ascii_action;
 static action_t Ascii1_action;
 static action_t AsciiField_action;
+static action_t Batch_action;
 static action_t CloseScript_action;
 static action_t Ebcdic_action;
 static action_t Ebcdic1_action;
@@ -328,6 +380,7 @@ static action_t Macro_action;
 static action_t NvtText_action;
 static action_t Pause_action;
 static action_t ReadBuffer_action;
+static action_t Search_action;
 static action_t Snap_action;
 static action_t Wait_action;
 static action_t Capabilities_action;
@@ -361,9 +414,9 @@ static void
 trace_task_output(task_t *s, const char *fmt, ...)
 {
     va_list args;
-    char *msgbuf;
-    char *st;
-    char *m;
+    const char *msgbuf;
+    const char *st;
+    const char *m;
     char c;
 
     if (!toggled(TRACING)) {
@@ -371,7 +424,7 @@ trace_task_output(task_t *s, const char *fmt, ...)
     }
 
     va_start(args, fmt);
-    msgbuf = Vasprintf(fmt, args);
+    msgbuf = txVasprintf(fmt, args);
     va_end(args);
 
     m = msgbuf;
@@ -384,7 +437,6 @@ trace_task_output(task_t *s, const char *fmt, ...)
 	    continue;
 	}
     }
-    Free(msgbuf);
 }
 
 /* Parse the macros resource into the macro list */
@@ -595,6 +647,18 @@ Fail_action(ia_t ia, unsigned argc, const char **argv)
     return false;
 }
 
+/**
+ * Toggle the AID wait setting, which changes what a keyboard wait waits for.
+ *
+ * @param[in] ix	Toggle index
+ * @param[in] tt	Toggle type
+ */
+static void
+toggle_aid_wait(toggle_index_t ix _is_unused, enum toggle_type tt _is_unused)
+{
+    task_wake(TE_KEYBOARD);
+}
+
 /**
  * Task module registration.
  */
@@ -607,6 +671,7 @@ task_register(void)
 	{ AnAscii,		Ascii_action, 0 },
 	{ AnAscii1,		Ascii1_action, 0 },
 	{ AnAsciiField,		AsciiField_action, 0 },
+	{ AnBatch,		Batch_action, 0 },
 	{ AnBell,		Bell_action, 0 },
 	{ AnCapabilities,	Capabilities_action, ACTION_HIDDEN },
 	{ AnCloseScript,	CloseScript_action, 0 },
@@ -629,6 +694,7 @@ task_register(void)
 	{ RESUME_INPUT,		ResumeInput_action, ACTION_HIDDEN },
 	{ AnRequestInput,	RequestInput_action, ACTION_HIDDEN },
 	{ AnScript,		Script_action, ACTION_KE },
+	{ AnSearch,		Search_action, 0 },
 	{ AnSnap,		Snap_action, 0 },
 	{ AnSource,		Source_action, ACTION_KE },
 	{ AnWait,		Wait_action, ACTION_KE }
@@ -637,7 +703,7 @@ task_register(void)
 	{ AnPrinter,		Printer_action, ACTION_KE },
     };
     static toggle_register_t toggles[] = {
-	{ AID_WAIT,	NULL,	0 }
+	{ AID_WAIT,	toggle_aid_wait, 0 }
     };
     static xres_t task_xresources[] = {
 	{ ResMacros,		V_WILD },
@@ -812,6 +878,12 @@ free_task(task_t *t)
 	t->macro.cmd_next = NULL;
     }
     Replace(t->match.string, NULL);
+    screen_search_free(t->match.search);
+
+    /* Forget that it was parked. */
+    if (t->taskq != NULL && t->taskq->parked.task == t) {
+	t->taskq->parked.task = NULL;
+    }
 
     /* Free the structure. */
     Free(t);
@@ -977,41 +1049,34 @@ static action_elt_t *
 lookup_action(const char *action, char **errorp)
 {
     action_elt_t *e;
-    action_elt_t *any = NULL;
-    action_elt_t *exact = NULL;
-    int matches = 0;
+    action_elt_t **matches;
+    unsigned n_matches;
+    unsigned i;
     varbuf_t r;
 
-    vb_init(&r);
-
-    /* Search the action list. */
-    FOREACH_LLIST(&actions_list, e, action_elt_t *) {
-	if (!strcasecmp(action, e->t.name)) {
-	    exact = any = e;
-	    break;
-	}
-    } FOREACH_LLIST_END(&actions_list, e, action_elt_t *);
-    if (exact == NULL) {
-	FOREACH_LLIST(&actions_list, e, action_elt_t *) {
-	    if (!strncasecmp(action, e->t.name, strlen(action))) {
-		vb_appendf(&r, "%s%s()", matches? ", ": "", e->t.name);
-		matches++;
-		any = e;
-	    }
-	} FOREACH_LLIST_END(&actions_list, e, action_elt_t *);
+    /* Try for an exact match. */
+    if ((e = action_find(action)) != NULL) {
+	return e;
     }
 
-    if (matches > 1) {
-	*errorp = Asprintf("Ambiguous action name '%s': %s", action, txdFree(vb_consume(&r)));
-	return NULL;
+    /* Try for a unique prefix. */
+    n_matches = action_find_prefix(action, &matches);
+    if (n_matches == 1) {
+	return matches[0];
     }
 
-    if (any == NULL) {
-	*errorp = Asprintf("Unknown action: %s", action);
+    if (n_matches > 1) {
+	vb_init_tx(&r);
+	for (i = 0; i < n_matches; i++) {
+	    vb_appendf(&r, "%s%s()", i? ", ": "", matches[i]->t.name);
+	}
+	*errorp = Asprintf("Ambiguous action name '%s': %s", action,
+		vb_consume(&r));
+	return NULL;
     }
 
-    vb_free(&r);
-    return any;
+    *errorp = Asprintf("Unknown action: %s", action);
+    return NULL;
 }
 
 /**
@@ -1346,6 +1411,196 @@ silent_failure:
 #undef fail
 }
 
+/*
+ * Parsed command cache.
+ *
+ * Scripts, macros, keymaps and the httpd tend to run the same command strings
+ * over and over, so the results of parse_command() are kept in a small LRU
+ * cache keyed by the command text. The arguments for each entry are packed
+ * into a single block, which is copied out on a hit.
+ */
+#define CMD_CACHE_SIZE		64	/* maximum number of entries */
+#define CMD_CACHE_HASH		128	/* number of hash buckets */
+#define CMD_CACHE_MAX_TEXT	256	/* longest command text cached */
+typedef struct cmd_cache {
+    llist_t lru;		/* LRU linkage, most recent first */
+    struct cmd_cache *hash_next; /* hash chain */
+    unsigned hash;		/* hash of text */
+    char *text;			/* command text */
+    size_t next_offset;		/* offset of the next command in text */
+    action_elt_t *entry;	/* action */
+    char **args;		/* packed arguments */
+    size_t args_size;		/* size of packed arguments */
+} cmd_cache_t;
+static llist_t cmd_cache_lru = LLIST_INIT(cmd_cache_lru);
+static cmd_cache_t *cmd_cache_hash[CMD_CACHE_HASH];
+static unsigned cmd_cache_count;
+static unsigned cmd_cache_generation;
+
+/**
+ * Hash command text.
+ *
+ * @param[in] text	Command text
+ *
+ * @returns Hash value
+ */
+static unsigned
+cmd_cache_hash_text(const char *text)
+{
+    unsigned h = 2166136261U;
+    char c;
+
+    while ((c = *text++) != '\0') {
+	h = (h ^ (unsigned char)c) * 16777619U;
+    }
+    return h;
+}
+
+/**
+ * Copy a packed argument array.
+ *
+ * @param[in] args	Packed arguments
+ * @param[in] size	Size of packed arguments
+ *
+ * @returns Copy, which can be freed with a single call to Free()
+ */
+static char **
+cmd_cache_copy_args(char **args, size_t size)
+{
+    char **copy = (char **)Malloc(size);
+    unsigned i;
+
+    memcpy(copy, args, size);
+    for (i = 0; args[i] != NULL; i++) {
+	copy[i] = (char *)copy + (args[i] - (char *)args);
+    }
+    return copy;
+}
+
+/**
+ * Remove an entry from the parsed command cache.
+ *
+ * @param[in] c		Entry to remove
+ */
+static void
+cmd_cache_remove(cmd_cache_t *c)
+{
+    cmd_cache_t **cp;
+
+    for (cp = &cmd_cache_hash[c->hash % CMD_CACHE_HASH];
+	    *cp != c;
+	    cp = &(*cp)->hash_next) {
+    }
+    *cp = c->hash_next;
+    llist_unlink(&c->lru);
+    Free(c->args);
+    Free(c);
+    cmd_cache_count--;
+}
+
+/**
+ * Parse a command, using the parsed command cache.
+ *
+ * @param[in] s		string to parse
+ * @param[out] np	returned pointer to additional commands
+ * @param[out] entryp	returned action entry
+ * @param[out] argsp	returned arguments, which can be freed with a single
+ * 			call to Free()
+ * @param[out] errorp	returned error text (if false returned)
+ *
+ * @returns true for success, false for failure
+ */
+static bool
+parse_command_cached(const char *s, const char **np, action_elt_t **entryp,
+	char ***argsp, char **errorp)
+{
+    size_t len = strlen(s);
+    unsigned hash;
+    cmd_cache_t *c;
+    char **args;
+    size_t size;
+    unsigned i;
+
+    /* Flush the cache if the set of actions has changed. */
+    if (cmd_cache_generation != actions_generation) {
+	while (!llist_isempty(&cmd_cache_lru)) {
+	    cmd_cache_remove((cmd_cache_t *)cmd_cache_lru.next);
+	}
+	cmd_cache_generation = actions_generation;
+    }
+
+    /* Look it up. */
+    hash = cmd_cache_hash_text(s);
+    if (len <= CMD_CACHE_MAX_TEXT) {
+	for (c = cmd_cache_hash[hash % CMD_CACHE_HASH];
+		c != NULL;
+		c = c->hash_next) {
+	    if (c->hash == hash && !strcmp(c->text, s)) {
+		llist_unlink(&c->lru);
+		LLIST_PREPEND(&c->lru, cmd_cache_lru);
+		*np = s + c->next_offset;
+		*entryp = c->entry;
+		*argsp = cmd_cache_copy_args(c->args, c->args_size);
+		*errorp = NULL;
+		return true;
+	    }
+	}
+    }
+
+    /* Parse it. */
+    if (!parse_command(s, 0, np, entryp, &args, errorp)) {
+	return false;
+    }
+    if (*entryp == NULL) {
+	/* A comment. */
+	*argsp = NULL;
+	return true;
+    }
+
+    /* Pack the arguments. */
+    size = sizeof(char *);
+    for (i = 0; args[i] != NULL; i++) {
+	size += sizeof(char *) + strlen(args[i]) + 1;
+    }
+    *argsp = (char **)Malloc(size);
+    {
+	char *t = (char *)(*argsp + i + 1);
+
+	for (i = 0; args[i] != NULL; i++) {
+	    size_t sl = strlen(args[i]) + 1;
+
+	    (*argsp)[i] = t;
+	    memcpy(t, args[i], sl);
+	    t += sl;
+	    Free(args[i]);
+	}
+	(*argsp)[i] = NULL;
+	Free(args);
+    }
+
+    /* Remember it. */
+    if (len > CMD_CACHE_MAX_TEXT) {
+	return true;
+    }
+    if (cmd_cache_count >= CMD_CACHE_SIZE) {
+	cmd_cache_remove((cmd_cache_t *)cmd_cache_lru.prev);
+    }
+    c = (cmd_cache_t *)Malloc(sizeof(cmd_cache_t) + len + 1);
+    llist_init(&c->lru);
+    LLIST_PREPEND(&c->lru, cmd_cache_lru);
+    c->hash = hash;
+    c->hash_next = cmd_cache_hash[hash % CMD_CACHE_HASH];
+    cmd_cache_hash[hash % CMD_CACHE_HASH] = c;
+    c->text = (char *)(c + 1);
+    memcpy(c->text, s, len + 1);
+    c->next_offset = *np - s;
+    c->entry = *entryp;
+    c->args = cmd_cache_copy_args(*argsp, size);
+    c->args_size = size;
+    cmd_cache_count++;
+    return true;
+}
+
 /**
  * Interpret and execute a script or macro command.
  *
@@ -1461,13 +1716,15 @@ execute_command(enum iaction cause, const char *s, const char **np, char *last,
     action_elt_t *entry;
     char **args;
     char *error;
-    int i;
 
     /* Parse the command. */
-    stat = parse_command(s, 0, np, &entry, &args, &error);
+    stat = parse_command_cached(s, np, &entry, &args, &error);
     if (!stat) {
 	popup_an_error("%s", error);
 	Free(error);
+	strncpy(last, s, last_len - 1);
+	last[last_len - 1] = '\0';
+	*np = NULL;
 	return stat;
     }
 
@@ -1481,10 +1738,7 @@ execute_command(enum iaction cause, const char *s, const char **np, char *last,
 	    last_len, cbx);
 
     /* Free the arguments. */
-    for (i = 0; args[i] != NULL; i++) {
-	Free(args[i]);
-    }
-    Replace(args, NULL);
+    Free(args);
     return stat;
 }
 
@@ -1548,6 +1802,25 @@ static bool is_nonblocking_connect(task_t *t)
 	((*t->cbx.cb->getflags)(t->cbx.handle) & CBF_CONNECT_FT_NONBLOCK) != 0;
 }
 
+/* Report the completion of a command run by Batch(). */
+static void
+batch_report(task_t *s)
+{
+    s->macro.batch.pending = false;
+    if (s->next != NULL) {
+	task_result(s->next, txAsprintf("batch %u %s %s",
+		    s->macro.batch.count, s->macro.last,
+		    s->success? "ok": "error"), s->success);
+    }
+    if (!s->success) {
+	s->macro.batch.failed = true;
+	if (s->macro.batch.cont) {
+	    /* Keep going. */
+	    s->success = true;
+	}
+    }
+}
+
 /* Run the macro at the top of the stack. */
 static void
 run_macro(void)
@@ -1572,6 +1845,11 @@ run_macro(void)
 	unsigned int old_kybdlock = kybdlock;
 	struct task_cbx *cbx = NULL;
 
+	/* Report the previous batch command. */
+	if (s->macro.batch.pending) {
+	    batch_report(s);
+	}
+
 	/*
 	 * Check for command failure.
 	 */
@@ -1599,6 +1877,11 @@ run_macro(void)
 	    ia = IA_MACRO;
 	}
 
+	if (s->macro.batch.active) {
+	    s->macro.batch.count++;
+	    s->macro.batch.pending = true;
+	}
+
 	if (s->macro.cmd_next != NULL) {
 	    es = execute_command_split(ia, *s->macro.cmd_next, s->macro.last,
 		    LAST_BUF, cbx);
@@ -1626,6 +1909,12 @@ run_macro(void)
 		s->next->success = false;
 	    }
 
+	    /* A batch can skip over it, unless it could not be parsed. */
+	    if (s->macro.batch.cont &&
+		    (s->macro.cmd_next != NULL || nextm != NULL)) {
+		a = nextm;
+		continue;
+	    }
 	    break;
 	}
 
@@ -1657,6 +1946,14 @@ run_macro(void)
 	fatal = s->fatal;
     }
 
+    /* Report the last batch command, and the batch as a whole. */
+    if (s->macro.batch.pending) {
+	batch_report(s);
+    }
+    if (s->macro.batch.failed) {
+	s->success = false;
+    }
+
     /* Finished with this macro. */
     task_pop();
 
@@ -1934,17 +2231,15 @@ task_error(const char *msg)
 void
 task_info(const char *fmt, ...)
 {
-    char *nl;
-    char *msgbuf;
-    char *msg;
+    const char *nl;
+    const char *msg;
     va_list args;
     task_t *s;
 
     va_start(args, fmt);
-    msgbuf = Vasprintf(fmt, args);
+    msg = txVasprintf(fmt, args);
     va_end(args);
 
-    msg = msgbuf;
     do {
 	size_t nc;
 
@@ -1965,8 +2260,6 @@ task_info(const char *fmt, ...)
 	}
 	msg = nl + 1;
     } while (nl);
-
-    Free(msgbuf);
 }
 
 /**
@@ -2132,90 +2425,6 @@ task_ft_complete(const char *msg, bool is_error)
     }
 }
 
-/**
- * Grabs a string from an offset on the screen.
- * Returns the string.
- *
- * N.B.: The length parameter is not the number of buffer positions to scan,
- * it is the size of the string to return. This is because the string to wait
- * for is multibyte, and we don't know how many buffer positions that might
- * represent.
- *
- * @param[in] baddr	buffer address
- * @param[in] len	length of match string
- * @param[in] buf	display buffer
- * @param[in] force_utf8 true to force string to UTF-8 encoding
- */
-static char *
-grab_string(int baddr, size_t len, struct ea *buf, bool force_utf8)
-{
-    int i;
-    bool is_zero = false;
-    varbuf_t r;
-    char *ret;
-
-    vb_init(&r);
-
-    is_zero = FA_IS_ZERO(get_field_attribute(baddr));
-
-    for (i = 0; vb_len(&r) < len; i++) {
-	char mb[16];
-	ucs4_t uc;
-	size_t j;
-	size_t xlen;
-	struct ea *ea = &buf[(baddr + i) % (ROWS * COLS)];
-
-	if (ea->fa) {
-	    is_zero = FA_IS_ZERO(ea->fa);
-	    vb_appends(&r, " ");
-	} else if (is_zero) {
-	    vb_appends(&r, " ");
-	} else if (IS_RIGHT(ctlr_dbcs_state(baddr + i))) {
-	    continue;
-	} else {
-	    if (is_nvt(ea, false, &uc)) {
-		/* NVT-mode text. */
-		if (uc >= UPRIV2_Aunderbar && uc <= UPRIV2_Zunderbar) {
-		    uc -= UPRIV2;
-		}
-		if (toggled(MONOCASE)) {
-		    uc = u_toupper(uc);
-		}
-		xlen = unicode_to_multibyte_f(uc, mb, sizeof(mb), force_utf8);
-		for (j = 0; j < xlen - 1; j++) {
-		    vb_appendf(&r, "%c", mb[j]);
-		}
-	    } else {
-		/* 3270-mode text. */
-		if (IS_LEFT(ctlr_dbcs_state(baddr + i))) {
-		    xlen = ebcdic_to_multibyte_f((ea->ec << 8) |
-			    buf[(baddr + i + 1) % (ROWS * COLS)].ec,
-			    mb, sizeof(mb), force_utf8);
-		    for (j = 0; j < xlen - 1; j++) {
-			vb_appendf(&r, "%c", mb[j]);
-		    }
-		} else {
-		    xlen = ebcdic_to_multibyte_fx(ea->ec, ea->cs, mb,
-			    sizeof(mb),
-			    EUO_BLANK_UNDEF |
-			     (toggled(MONOCASE)? EUO_TOUPPER: 0),
-			    &uc, force_utf8);
-		    for (j = 0; j < xlen - 1; j++) {
-			vb_appendf(&r, "%c", mb[j]);
-		    }
-		}
-	    }
-	}
-    }
-
-    ret = NewString(vb_buf(&r));
-    if (ret == NULL) {
-	ret = NewString("");
-    }
-    vb_free(&r);
-    return ret;
-}
-
 /**
  * Run one task queue.
  *
@@ -2365,8 +2574,9 @@ run_taskq(void)
 		break;
 	    }
 	    if (current_task->match.baddr < ROWS * COLS) {
-		char *current_string = grab_string(current_task->match.baddr,
-			strlen(current_task->match.string), ea_buf,
+		char *current_string = screen_text_grab(
+			current_task->match.baddr,
+			strlen(current_task->match.string),
 			current_task->match.force_utf8);
 
 		if (!strcmp(current_string, current_task->match.string)) {
@@ -2392,6 +2602,31 @@ run_taskq(void)
 		}
 	    }
 	    return any;
+	case TS_WAIT_SEARCH:
+	    if (!PCONNECTED || cstate == RECONNECTING) {
+		task_disconnect_abort(current_task);
+		any = true;
+		break;
+	    }
+	    if (screen_search(current_task->match.search, NULL)) {
+		any = true;
+		break;
+	    }
+	    return any;
+	case TS_WAIT_FIELD_COUNT:
+	case TS_WAIT_CURSOR_IN_FIELD:
+	case TS_WAIT_OIA:
+	    if (!PCONNECTED || cstate == RECONNECTING) {
+		task_disconnect_abort(current_task);
+		any = true;
+		break;
+	    }
+	    if (wait_screen_cond(current_task->state,
+			current_task->match.value)) {
+		any = true;
+		break;
+	    }
+	    return any;
 	}
 
 	/* Restart the task. */
@@ -2422,6 +2657,106 @@ run_taskq(void)
     return any;
 }
 
+/**
+ * Map a blocked task state onto the events that can unblock it.
+ *
+ * @param[in] state	Task state
+ *
+ * @return Event mask, or 0 if only a state change can unblock it.
+ */
+static unsigned
+task_wake_on(enum task_state state)
+{
+    switch (state) {
+    case TS_KBWAIT:
+    case TS_WAIT_UNLOCK:
+	return TE_KEYBOARD | TE_CONNECT;
+    case TS_CONNECT_WAIT:
+	return TE_CONNECT | TE_KEYBOARD;
+    case TS_WAIT_NVT:
+    case TS_WAIT_3270:
+    case TS_WAIT_DISC:
+    case TS_WAIT_OUTPUT:
+    case TS_SWAIT_OUTPUT:
+	/* Wait(Output) is released directly by task_host_output(). */
+	return TE_CONNECT;
+    case TS_WAIT_IFIELD:
+	return TE_CONNECT | TE_KEYBOARD | TE_SCREEN | TE_CURSOR;
+    case TS_EXPECTING:
+	return TE_CONNECT | TE_OUTPUT;
+    case TS_WAIT_CURSOR_AT:
+	return TE_CONNECT | TE_CURSOR;
+    case TS_WAIT_STRING_AT:
+    case TS_WAIT_IFIELD_AT:
+    case TS_WAIT_SEARCH:
+    case TS_WAIT_FIELD_COUNT:
+	return TE_CONNECT | TE_SCREEN;
+    case TS_WAIT_CURSOR_IN_FIELD:
+	return TE_CONNECT | TE_SCREEN | TE_CURSOR;
+    case TS_WAIT_OIA:
+	return TE_CONNECT | TE_KEYBOARD | TE_SCREEN | TE_CURSOR;
+    case TS_TIME_WAIT:
+    case TS_PASSTHRU:
+    case TS_XWAIT:
+	/* Released only by an explicit state change. */
+	return 0;
+    default:
+	return TE_ALL;
+    }
+}
+
+/**
+ * Decide if a task queue can be skipped, because its top task is blocked
+ * and none of the events it is waiting for have happened.
+ *
+ * @param[in] q		Task queue
+ * @param[in] events	Events since the last pass
+ *
+ * @return True if the queue can be skipped.
+ */
+static bool
+taskq_parked(taskq_t *q, unsigned events)
+{
+    if (q->parked.task == NULL ||
+	    q->parked.task != q->top ||
+	    q->parked.state != q->top->state) {
+	/* Not parked, or something has changed out from under it. */
+	return false;
+    }
+    return !(events & q->parked.wake_on);
+}
+
+/**
+ * Collect the events posted since the last call.
+ *
+ * @return Event mask.
+ */
+static unsigned
+task_collect_events(void)
+{
+    static int last_cursor_addr = -1;
+    static enum cstate last_cstate = NOT_CONNECTED;
+    unsigned events;
+
+    /*
+     * The cursor is moved by each front end's cursor_move(), and the
+     * connection state is changed in several places, so these two are
+     * noticed here rather than posted.
+     */
+    if (cursor_addr != last_cursor_addr) {
+	task_wake(TE_CURSOR);
+	last_cursor_addr = cursor_addr;
+    }
+    if (cstate != last_cstate) {
+	task_wake(TE_CONNECT);
+	last_cstate = cstate;
+    }
+
+    events = task_events;
+    task_events = 0;
+    return events;
+}
+
 /**
  * Run pending tasks.
  */
@@ -2430,16 +2765,33 @@ run_tasks(void)
 {
     taskq_t *q;
     bool any = false;
+    prof_cat_t prev;
+    unsigned events;
+    bool woken;
 
     /* There is no running task unless we are inside this function. */
     assert(current_task == NULL);
+    prev = prof_enter(PC_TASKS);
+
+    events = task_collect_events();
 
 restart:
     /* Walk each queue, and run the tasks on it. */
     FOREACH_LLIST(&taskq, q, taskq_t *) {
-	if (q->top != NULL) {
+	if (q->top != NULL && !taskq_parked(q, events)) {
 	    current_task = q->top;
 	    any |= run_taskq();
+
+	    /* If the queue is now blocked, park it. */
+	    if (q->top != NULL && q->top->state >= MIN_WAITING_STATE) {
+		q->parked.is_parked = true;
+		q->parked.task = q->top;
+		q->parked.state = q->top->state;
+		q->parked.wake_on = task_wake_on(q->top->state);
+	    } else {
+		q->parked.is_parked = false;
+		q->parked.task = NULL;
+	    }
 	}
 	if (q->deleted) {
 	    llist_unlink(&q->llist);
@@ -2449,9 +2801,27 @@ restart:
 	}
     } FOREACH_LLIST_END(&taskq, q, taskq_t *);
 
+    /*
+     * The tasks that just ran may have posted events that wake queues that
+     * were already passed over. Run them now, rather than leaving them until
+     * the next call, which might not happen until some unrelated event.
+     */
+    events = task_collect_events();
+    woken = false;
+    FOREACH_LLIST(&taskq, q, taskq_t *) {
+	if (q->top != NULL && q->parked.is_parked && !taskq_parked(q, events)) {
+	    woken = true;
+	    break;
+	}
+    } FOREACH_LLIST_END(&taskq, q, taskq_t *);
+    if (woken) {
+	goto restart;
+    }
+
     /* Now there is no active task. */
     current_task = NULL;
     task_status_set();
+    prof_leave(prev);
     return any;
 }
 
@@ -2516,8 +2886,6 @@ dump_range(int first, int len, bool in_ascii, struct ea *buf,
     int fa_cs;
     varbuf_t r;
 
-    vb_init(&r);
-
     /*
      * If the client has looked at the live screen, then if they later
      * execute 'Wait(output)', they will need to wait for output from the
@@ -2535,6 +2903,31 @@ dump_range(int first, int len, bool in_ascii, struct ea *buf,
 	set_output_needed(true);
     }
 
+    /* Text from the live screen comes from the text mirror. */
+    if (in_ascii && buf == ea_buf && rel_cols == COLS && first >= 0 &&
+	    first + len <= ROWS * COLS) {
+	screen_text_sync(force_utf8);
+	for (i = 0; i < len; ) {
+	    int col = (first + i) % COLS;
+	    int ncols = COLS - col;
+	    const char *s;
+	    size_t nb;
+
+	    if (ncols > len - i) {
+		ncols = len - i;
+	    }
+	    s = screen_text_span((first + i) / COLS, col, ncols, force_utf8,
+		    &nb);
+	    i += ncols;
+	    any = nb > 0;
+	    if (i < len || any) {
+		action_output("%.*s", (int)nb, s);
+	    }
+	}
+	return any;
+    }
+
+    vb_init_tx(&r);
     attr = find_field_attribute_ea(first, buf);
     is_zero = FA_IS_ZERO(buf[attr].fa);
     fa_cs = buf[attr].cs;
@@ -2547,58 +2940,13 @@ dump_range(int first, int len, bool in_ascii, struct ea *buf,
 	}
 	if (in_ascii) {
 	    char mb[16];
-	    ucs4_t uc;
-	    size_t j;
-	    size_t xlen;
-	    enum dbcs_state d = ctlr_dbcs_state(first + i);
-
-	    if (buf[first + i].fa) {
-		fa_cs = buf[first + i].cs;
-		is_zero = FA_IS_ZERO(buf[first + i].fa);
-		vb_appends(&r, " ");
-	    } else if (is_zero) {
-		vb_appends(&r, " ");
-	    } else if (IS_RIGHT(d)) {
-		if (d == DBCS_RIGHT_WRAP) {
-		    vb_appends(&r, " ");
-		} else {
-		    continue;
-		}
-	    } else {
-		if (is_nvt(&buf[first + i], false, &uc)) {
-		    /* NVT-mode text. */
-		    if (uc >= UPRIV2_Aunderbar && uc <= UPRIV2_Zunderbar) {
-			uc -= UPRIV2;
-		    }
-		    if (toggled(MONOCASE)) {
-			uc = u_toupper(uc);
-		    }
-		    xlen = unicode_to_multibyte_f(uc, mb, sizeof(mb),
-			    force_utf8);
-		    for (j = 0; j < xlen - 1; j++) {
-			vb_appendf(&r, "%c", mb[j]);
-		    }
-		} else {
-		    /* 3270-mode text. */
-		    if (IS_LEFT(d)) {
-			xlen = ebcdic_to_multibyte_f((buf[first + i].ec << 8) |
-				buf[first + i + 1].ec,
-				mb, sizeof(mb), force_utf8);
-			for (j = 0; j < xlen - 1; j++) {
-			    vb_appendf(&r, "%c", mb[j]);
-			}
-		    } else {
-			xlen = ebcdic_to_multibyte_fx(buf[first + i].ec,
-				fa_cs? fa_cs: buf[first + i].cs,
-				mb, sizeof(mb),
-				EUO_BLANK_UNDEF | (toggled(MONOCASE)? EUO_TOUPPER: 0),
-				&uc, force_utf8);
-			for (j = 0; j < xlen - 1; j++) {
-			    vb_appendf(&r, "%c", mb[j]);
-			}
-		    }
-		}
+	    size_t nb = screen_text_cell(buf, first + i, &is_zero, &fa_cs,
+		    force_utf8, mb, sizeof(mb));
+
+	    if (!nb) {
+		continue;
 	    }
+	    vb_append(&r, mb, nb);
 	} else {
 	    ebc_t ebc = 0;
 
@@ -2766,6 +3114,34 @@ AsciiField_action(ia_t ia _is_unused, unsigned argc, const char **argv)
     return dump_field(argc, AnAsciiField, true, IA_UTF8(ia));
 }
 
+/* Report a screen search match. */
+static void
+search_found(int row, int col, int len)
+{
+    action_output("%d %d %d", row, col, len);
+}
+
+/*
+ * Search the screen.
+ * Displays the 0-origin row, column and length of each match.
+ */
+static bool
+Search_action(ia_t ia, unsigned argc, const char **argv)
+{
+    screen_search_t *ss;
+
+    action_debug(AnSearch, ia, argc, argv);
+    if ((ss = screen_search_new(AnSearch, argc, argv, IA_UTF8(ia))) == NULL) {
+	return false;
+    }
+    if (current_task != NULL) {
+	set_output_needed(true);
+    }
+    (void) screen_search(ss, search_found);
+    screen_search_free(ss);
+    return true;
+}
+
 static bool
 Ebcdic_action(ia_t ia _is_unused, unsigned argc, const char **argv)
 {
@@ -3557,6 +3933,83 @@ find_wait_kw(enum task_state state)
     return "Unknown";
 }
 
+/* Count the fields on the screen. */
+static int
+count_fields(void)
+{
+    int baddr;
+    int n = 0;
+
+    if (!formatted) {
+	return 0;
+    }
+    for (baddr = 0; baddr < ROWS * COLS; baddr++) {
+	if (ea_buf[baddr].fa) {
+	    n++;
+	}
+    }
+    return n;
+}
+
+/* Return the 1-origin number of the field containing the cursor, or 0. */
+static int
+cursor_field(void)
+{
+    int fa_addr;
+    int baddr;
+    int n = 0;
+
+    if (!formatted || (fa_addr = find_field_attribute(cursor_addr)) < 0) {
+	return 0;
+    }
+    for (baddr = 0; baddr <= fa_addr; baddr++) {
+	if (ea_buf[baddr].fa) {
+	    n++;
+	}
+    }
+    return n;
+}
+
+/**
+ * Evaluate a Wait() screen condition.
+ *
+ * @param[in] state	Wait state
+ * @param[in] value	Field count, field number or OIA condition
+ *
+ * @return True if the condition holds.
+ */
+static bool
+wait_screen_cond(enum task_state state, int value)
+{
+    switch (state) {
+    case TS_WAIT_FIELD_COUNT:
+	return count_fields() == value;
+    case TS_WAIT_CURSOR_IN_FIELD:
+	return cursor_field() == value;
+    case TS_WAIT_OIA:
+	switch ((enum oia_cond)value) {
+	case OC_LOCKED:
+	    return task_kbwait_state();
+	case OC_UNLOCKED:
+	    return !task_kbwait_state();
+	case OC_FORMATTED:
+	    return formatted;
+	case OC_UNFORMATTED:
+	    return !formatted;
+	case OC_PROTECTED:
+	    return formatted &&
+		FA_IS_PROTECTED(get_field_attribute(cursor_addr));
+	case OC_UNPROTECTED:
+	    return !formatted ||
+		!FA_IS_PROTECTED(get_field_attribute(cursor_addr));
+	}
+	break;
+    default:
+	break;
+    }
+    return false;
+}
+
 /*
  * Wait for various conditions.
  */
@@ -3571,6 +4024,9 @@ Wait_action(ia_t ia _is_unused, unsigned argc, const char **argv)
     int i;
     int match_baddr = -1;
     const char *match_string = NULL;
+    screen_search_t *search = NULL;
+    int match_value = 0;
+    unsigned long l;
     const char *next_why;
 #define CONNECTED_CHECK do { \
     if (next_state != TS_TIME_WAIT && !(CONNECTED || HALF_CONNECTED)) { \
@@ -3615,7 +4071,8 @@ Wait_action(ia_t ia _is_unused, unsigned argc, const char **argv)
 	if (wait_keywords[i].keyword == NULL) {
 	    return action_args_are(AnWait, KwInputField, KwNvtMode, Kw3270Mode,
 		    KwOutput, KwSeconds, KwDisconnect, KwUnlock, KwCursorAt,
-		    KwStringAt, KwInputFieldAt, NULL);
+		    KwStringAt, KwInputFieldAt, KwSearch, KwFieldCount,
+		    KwCursorInField, KwOia, NULL);
 	}
     }
 
@@ -3675,8 +4132,8 @@ Wait_action(ia_t ia _is_unused, unsigned argc, const char **argv)
 	CONNECTED_CHECK;
 	match_string = pr[np - 1];
 	if (match_baddr < ROWS * COLS) {
-	    char *current_string = grab_string(match_baddr,
-		    strlen(match_string), ea_buf, ia == IA_HTTPD);
+	    char *current_string = screen_text_grab(match_baddr,
+		    strlen(match_string), ia == IA_HTTPD);
 
 	    if (!strcmp(current_string, match_string)) {
 		Free(current_string);
@@ -3698,6 +4155,48 @@ Wait_action(ia_t ia _is_unused, unsigned argc, const char **argv)
 	    }
 	}
 	break;
+    case TS_WAIT_SEARCH:
+	CONNECTED_CHECK;
+	search = screen_search_new(AnWait, np - 1, pr + 1, IA_UTF8(ia));
+	if (search == NULL) {
+	    return false;
+	}
+	if (screen_search(search, NULL)) {
+	    screen_search_free(search);
+	    return true;
+	}
+	break;
+    case TS_WAIT_FIELD_COUNT:
+    case TS_WAIT_CURSOR_IN_FIELD:
+	l = strtoul(pr[1], &ptr, 10);
+	if (ptr == pr[1] || *ptr != '\0' || l > (unsigned long)(ROWS * COLS)) {
+	    popup_an_error(AnWait "(%s): Invalid count '%s'",
+		    find_wait_kw(next_state), pr[1]);
+	    return false;
+	}
+	match_value = (int)l;
+	CONNECTED_CHECK;
+	if (wait_screen_cond(next_state, match_value)) {
+	    return true;
+	}
+	break;
+    case TS_WAIT_OIA:
+	for (i = 0; oia_cond_names[i] != NULL; i++) {
+	    if (!strcasecmp(pr[1], oia_cond_names[i])) {
+		break;
+	    }
+	}
+	if (oia_cond_names[i] == NULL) {
+	    return action_args_are(AnWait, KwLocked, KwUnlocked,
+		    KwFormatted, KwUnformatted, KwProtected, KwUnprotected,
+		    NULL);
+	}
+	match_value = i;
+	CONNECTED_CHECK;
+	if (wait_screen_cond(next_state, match_value)) {
+	    return true;
+	}
+	break;
     default:
 	break;
     }
@@ -3711,6 +4210,11 @@ Wait_action(ia_t ia _is_unused, unsigned argc, const char **argv)
 	task_set_match(current_task, match_baddr, match_string,
 		ia == IA_HTTPD);
     }
+    if (search != NULL) {
+	screen_search_free(current_task->match.search);
+	current_task->match.search = search;
+    }
+    current_task->match.value = match_value;
 
     /* Set up a timeout, if they want one. */
     if (tmo >= 0.0) {
@@ -3802,6 +4306,7 @@ task_host_output(void)
     taskq_t *q;
 
     set_output_needed(false);
+    task_wake(TE_OUTPUT | TE_SCREEN);
 
     FOREACH_LLIST(&taskq, q, taskq_t *) {
 	task_t *s;
@@ -3988,6 +4493,7 @@ task_store(unsigned char c)
     if (nvt_save_cnt < NVT_SAVE_SIZE) {
 	nvt_save_cnt++;
     }
+    task_wake(TE_OUTPUT);
 }
 
 /* Dump whatever NVT data has been sent by the host since last called. */
@@ -4458,6 +4964,39 @@ Bell_action(ia_t ia, unsigned argc, const char **argv)
     return true;
 }
 
+/*
+ * Batch action, used to run the rest of a command in batch mode: each
+ * following action reports its own status, and with the Continue option,
+ * a failed action does not stop the ones after it.
+ *
+ * Batch([StopOnError|Continue])
+ */
+static bool
+Batch_action(ia_t ia, unsigned argc, const char **argv)
+{
+    bool cont = false;
+
+    action_debug(AnBatch, ia, argc, argv);
+    if (check_argc(AnBatch, argc, 0, 1) < 0) {
+	return false;
+    }
+    if (argc > 0) {
+	if (!strcasecmp(argv[0], KwContinue)) {
+	    cont = true;
+	} else if (strcasecmp(argv[0], KwStopOnError)) {
+	    return action_args_are(AnBatch, KwStopOnError, KwContinue, NULL);
+	}
+    }
+    if (current_task == NULL || current_task->type != ST_MACRO) {
+	popup_an_error(AnBatch "() can only be called from scripts");
+	return false;
+    }
+
+    current_task->macro.batch.active = true;
+    current_task->macro.batch.cont = cont;
+    return true;
+}
+
 /* Tasks action, dumps out the current task state. */
 char *
 task_get_tasks(void)
@@ -4498,6 +5037,30 @@ task_get_tasks(void)
     return vb_consume(&r);
 }
 
+/**
+ * Count the active tasks.
+ *
+ * @param[out] queues	Number of task queues
+ * @param[out] tasks	Number of tasks on all queues
+ * @param[out] waiting	Number of queues whose top task is blocked
+ */
+void
+task_stats(unsigned *queues, unsigned *tasks, unsigned *waiting)
+{
+    taskq_t *q;
+
+    *queues = 0;
+    *tasks = 0;
+    *waiting = 0;
+    FOREACH_LLIST(&taskq, q, taskq_t *) {
+	(*queues)++;
+	*tasks += q->depth;
+	if (q->top != NULL && q->top->state >= MIN_WAITING_STATE) {
+	    (*waiting)++;
+	}
+    } FOREACH_LLIST_END(&taskq, q, taskq_t *);
+}
+
 /* Capabilities action, sets flags in the current CB. */
 static bool
 Capabilities_action(ia_t ia, unsigned argc, const char **argv)
@@ -75,6 +75,7 @@
 #include "nhp.h"
 #include "nvt.h"
 #include "popups.h"
+#include "profile.h"
 #include "proxy.h"
 #include "proxy_names.h"
 #include "query.h"
@@ -122,6 +123,9 @@
 
 #define LINEMODE_NAME	"lineMode"
 
+#define XQ_HIGH_WATER	(64 * 1024)	/* stop reading the host above this */
+#define XQ_LOW_WATER	(16 * 1024)	/* resume reading below this */
+
 #if !defined(LOCAL_PROCESS) /*[*/
 # define local_process false
 #endif /*]*/
@@ -133,6 +137,7 @@ int             ns_brcvd;
 int             ns_rrcvd;
 int             ns_bsent;
 int             ns_rsent;
+size_t          ns_bqueued;	/* bytes waiting in the transmit queue */
 unsigned char  *obuf;		/* 3270 output buffer */
 unsigned char  *obptr = (unsigned char *) NULL;
 bool            linemode = true;
@@ -170,6 +175,13 @@ static int      syncing;
 static ioid_t output_id = NULL_IOID;
 #endif /*]*/
 static ioid_t	connect_timeout_id = NULL_IOID;	/* explicit Connect timeout */
+static unsigned char *xq_buf = NULL;	/* transmit queue */
+static size_t	xq_size = 0;		/* allocated size of xq_buf */
+static size_t	xq_start = 0;		/* offset of first unsent byte */
+static size_t	xq_end = 0;		/* offset past last unsent byte */
+static int	xq_corked = 0;		/* cork nesting depth */
+static ioid_t	xq_id = NULL_IOID;	/* output-possible callback */
+static bool	xq_throttled = false;	/* host input paused for output */
 static ioid_t	nop_timeout_id = NULL_IOID;
 static char     ttype_tmpval[13];
 
@@ -228,10 +240,15 @@ static ntim_t parse_ntim(const char *value);
 
 static bool telnet_fsm(unsigned char c, bool *eor);
 static void net_rawout(unsigned const char *buf, size_t len);
+static void net_xmit(void);
+static void net_cork(void);
+static void net_uncork(void);
+static void xq_reset(void);
+static void xq_throttle(void);
 static void check_in3270(void);
 static void store3270in(unsigned char c);
 static void check_linemode(bool init);
-static int non_blocking(void);
+static int non_blocking(socket_t s);
 static void net_connected(void);
 static void connection_complete(void);
 static int tn3270e_negotiate(void);
@@ -331,6 +348,9 @@ static bool need_tls_follows = false;
 
 static bool net_connect_pending;
 
+static unsigned long tls_handshakes = 0;	/* completed TLS handshakes */
+static unsigned long tls_resumed = 0;	/* ...of which resumed a session */
+
 #if !defined(_WIN32) /*[*/
 static void output_possible(iosrc_t fd, ioid_t id);
 #endif /*]*/
@@ -341,8 +361,31 @@ static socklen_t ha_len[NUM_HA] = {
     sizeof(haddr[0]), sizeof(haddr[0]), sizeof(haddr[0]), sizeof(haddr[0])
 };
 static int num_ha = 0;
-static int ha_ix = 0;
+static int ha_ix = 0;		/* address in use by sock */
+static int ha_next = 0;		/* next address not yet tried */
 static rp_t host_rp = NULL;
+
+#if !defined(_WIN32) /*[*/
+/*
+ * Staggered parallel connection attempts ("happy eyeballs"). While the
+ * attempt on sock is pending, the next address is tried after a short delay,
+ * and so on. The first attempt to complete wins, and the others are closed.
+ */
+typedef struct {
+    socket_t s;			/* socket, or INVALID_SOCKET if not in use */
+    int ix;			/* index in haddr[] */
+    ioid_t id;			/* output-possible callback */
+} racer_t;
+static racer_t racers[NUM_HA] = {
+    { INVALID_SOCKET, 0, NULL_IOID }, { INVALID_SOCKET, 0, NULL_IOID },
+    { INVALID_SOCKET, 0, NULL_IOID }, { INVALID_SOCKET, 0, NULL_IOID }
+};
+static ioid_t race_id = NULL_IOID;	/* staggered start timeout */
+static bool race_active(void);
+static void race_arm(void);
+static bool race_promote(void);
+static void race_cancel(void);
+#endif /*]*/
 static rp_t proxy_rp = NULL;
 
 /* EOR processing resumption state. */
@@ -355,6 +398,7 @@ typedef struct {
 } eor_resume_t;
 static eor_resume_t eor_resume;
 static ioid_t eor_id = NULL_IOID;
+static bool eor_suspended = false;	/* input suspended at an EOR */
 
 void
 popup_a_sockerr(const char *fmt, ...)
@@ -377,10 +421,16 @@ connect_timed_out(ioid_t id _is_unused)
     host_disconnect(true);
 }
 
-/* Connect to one of the addresses in haddr[]. */
+/*
+ * Connect to one of the addresses in haddr[].
+ * If 'racer' is true, this is a staggered parallel attempt: the socket is
+ * returned without being stored in sock, and the caller is responsible for
+ * watching it for completion.
+ */
 static socket_t
-connect_to(int ix, bool noisy, bool *pending)
+connect_to(int ix, bool noisy, bool racer, bool *pending)
 {
+    socket_t		s;
     int			on = 1;
     char		hn[256];
     char		pn[256];
@@ -390,45 +440,63 @@ connect_to(int ix, bool noisy, bool *pending)
 #if defined(OMTU) /*[*/
     int			mtu = OMTU;
 #endif /*]*/
-#   define close_fail	{ SOCK_CLOSE(sock); \
-    			  sock = INVALID_SOCKET; \
+    const char		*sndbuf;
+#   define close_fail	{ SOCK_CLOSE(s); \
+			  if (!racer) { \
+			      sock = INVALID_SOCKET; \
+			  } \
 			  return INVALID_SOCKET; \
 			}
 
+    *pending = false;
+
     /* create the socket */
-    if ((sock = socket(haddr[ix].sa.sa_family, SOCK_STREAM, IPPROTO_TCP)) == INVALID_SOCKET) {
+    if ((s = socket(haddr[ix].sa.sa_family, SOCK_STREAM, IPPROTO_TCP)) == INVALID_SOCKET) {
 	popup_a_sockerr("socket");
 	return INVALID_SOCKET;
     }
+    if (!racer) {
+	sock = s;
+    }
 
     /* set options for inline out-of-band data and keepalives */
-    if (setsockopt(sock, SOL_SOCKET, SO_OOBINLINE, (char *)&on,
+    if (setsockopt(s, SOL_SOCKET, SO_OOBINLINE, (char *)&on,
 		sizeof(on)) < 0) {
 	popup_a_sockerr("setsockopt(SO_OOBINLINE)");
 	close_fail;
     }
-    if (setsockopt(sock, SOL_SOCKET, SO_KEEPALIVE, (char *)&on,
+    if (setsockopt(s, SOL_SOCKET, SO_KEEPALIVE, (char *)&on,
 		sizeof(on)) < 0) {
 	popup_a_sockerr("setsockopt(SO_KEEPALIVE)");
 	close_fail;
     }
 #if defined(OMTU) /*[*/
-    if (setsockopt(sock, SOL_SOCKET, SO_SNDBUF, (char *)&mtu,
+    if (setsockopt(s, SOL_SOCKET, SO_SNDBUF, (char *)&mtu,
 		sizeof(mtu)) < 0) {
 	popup_a_sockerr("setsockopt(SO_SNDBUF)");
 	close_fail;
     }
 #endif /*]*/
+    if ((sndbuf = ut_getenv("SNDBUF")) != NULL) {
+	int size = atoi(sndbuf);
+
+	/* Shrink the send buffer, to test output queueing. */
+	if (setsockopt(s, SOL_SOCKET, SO_SNDBUF, (char *)&size,
+		    sizeof(size)) < 0) {
+	    popup_a_sockerr("setsockopt(SO_SNDBUF)");
+	    close_fail;
+	}
+    }
 
     /* set the socket to be non-delaying */
-    if (ut_getenv("BLOCKING_CONNECT") == NULL && non_blocking() < 0) {
+    if (ut_getenv("BLOCKING_CONNECT") == NULL && non_blocking(s) < 0) {
 	popup_an_error("non-blocking failure");
 	close_fail;
     }
 
 #if !defined(_WIN32) /*[*/
     /* don't share the socket with our children */
-    fcntl(sock, F_SETFD, 1);
+    fcntl(s, F_SETFD, 1);
 #endif /*]*/
 
     /* Init TLS. */
@@ -446,14 +514,17 @@ connect_to(int ix, bool noisy, bool *pending)
 
     if (numeric_host_and_port(&haddr[ix].sa, ha_len[ix], hn, sizeof(hn), pn,
 		sizeof(pn), &errmsg)) {
-	vctrace(TC_SOCKET, "Trying %s, port %s...\n", hn, pn);
+	vctrace(TC_SOCKET, "Trying %s, port %s%s...\n", hn, pn,
+		racer? " in parallel": "");
 	telnet_gui_connecting(hn, pn);
-	Replace(numeric_host, NewString(hn));
-	Replace(numeric_port, NewString(pn));
+	if (!racer) {
+	    Replace(numeric_host, NewString(hn));
+	    Replace(numeric_port, NewString(pn));
+	}
     }
 
     /* Set an explicit timeout, if configured. */
-    if (appres.connect_timeout) {
+    if (!racer && appres.connect_timeout) {
 	connect_timeout_id = AddTimeOut(appres.connect_timeout * 1000,
 		connect_timed_out);
     }
@@ -478,12 +549,14 @@ connect_to(int ix, bool noisy, bool *pending)
     }
 
     /* connect */
-    if (connect(sock, &haddr[ix].sa, ha_len[ix]) == -1) {
+    if (connect(s, &haddr[ix].sa, ha_len[ix]) == -1) {
 	if (IS_EWOULDBLOCK(socket_errno()) || IS_EINPROGRESS(socket_errno())) {
 	    vctrace(TC_SOCKET, "TCP connection pending.\n");
 	    *pending = true;
 #if !defined(_WIN32) /*[*/
-	    output_id = AddOutput(sock, output_possible);
+	    if (!racer) {
+		output_id = AddOutput(sock, output_possible);
+	    }
 #endif /*]*/
 	} else {
 	    if (noisy) {
@@ -494,7 +567,7 @@ connect_to(int ix, bool noisy, bool *pending)
 	    }
 	    close_fail;
 	}
-    } else {
+    } else if (!racer) {
 	net_connected();
 
 	/* net_connected() can cause the connection to fail. */
@@ -504,7 +577,105 @@ connect_to(int ix, bool noisy, bool *pending)
     }
 
     /* all done */
-    return sock;
+    return s;
+#   undef close_fail
+}
+
+/*
+ * Copy resolved addresses into haddr[], interleaving the address families so
+ * that staggered connection attempts alternate between IPv6 and IPv4.
+ */
+static void
+copy_haddrs(rp_t rp, int max)
+{
+    int n = rp_num_ha(rp);
+    int first[NUM_HA], other[NUM_HA];
+    int n_first = 0, n_other = 0;
+    int i;
+
+    if (n > NUM_HA) {
+	n = NUM_HA;
+    }
+    for (i = 0; i < n; i++) {
+	if (rp_haddr(rp, i)->sa.sa_family == rp_haddr(rp, 0)->sa.sa_family) {
+	    first[n_first++] = i;
+	} else {
+	    other[n_other++] = i;
+	}
+    }
+
+    num_ha = 0;
+    for (i = 0; i < n_first || i < n_other; i++) {
+	if (i < n_first) {
+	    memcpy(&haddr[num_ha], rp_haddr(rp, first[i]), sizeof(sockaddr_46_t));
+	    ha_len[num_ha++] = rp_ha_len(rp, first[i]);
+	}
+	if (i < n_other) {
+	    memcpy(&haddr[num_ha], rp_haddr(rp, other[i]), sizeof(sockaddr_46_t));
+	    ha_len[num_ha++] = rp_ha_len(rp, other[i]);
+	}
+    }
+    if (num_ha > max) {
+	num_ha = max;
+    }
+    ha_ix = 0;
+    ha_next = 0;
+}
+
+/* Try each of the untried addresses in haddr[], until one starts. */
+static socket_t
+connect_next(bool *pending)
+{
+    socket_t s;
+
+    while (ha_next < num_ha) {
+	ha_ix = ha_next++;
+	if ((s = connect_to(ha_ix, ha_next == num_ha, false, pending)) != INVALID_SOCKET) {
+#if !defined(_WIN32) /*[*/
+	    if (*pending) {
+		race_arm();
+	    }
+#endif /*]*/
+	    return s;
+	}
+    }
+    return INVALID_SOCKET;
+}
+
+/* Returns true if there are more addresses to try. */
+static bool
+more_addresses(void)
+{
+#if !defined(_WIN32) /*[*/
+    if (race_active()) {
+	return true;
+    }
+#endif /*]*/
+    return ha_next < num_ha;
+}
+
+/*
+ * The connection attempt on sock failed and has been cleaned up. Move on to a
+ * parallel attempt already in progress, or to the next address.
+ * Returns true if another attempt is in progress.
+ */
+static bool
+connect_next_address(void)
+{
+    bool pending;
+    socket_t s;
+
+#if !defined(_WIN32) /*[*/
+    if (race_promote()) {
+	return true;
+    }
+#endif /*]*/
+    if ((s = connect_next(&pending)) != INVALID_SOCKET) {
+	host_newfd(s);
+	host_new_connection(pending);
+	return true;
+    }
+    return false;
 }
 
 /* Complete a connection, now that the hostname has been resolved. */
@@ -512,11 +683,12 @@ static net_connect_t
 finish_connect(socket_t *socket)
 {
     socket_t s;
+    bool pending = false;
+
+    ha_next = 0;
 
     /* Set up the TLS context, whether this is an TLS host or not. */
     if (sio_supported()) {
-	bool pending = false;
-
 	sio = sio_init_wrapper(NULL, HOST_FLAG(NO_VERIFY_CERT_HOST),
 		net_accept, &pending);
 	if (sio == NULL) {
@@ -530,15 +702,9 @@ finish_connect(socket_t *socket)
     }
 
     /* Try each of the haddrs. */
-    ha_ix = 0;
-    while (ha_ix < num_ha) {
-	bool pending = false;
-
-	if ((s = connect_to(ha_ix, (ha_ix == num_ha - 1), &pending)) != INVALID_SOCKET) {
-	    *socket = s;
-	    return pending? NC_CONNECT_PENDING: NC_CONNECTED;
-	}
-	ha_ix++;
+    if ((s = connect_next(&pending)) != INVALID_SOCKET) {
+	*socket = s;
+	return pending? NC_CONNECT_PENDING: NC_CONNECTED;
     }
 
     /* Ran out. */
@@ -549,7 +715,6 @@ finish_connect(socket_t *socket)
 static void
 resolve_complete(rp_t rp, void *context, bool success, const char *errmsg)
 {
-    int i;
     net_connect_t nc;
     socket_t socket = INVALID_SOCKET;
 
@@ -560,14 +725,7 @@ resolve_complete(rp_t rp, void *context, bool success, const char *errmsg)
     }
 
     current_port = rp_port(rp);
-    num_ha = rp_num_ha(rp);
-    if (num_ha > NUM_HA) {
-	num_ha = NUM_HA;
-    }
-    memcpy(haddr, rp_haddr(rp, 0), num_ha * sizeof(sockaddr_46_t));
-    for (i = 0; i < num_ha; i++) {
-	ha_len[i] = rp_ha_len(rp, i);
-    }
+    copy_haddrs(rp, NUM_HA);
 
     nc = finish_connect(&socket);
     if (nc == NC_FAILED) {
@@ -581,7 +739,6 @@ resolve_complete(rp_t rp, void *context, bool success, const char *errmsg)
 static void
 proxy_resolve_complete(rp_t rp, void *context, bool success, const char *errmsg)
 {
-    int i;
     net_connect_t nc;
     socket_t socket = INVALID_SOCKET;
 
@@ -592,15 +749,7 @@ proxy_resolve_complete(rp_t rp, void *context, bool success, const char *errmsg)
     }
 
     proxy_port = rp_port(rp);
-    num_ha = rp_num_ha(rp);
-    if (num_ha > NUM_HA) {
-	num_ha = NUM_HA;
-    }
-    memcpy(haddr, rp_haddr(rp, 0), num_ha * sizeof(sockaddr_46_t));
-    for (i = 0; i < num_ha; i++) {
-	ha_len[i] = rp_ha_len(rp, i);
-    }
-    num_ha = 1; /* XXX: We only try one. */
+    copy_haddrs(rp, 1); /* XXX: We only try one. */
 
     nc = finish_connect(&socket);
     if (nc == NC_FAILED) {
@@ -729,10 +878,7 @@ net_connect(const char *host, char *portname, char *accept, bool ls, socket_t *s
 	}
 
 	/* Resolved synchronously. */
-	num_ha = 1;
-	memcpy(haddr, rp_haddr(proxy_rp, 0), sizeof(sockaddr_46_t));
-	ha_len[0] = rp_ha_len(proxy_rp, 0);
-	ha_ix = 0;
+	copy_haddrs(proxy_rp, 1);
     } else {
 #if defined(LOCAL_PROCESS) /*[*/
 	if (ls) {
@@ -740,7 +886,6 @@ net_connect(const char *host, char *portname, char *accept, bool ls, socket_t *s
 	} else {
 #endif /*]*/
 	    rp_result_t rv;
-	    int i;
 
 	    if (host_rp == NULL) {
 		host_rp = rp_alloc(NULL, resolve_complete);
@@ -763,15 +908,7 @@ net_connect(const char *host, char *portname, char *accept, bool ls, socket_t *s
 
 	    /* Synchronous success. */
 	    current_port = rp_port(host_rp);
-	    num_ha = rp_num_ha(host_rp);
-	    if (num_ha > NUM_HA) {
-		num_ha = NUM_HA;
-	    }
-	    memcpy(haddr, rp_haddr(host_rp, 0), num_ha * sizeof(sockaddr_46_t));
-	    for (i = 0; i < num_ha; i++) {
-		ha_len[i] = rp_ha_len(host_rp, i);
-	    }
-	    ha_ix = 0;
+	    copy_haddrs(host_rp, NUM_HA);
 #if defined(LOCAL_PROCESS) /*[*/
 	}
 #endif /*]*/
@@ -790,7 +927,7 @@ net_connect(const char *host, char *portname, char *accept, bool ls, socket_t *s
 	switch (forkpty(&amaster, NULL, NULL, &w)) {
 	case -1:	/* failed */
 	    connect_errno(errno, "forkpty");
-	    close_fail;
+	    return NC_FAILED;
 	case 0:	/* child */
 	    putenv(Asprintf("TERM=%s",
 		appres.termname?
@@ -825,7 +962,6 @@ net_connect(const char *host, char *portname, char *accept, bool ls, socket_t *s
 
     return finish_connect(socket);
 }
-#undef close_fail
 
 /* Set up the LU list. */
 static void
@@ -966,6 +1102,16 @@ net_connected_complete(void)
     }
 }
 
+/* Count a completed TLS handshake. */
+static void
+count_tls_handshake(void)
+{
+    tls_handshakes++;
+    if (sio_session_resumed(sio)) {
+	tls_resumed++;
+    }
+}
+
 /* Callback for asynchronous proxy failures. */
 static void
 net_proxy_disconnect(void)
@@ -984,11 +1130,16 @@ net_connected(void)
 	connect_timeout_id = NULL_IOID;
     }
 
+#if !defined(_WIN32) /*[*/
+    /* Abandon any parallel connection attempts. */
+    race_cancel();
+#endif /*]*/
+
     if (cstate != TLS_PENDING && !proxy_pending) {
 	vctrace(TC_SOCKET, "Connected to %s, port %u.\n", hostname, current_port);
     }
 
-    if (ut_getenv("BLOCKING_CONNECT") != NULL && non_blocking() < 0) {
+    if (ut_getenv("BLOCKING_CONNECT") != NULL && non_blocking(sock) < 0) {
 	connect_error("non-blocking failure");
 	host_disconnect(true);
 	return;
@@ -1045,6 +1196,7 @@ net_connected(void)
 		sio_provider(), session, cert);
 	Free(session);
 	Free(cert);
+	count_tls_handshake();
 	st_changed(ST_SECURE, true);
 
 	/* Tell everyone else again. */
@@ -1086,14 +1238,9 @@ net_password_continue(const char *password)
     }
 
     /* Try connecting. */
-    while (ha_ix < num_ha) {
-	s = connect_to(ha_ix, (ha_ix == num_ha - 1), &pending);
-	if (s != INVALID_SOCKET) {
-	    host_newfd(s);
-	    host_new_connection(pending);
-	    break;
-	}
-	ha_ix++;
+    if ((s = connect_next(&pending)) != INVALID_SOCKET) {
+	host_newfd(s);
+	host_new_connection(pending);
     }
 }
 
@@ -1157,6 +1304,9 @@ net_pre_close(const char *why)
 
     /* We have no more interest in output buffer space. */
     remove_output();
+
+    /* Anything still waiting to be sent is lost. */
+    xq_reset();
 }
 
 #if !defined(_WIN32) /*[*/
@@ -1185,15 +1335,8 @@ output_possible(iosrc_t fd _is_unused, ioid_t id _is_unused)
 	if (getsockopt(sock, SOL_SOCKET, SO_ERROR, &e, &len) >= 0) {
 	    vctrace(TC_SOCKET, "RCVD socket error %d (%s)\n", e, strerror(e));
 	    net_pre_close("output_possible: async error");
-	    while (++ha_ix < num_ha) {
-		bool pending;
-		socket_t s = connect_to(ha_ix, (ha_ix == num_ha - 1), &pending);
-
-		if (s != INVALID_SOCKET) {
-		    host_newfd(s);
-		    host_new_connection(pending);
-		    return;
-		}
+	    if (connect_next_address()) {
+		return;
 	    }
 	    connect_errno(e, "%s%s, port %d",
 			(proxy_type != PT_NONE)? "Proxy ": "",
@@ -1213,6 +1356,205 @@ output_possible(iosrc_t fd _is_unused, ioid_t id _is_unused)
 }
 #endif /*]*/
 
+#if !defined(_WIN32) /*[*/
+/* Returns true if any parallel connection attempts are in progress. */
+static bool
+race_active(void)
+{
+    int i;
+
+    for (i = 0; i < NUM_HA; i++) {
+	if (racers[i].s != INVALID_SOCKET) {
+	    return true;
+	}
+    }
+    return false;
+}
+
+/* Close a parallel connection attempt. */
+static void
+race_close(racer_t *r)
+{
+    RemoveInput(r->id);
+    r->id = NULL_IOID;
+    SOCK_CLOSE(r->s);
+    r->s = INVALID_SOCKET;
+}
+
+/* Cancel all parallel connection attempts. */
+static void
+race_cancel(void)
+{
+    int i;
+
+    if (race_id != NULL_IOID) {
+	RemoveTimeOut(race_id);
+	race_id = NULL_IOID;
+    }
+    for (i = 0; i < NUM_HA; i++) {
+	if (racers[i].s != INVALID_SOCKET) {
+	    vctrace(TC_SOCKET, "Canceling parallel connection attempt %d\n",
+		    racers[i].ix);
+	    race_close(&racers[i]);
+	}
+    }
+}
+
+/* Make a parallel connection attempt the one on sock. */
+static void
+race_adopt(racer_t *r)
+{
+    char hn[256];
+    char pn[256];
+
+    RemoveInput(r->id);
+    r->id = NULL_IOID;
+    sock = r->s;
+    r->s = INVALID_SOCKET;
+    ha_ix = r->ix;
+
+    if (numeric_host_and_port(&haddr[ha_ix].sa, ha_len[ha_ix], hn, sizeof(hn),
+		pn, sizeof(pn), NULL)) {
+	Replace(numeric_host, NewString(hn));
+	Replace(numeric_port, NewString(pn));
+    }
+    host_newfd(sock);
+}
+
+static void race_start(void);
+
+/* Time to start the next staggered connection attempt. */
+static void
+race_timeout(ioid_t id _is_unused)
+{
+    race_id = NULL_IOID;
+    race_start();
+}
+
+/* Schedule the next staggered connection attempt. */
+static void
+race_arm(void)
+{
+    if (appres.connect_attempt_delay > 0 && ha_next < num_ha &&
+	    race_id == NULL_IOID) {
+	race_id = AddTimeOut(appres.connect_attempt_delay, race_timeout);
+    }
+}
+
+/*
+ * A parallel connection attempt has completed, one way or the other.
+ * If it succeeded, it replaces the attempt on sock and the rest are abandoned.
+ */
+static void
+race_output_possible(iosrc_t fd _is_unused, ioid_t id)
+{
+    racer_t *r = NULL;
+    sockaddr_46_t sa;
+    socklen_t len = sizeof(sa);
+    socket_t old;
+    int i;
+
+    for (i = 0; i < NUM_HA; i++) {
+	if (racers[i].s != INVALID_SOCKET && racers[i].id == id) {
+	    r = &racers[i];
+	    break;
+	}
+    }
+    if (r == NULL) {
+	return;
+    }
+
+    if (getpeername(r->s, &sa.sa, &len) < 0) {
+	int e = 0;
+	socklen_t elen = sizeof(e);
+
+	getsockopt(r->s, SOL_SOCKET, SO_ERROR, &e, &elen);
+	vctrace(TC_SOCKET, "RCVD socket error %d (%s) on parallel connection "
+		"attempt %d\n", e, strerror(e), r->ix);
+	race_close(r);
+
+	/* Don't wait for the delay to start the next one. */
+	if (race_id != NULL_IOID) {
+	    RemoveTimeOut(race_id);
+	    race_id = NULL_IOID;
+	}
+	race_start();
+	return;
+    }
+
+    vctrace(TC_SOCKET, "Parallel connection attempt %d won\n", r->ix);
+    remove_output();
+    old = sock;
+    race_adopt(r);
+    SOCK_CLOSE(old);
+    race_cancel();
+    if (cstate == TCP_PENDING) {
+	connection_complete();
+    }
+}
+
+/* Start the next staggered connection attempt. */
+static void
+race_start(void)
+{
+    while (ha_next < num_ha) {
+	int ix = ha_next++;
+	bool pending;
+	socket_t s = connect_to(ix, false, true, &pending);
+	int i;
+
+	if (s == INVALID_SOCKET) {
+	    continue;
+	}
+	for (i = 0; racers[i].s != INVALID_SOCKET; i++) {
+	}
+	racers[i].s = s;
+	racers[i].ix = ix;
+	racers[i].id = AddOutput(s, race_output_possible);
+	break;
+    }
+    race_arm();
+}
+
+/*
+ * The connection attempt on sock failed and has been cleaned up. Promote the
+ * oldest parallel attempt, if any, to take its place.
+ * Returns true if one was promoted.
+ */
+static bool
+race_promote(void)
+{
+    racer_t *r = NULL;
+    int i;
+
+    for (i = 0; i < NUM_HA; i++) {
+	if (racers[i].s != INVALID_SOCKET && (r == NULL || racers[i].ix < r->ix)) {
+	    r = &racers[i];
+	}
+    }
+    if (r == NULL) {
+	return false;
+    }
+
+    vctrace(TC_SOCKET, "Continuing with parallel connection attempt %d\n",
+	    r->ix);
+    race_adopt(r);
+    output_id = AddOutput(sock, output_possible);
+    if (appres.connect_timeout) {
+	connect_timeout_id = AddTimeOut(appres.connect_timeout * 1000,
+		connect_timed_out);
+    }
+
+    /* Don't wait for the delay to start the next one. */
+    if (race_id != NULL_IOID) {
+	RemoveTimeOut(race_id);
+	race_id = NULL_IOID;
+    }
+    race_start();
+    return true;
+}
+#endif /*]*/
+
 
 /*
  * net_disconnect
@@ -1232,6 +1574,9 @@ net_disconnect(bool including_tls)
     }
 
     net_pre_close("net_disconnect");
+#if !defined(_WIN32) /*[*/
+    race_cancel();
+#endif /*]*/
 
     net_connect_pending = false;
 
@@ -1252,6 +1597,7 @@ net_disconnect(bool including_tls)
     if (eor_id != NULL_IOID) {
 	RemoveTimeOut(eor_id);
 	eor_id = NULL_IOID;
+	eor_suspended = false;
     }
 
     /* We're not connected to an LU any more. */
@@ -1298,21 +1644,25 @@ net_eor_resume(ioid_t id _is_unused)
 
     eor_id = NULL_IOID;
 
+    net_cork();
     for (cp = netrbuf + res.offset; cp < netrbuf + res.buflen; cp++) {
 	bool eor = false;
 
 	if (!telnet_fsm(*cp, &eor)) {
 	    ctlr_dbcs_postprocess();
 	    host_disconnect(true);
+	    net_uncork();
 	    return;
 	}
 	if (eor && cp < netrbuf + res.buflen - 1) {
+	    net_uncork();
 	    trace_rollover_check();
 	    eor_resume.offset = (cp + 1) - netrbuf;
 	    eor_id = AddTimeOut(0, net_eor_resume);
 	    return;
 	}
     }
+    net_uncork();
 
 #if defined(_WIN32) /*[*/
     if (res.close) {
@@ -1322,7 +1672,8 @@ net_eor_resume(ioid_t id _is_unused)
 #endif /*]*/
 
     /* We've exhausted the input, start listening again. */
-    if (PCONNECTED) {
+    eor_suspended = false;
+    if (PCONNECTED && !xq_throttled) {
 	vctrace(TC_SOCKET, "eor_resume: buffer exhausted, resuming input\n");
 	x_add_input(sock);
     }
@@ -1352,7 +1703,7 @@ net_input(iosrc_t fd _is_unused, ioid_t id _is_unused)
      * Note that WSAEventSelect does this automatically (and won't allow
      * us to change it back to blocking), except on Wine.
      */
-    if (sock != INVALID_SOCKET && non_blocking() < 0) {
+    if (sock != INVALID_SOCKET && non_blocking(sock) < 0) {
 	host_disconnect(true);
 	return;
     }
@@ -1369,24 +1720,16 @@ net_input(iosrc_t fd _is_unused, ioid_t id _is_unused)
 	    if (events.iErrorCode[FD_CONNECT_BIT] != 0) {
 		vctrace(TC_SOCKET, "RCVD socket error %d (%s)\n", events.iErrorCode[FD_CONNECT_BIT],
 			win32_strerror(events.iErrorCode[FD_CONNECT_BIT]));
-		if (ha_ix == num_ha - 1) {
+		if (!more_addresses()) {
 		    connect_error("%s%s, port %d: %s",
 			    (proxy_type != PT_NONE)? "Proxy ": "",
 			    (proxy_type != PT_NONE)? proxy_host : hostname,
 			    (proxy_type != PT_NONE)? proxy_port : current_port,
 			    win32_strerror(events.iErrorCode[FD_CONNECT_BIT]));
 		} else {
-		    bool pending;
-		    socket_t s;
-
 		    net_pre_close("net_input: next connect attempt");
-		    while (++ha_ix < num_ha) {
-			s = connect_to(ha_ix, (ha_ix == num_ha - 1), &pending);
-			if (s != INVALID_SOCKET) {
-			    host_newfd(s);
-			    host_new_connection(pending);
-			    return;
-			}
+		    if (connect_next_address()) {
+			return;
 		    }
 		}
 		host_disconnect(true);
@@ -1491,23 +1834,15 @@ net_input(iosrc_t fd _is_unused, ioid_t id _is_unused)
 	vctrace(TC_SOCKET, "RCVD socket error %d (%s)\n", socket_errno(),
 		socket_strerror(socket_errno()));
 	if (cstate == TCP_PENDING) {
-	    if (ha_ix == num_ha - 1) {
+	    if (!more_addresses()) {
 		popup_a_sockerr("%s%s, port %d",
 			(proxy_type != PT_NONE)? "Proxy ": "",
 			(proxy_type != PT_NONE)? proxy_host : hostname,
 			(proxy_type != PT_NONE)? proxy_port : current_port);
 	    } else {
-		bool pending;
-		socket_t s;
-
 		net_pre_close("net_input: next connect attempt");
-		while (++ha_ix < num_ha) {
-		    s = connect_to(ha_ix, (ha_ix == num_ha - 1), &pending);
-		    if (s != INVALID_SOCKET) {
-			host_newfd(s);
-			host_new_connection(pending);
-			return;
-		    }
+		if (connect_next_address()) {
+		    return;
 		}
 	    }
 	} else if (socket_errno() != SE_ECONNRESET) {
@@ -1534,6 +1869,12 @@ net_input(iosrc_t fd _is_unused, ioid_t id _is_unused)
 
     ns_brcvd += nr;
     stats_poke();
+
+    /*
+     * Hold replies until the whole buffer has been processed, so that
+     * negotiation responses and the like go out together.
+     */
+    net_cork();
     for (cp = netrbuf; cp < (netrbuf + nr); cp++) {
 #if defined(LOCAL_PROCESS) /*[*/
 	if (local_process) {
@@ -1551,12 +1892,33 @@ net_input(iosrc_t fd _is_unused, ioid_t id _is_unused)
 #endif /*]*/
 	    bool eor = false;
 
+	    /*
+	     * Hand runs of printable NVT text to the NVT engine in one call.
+	     * They do not need anything from the telnet state machine except
+	     * tracing, so only do this when tracing is off.
+	     */
+	    if (telnet_state == TNS_DATA && IN_NVT && !IN_E && !syncing &&
+		    !toggled(TRACING)) {
+		unsigned char *end = cp;
+
+		while (end < netrbuf + nr && *end >= ' ' && *end < 0x7f) {
+		    end++;
+		}
+		if (end - cp > 1) {
+		    nvt_process_run(cp, end - cp);
+		    cp = end - 1;
+		    continue;
+		}
+	    }
+
 	    if (!telnet_fsm(*cp, &eor)) {
 		ctlr_dbcs_postprocess();
 		host_disconnect(true);
+		net_uncork();
 		return;
 	    }
 	    if (eor && cp < netrbuf + nr - 1) {
+		net_uncork();
 		trace_rollover_check();
 		x_remove_input();
 		eor_resume.offset = (cp + 1) - netrbuf;
@@ -1567,12 +1929,14 @@ net_input(iosrc_t fd _is_unused, ioid_t id _is_unused)
 		eor_resume.close = (events.lNetworkEvents & FD_CLOSE) != 0;
 #endif /*]*/
 		eor_id = AddTimeOut(0, net_eor_resume);
+		eor_suspended = true;
 		return;
 	    }
 #if defined(LOCAL_PROCESS) /*[*/
 	}
 #endif /*]*/
     }
+    net_uncork();
 
     if (IN_NVT) {
 	ctlr_dbcs_postprocess();
@@ -1590,6 +1954,7 @@ net_input(iosrc_t fd _is_unused, ioid_t id _is_unused)
 	    vctrace(TC_SOCKET, "net_input: deferring FD_CLOSE processing\n");
 	    eor_resume.close = true;
 	    eor_id = AddTimeOut(0, net_eor_resume);
+	    eor_suspended = true;
 	    return;
 	}
 	vctrace(TC_SOCKET, "RCVD disconnect\n");
@@ -1665,7 +2030,7 @@ force_ascii(const char *s)
     varbuf_t r;
     unsigned char c;
 
-    vb_init(&r);
+    vb_init_tx(&r);
     while ((c = *s++) != '\0') {
 #if defined(EBCDIC_HOST) /*[*/
 	c = ebc2asc0[c];
@@ -1676,7 +2041,7 @@ force_ascii(const char *s)
 	}
 	vb_append(&r, (char *)&c, 1);
     }
-    return txdFree(vb_consume(&r));
+    return vb_consume(&r);
 }
 
 /*
@@ -1689,7 +2054,7 @@ clean_ascii(const char *s)
     varbuf_t r;
     unsigned char c;
 
-    vb_init(&r);
+    vb_init_tx(&r);
     while ((c = *s++) != '\0') {
 #if defined(EBCDIC_HOST) /*[*/
 	unsigned char a = ebc2asc0[c];
@@ -1704,7 +2069,7 @@ clean_ascii(const char *s)
 #endif /*]*/
 	vb_append(&r, (char *)&c, 1);
     }
-    return txdFree(vb_consume(&r));
+    return vb_consume(&r);
 }
 
 #if defined(EBCDIC_HOST) /*[*/
@@ -2710,7 +3075,7 @@ e_rq(unsigned char data_type, unsigned char request_flag)
 	    " ERR-COND-CLEARED": txAsprintf("%02x", request_flag);
     }
 
-    vb_init(&r);
+    vb_init_tx(&r);
     for (i = 0; req_flag[i].name != NULL; i++) {
 	if (request_flag & req_flag[i].flag) {
 	    vb_appendf(&r, "%s%s", sep, req_flag[i].name);
@@ -2721,19 +3086,20 @@ e_rq(unsigned char data_type, unsigned char request_flag)
     if (request_flag != 0) {
 	vb_appendf(&r, "%s%02x", sep, request_flag);
     }
-    return txdFree(vb_consume(&r));
+    return vb_consume(&r);
 }
 
 static int
 process_eor(void)
 {
+    prof_cat_t prev;
+
     if (syncing || !(ibptr - ibuf)) {
 	return(0);
     }
 
     if (IN_E) {
 	tn3270e_header *h = (tn3270e_header *)ibuf;
-	unsigned char *s;
 	enum pds rv;
 	bool bid_success;
 
@@ -2752,8 +3118,10 @@ process_eor(void)
 	    tn3270e_submode = E_3270;
 	    check_in3270();
 	    response_required = h->response_flag;
+	    prev = prof_enter(PC_CTLR);
 	    rv = process_ds(ibuf + EH_SIZE, (ibptr - ibuf) - EH_SIZE,
 		    (h->request_flag & TN3270E_RQF_KEYBOARD_RESTORE) != 0);
+	    prof_leave(prev);
 	    if (rv < 0 && response_required != TN3270E_RSF_NO_RESPONSE) {
 		tn3270e_nak(rv);
 	    }
@@ -2835,9 +3203,7 @@ process_eor(void)
 	    tn3270e_submode = E_NVT;
 	    check_in3270();
 	    trace_envt_in(ibuf + EH_SIZE, ibptr - (ibuf + EH_SIZE));
-	    for (s = ibuf + EH_SIZE; s < ibptr; s++) {
-		nvt_process((unsigned int)*s);
-	    }
+	    nvt_process_run(ibuf + EH_SIZE, ibptr - (ibuf + EH_SIZE));
 	    if (h->response_flag == TN3270E_RSF_ALWAYS_RESPONSE) {
 		tn3270e_ack();
 	    }
@@ -2865,7 +3231,9 @@ process_eor(void)
 	    return 0;
 	}
     } else {
+	prev = prof_enter(PC_CTLR);
 	process_ds(ibuf, ibptr - ibuf, false);
+	prof_leave(prev);
     }
     return 0;
 }
@@ -2971,71 +3339,242 @@ net_cookout(const char *buf, size_t len)
 }
 
 /*
- * net_rawout
- *	Send out raw telnet data.  We assume that there will always be enough
- *	space to buffer what we want to transmit, so we don't handle EAGAIN or
- *	EWOULDBLOCK.
+ * xq_reset
+ *	Discard the transmit queue.
  */
 static void
-net_rawout(unsigned const char *buf, size_t len)
+xq_reset(void)
 {
-    int nw;
+    if (xq_id != NULL_IOID) {
+	RemoveOutput(xq_id);
+	xq_id = NULL_IOID;
+    }
+    xq_start = xq_end = 0;
+    ns_bqueued = 0;
+    xq_throttled = false;
+}
 
-    trace_netdata('>', buf, len);
+/*
+ * xq_reserve
+ *	Make room for at least len more bytes at the end of the transmit queue.
+ *	Returns a pointer to the free space.
+ */
+static unsigned char *
+xq_reserve(size_t len)
+{
+    /* Slide unsent data down to the front. */
+    if (xq_start > 0 && xq_end + len > xq_size) {
+	memmove(xq_buf, xq_buf + xq_start, xq_end - xq_start);
+	xq_end -= xq_start;
+	xq_start = 0;
+    }
+
+    /* Grow. */
+    if (xq_end + len > xq_size) {
+	while (xq_end + len > xq_size) {
+	    xq_size += BUFSZ;
+	}
+	xq_buf = (unsigned char *)Realloc(xq_buf, xq_size);
+    }
+    return xq_buf + xq_end;
+}
+
+/*
+ * xq_commit
+ *	Add len bytes, just written into the space returned by xq_reserve, to
+ *	the transmit queue.
+ */
+static void
+xq_commit(size_t len)
+{
+    xq_end += len;
+    ns_bqueued = xq_end - xq_start;
+    xq_throttle();
+}
+
+/*
+ * xq_throttle
+ *	Stop reading from the host while the transmit queue is too long, so a
+ *	host that sends without reading our replies cannot make it grow
+ *	without bound. Start again once it has drained.
+ */
+static void
+xq_throttle(void)
+{
+    if (!xq_throttled && ns_bqueued >= XQ_HIGH_WATER) {
+	vctrace(TC_SOCKET, "Host output queue over %d bytes, pausing input\n",
+		XQ_HIGH_WATER);
+	x_remove_input();
+	xq_throttled = true;
+    } else if (xq_throttled && ns_bqueued <= XQ_LOW_WATER) {
+	vctrace(TC_SOCKET, "Host output queue drained, resuming input\n");
+	xq_throttled = false;
+	if (PCONNECTED && !eor_suspended) {
+	    x_add_input(sock);
+	}
+    }
+}
+
+/*
+ * net_write
+ *	Write data to the host.
+ *	Returns the number of bytes written, 0 if the socket would block, or -1
+ *	for a fatal error, in which case the connection has been torn down.
+ */
+static int
+net_write(unsigned const char *buf, size_t len)
+{
+    int nw;
 
-    while (len) {
 #if defined(OMTU) /*[*/
-	size_t n2w = len;
-	int pause = 0;
-
-	if (n2w > OMTU) {
-	    n2w = OMTU;
-	    pause = 1;
-	}
-#else
-# define n2w len
-#endif
-	if (secure_connection) {
-	    nw = sio_write(sio, (const char *) buf, (int)n2w);
-	} else
+    if (len > OMTU) {
+	len = OMTU;
+    }
+#endif /*]*/
+    if (secure_connection) {
+	nw = sio_write(sio, (const char *) buf, (int)len);
+	if (nw == SIO_EWOULDBLOCK) {
+	    return 0;
+	}
+	if (nw < 0) {
+	    connect_error("%s", sio_last_error());
+	    host_disconnect(false);
+	    return -1;
+	}
+    } else {
 #if defined(LOCAL_PROCESS) /*[*/
 	if (local_process) {
-	    nw = write(sock, (const char *) buf, (int)n2w);
+	    nw = write(sock, (const char *) buf, (int)len);
 	} else
 #endif /*]*/
 	{
-	    nw = send(sock, (const char *) buf, (int)n2w, 0);
+	    nw = send(sock, (const char *) buf, (int)len, 0);
 	}
 	if (nw < 0) {
-	    if (secure_connection) {
-		connect_error("%s", sio_last_error());
-		host_disconnect(false);
-		return;
+	    if (IS_EWOULDBLOCK(socket_errno()) || socket_errno() == SE_EINTR) {
+		return 0;
 	    }
 	    vctrace(TC_SOCKET, "RCVD socket error %d (%s)\n", socket_errno(),
 		    socket_strerror(socket_errno()));
 	    if (socket_errno() == SE_EPIPE || socket_errno() == SE_ECONNRESET) {
 		host_disconnect(false);
-		return;
-	    } else if (socket_errno() == SE_EINTR) {
-		goto bot;
 	    } else {
 		popup_a_sockerr("Socket write");
 		host_disconnect(true);
+	    }
+	    return -1;
+	}
+    }
+    ns_bsent += nw;
+    stats_poke();
+    return nw;
+}
+
+/*
+ * xq_output_possible
+ *	The socket is writable again. Push out more of the transmit queue.
+ */
+static void
+xq_output_possible(iosrc_t fd _is_unused, ioid_t id _is_unused)
+{
+    net_xmit();
+}
+
+/*
+ * net_xmit
+ *	Write as much of the transmit queue as the socket will take, and
+ *	arrange to be called back when it can take more.
+ */
+static void
+net_xmit(void)
+{
+    while (xq_start < xq_end) {
+	int nw = net_write(xq_buf + xq_start, xq_end - xq_start);
+
+	if (nw < 0) {
+	    return;
+	}
+	if (nw == 0) {
+	    if (xq_id == NULL_IOID) {
+		vctrace(TC_SOCKET, "Host output blocked, %zu bytes queued\n",
+			xq_end - xq_start);
+		xq_id = AddOutput(sock, xq_output_possible);
+	    }
+	    xq_throttle();
+	    return;
+	}
+	xq_start += nw;
+	ns_bqueued = xq_end - xq_start;
+    }
+
+    /* Drained. */
+    if (xq_id != NULL_IOID) {
+	vctrace(TC_SOCKET, "Host output unblocked\n");
+	RemoveOutput(xq_id);
+	xq_id = NULL_IOID;
+    }
+    xq_start = xq_end = 0;
+    ns_bqueued = 0;
+    xq_throttle();
+}
+
+/*
+ * net_cork
+ *	Hold output in the transmit queue until the matching net_uncork, so
+ *	that several small writes go out together.
+ */
+static void
+net_cork(void)
+{
+    xq_corked++;
+}
+
+/*
+ * net_uncork
+ *	Undo a net_cork, sending whatever was queued.
+ */
+static void
+net_uncork(void)
+{
+    if (xq_corked > 0 && --xq_corked == 0 && xq_id == NULL_IOID &&
+	    sock != INVALID_SOCKET) {
+	net_xmit();
+    }
+}
+
+/*
+ * net_rawout
+ *	Send out raw telnet data.  Whatever cannot be written immediately,
+ *	because output is corked or the socket would block, is queued and
+ *	written later, so a slow host never stalls the emulator.
+ */
+static void
+net_rawout(unsigned const char *buf, size_t len)
+{
+    trace_netdata('>', buf, len);
+
+    /* Write directly if nothing is ahead of us. */
+    while (len && !xq_corked && xq_start == xq_end) {
+	int nw = net_write(buf, len);
+
+	if (nw <= 0) {
+	    if (nw < 0) {
 		return;
 	    }
+	    break;
 	}
-	ns_bsent += nw;
-	stats_poke();
 	len -= nw;
 	buf += nw;
-    bot:
-#if defined(OMTU) /*[*/
-	if (pause) {
-	    sleep(1);
-	}
-#endif /*]*/
-    	;
+    }
+    if (!len) {
+	return;
+    }
+
+    /* Queue the rest. */
+    memcpy(xq_reserve(len), buf, len);
+    xq_commit(len);
+    if (!xq_corked && xq_id == NULL_IOID) {
+	net_xmit();
     }
 }
 
@@ -3384,10 +3923,9 @@ trace_envt_in(unsigned const char *buf, size_t len)
 void
 net_output(void)
 {
-    static unsigned char *xobuf = NULL;
-    static int xobuf_len = 0;
-    int need_resize = 0;
-    unsigned char *nxoptr, *xoptr;
+    unsigned char *xobuf, *xoptr;
+    unsigned char *nxoptr, *iac;
+    size_t run;
 
 #define BSTART	((IN_TN3270E || IN_SSCP || IN_E_NVT)? obuf_base: obuf)
 
@@ -3419,20 +3957,20 @@ net_output(void)
 	}
     }
 
-    /* Reallocate the expanded output buffer. */
-    while (xobuf_len <  (obptr - BSTART + 1) * 2) {
-	xobuf_len += BUFSZ;
-	need_resize++;
-    }
-    if (need_resize) {
-	Replace(xobuf, (unsigned char *)Malloc(xobuf_len));
-    }
-
-    /* Copy and expand IACs. */
-    xoptr = xobuf;
+    /*
+     * Copy the record straight into the transmit queue, expanding IACs.
+     * IACs are rare, so copy the runs between them with memchr/memcpy
+     * rather than a byte at a time.
+     */
+    xobuf = xoptr = xq_reserve((obptr - BSTART + 1) * 2);
     nxoptr = BSTART;
     while (nxoptr < obptr) {
-	if ((*xoptr++ = *nxoptr++) == IAC) {
+	iac = memchr(nxoptr, IAC, obptr - nxoptr);
+	run = ((iac != NULL)? iac + 1: obptr) - nxoptr;
+	memcpy(xoptr, nxoptr, run);
+	xoptr += run;
+	nxoptr += run;
+	if (iac != NULL) {
 	    *xoptr++ = IAC;
 	}
     }
@@ -3440,7 +3978,11 @@ net_output(void)
     /* Append the IAC EOR and transmit. */
     *xoptr++ = IAC;
     *xoptr++ = EOR;
-    net_rawout(xobuf, xoptr - xobuf);
+    trace_netdata('>', xobuf, xoptr - xobuf);
+    xq_commit(xoptr - xobuf);
+    if (!xq_corked && xq_id == NULL_IOID) {
+	net_xmit();
+    }
 
     vctrace(TC_TELNET, "SENT EOR\n");
     ns_rsent++;
@@ -3867,20 +4409,20 @@ net_nonblocking(socket_t sock, const char **errmsg)
 }
 
 /*
- * Set blocking/non-blocking mode on the host socket. On error, pops up an error
+ * Set non-blocking mode on a host socket. On error, pops up an error
  * message, but does not close the socket.
  */
 static int
-non_blocking(void)
+non_blocking(socket_t s)
 {
 #if !defined(BLOCKING_CONNECT_ONLY) /*[*/
     const char *errmsg;
 
     vctrace(TC_SOCKET, "Making host socket non-blocking\n");
-    if (sock == INVALID_SOCKET) {
+    if (s == INVALID_SOCKET) {
 	return 0;
     }
-    if (!net_nonblocking(sock, &errmsg)) {
+    if (!net_nonblocking(s, &errmsg)) {
 	connect_error("%s", errmsg);
 	return -1;
     }
@@ -3924,6 +4466,7 @@ net_starttls_continue(void)
 	    sio_provider(), session, cert);
     Free(session);
     Free(cert);
+    count_tls_handshake();
     st_changed(ST_SECURE, true);
 
     if (starttls_pending == TELNET_PENDING) {
@@ -3972,6 +4515,17 @@ continue_tls(unsigned char *sbbuf, int len)
     /* Trace what we got. */
     vtrace("%s FOLLOWS %s\n", opt(TELOPT_STARTTLS), cmd(SE));
 
+    /* Anything queued must go out in the clear before TLS starts. */
+    net_xmit();
+    if (sock == INVALID_SOCKET) {
+	return;
+    }
+    if (ns_bqueued) {
+	connect_error("TLS negotiation failure: %zu bytes unsent", ns_bqueued);
+	host_disconnect(true);
+	return;
+    }
+
     /* Negotiate. */
     net_starttls_continue();
 }
@@ -4273,6 +4827,16 @@ net_sio_provider(void)
     return sio_provider();
 }
 
+/*
+ * Query TLS handshake statistics.
+ */
+const char *
+net_query_tls_handshakes(void)
+{
+    return txAsprintf("handshakes %lu resumed %lu", tls_handshakes,
+	    tls_resumed);
+}
+
 /*
  * Change the NOP transmit interval.
  */
@@ -287,7 +287,7 @@ expand_name(const char *s, size_t len)
     varbuf_t v;
     unsigned char c;
 
-    vb_init(&v);
+    vb_init_tx(&v);
     while (len--) {
 	c = (unsigned char)*s++;
 	if (c == TELOBJ_ESC) {
@@ -305,7 +305,7 @@ expand_name(const char *s, size_t len)
 	    vb_append(&v, (char *)&c, 1);
 	}
     }
-    return txdFree(vb_consume(&v));
+    return vb_consume(&v);
 }
 
 /* Expand IACs in a reply buffer. */
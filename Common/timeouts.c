@@ -83,6 +83,8 @@ typedef struct timeout {
     bool in_play;
 } timeout_t;
 static timeout_t *timeouts = NULL;
+static unsigned timeouts_pending = 0;
+static unsigned long timeouts_fired = 0;
 
 ioid_t
 AddTimeOut(unsigned long interval_ms, tofn_t proc)
@@ -96,6 +98,7 @@ AddTimeOut(unsigned long interval_ms, tofn_t proc)
     timeout_t *prev = NULL;
 
     t_new = (timeout_t *)Malloc(sizeof(timeout_t));
+    timeouts_pending++;
     t_new->proc = proc;
     t_new->in_play = false;
 #if defined(_WIN32) /*[*/
@@ -163,6 +166,7 @@ RemoveTimeOut(ioid_t timer)
 		timeouts = t->next;
 	    }
 	    Free(t);
+	    timeouts_pending--;
 	    return;
 	}
 	prev = t;
@@ -268,6 +272,8 @@ process_timeouts(void)
 	while ((t = timeouts) != NULL) {
 	    if (EXPIRED(t, now)) {
 		timeouts = t->next;
+		timeouts_pending--;
+		timeouts_fired++;
 		t->in_play = true;
 		vctrace(TC_SCHED, "Processing timeout\n");
 		(*t->proc)((ioid_t)t);
@@ -284,6 +290,19 @@ process_timeouts(void)
     return processed_any;
 }
 
+/**
+ * Count timeouts.
+ *
+ * @param[out] pending	Number of timeouts waiting to expire
+ * @param[out] fired	Number of timeouts that have expired
+ */
+void
+timeout_stats(unsigned *pending, unsigned long *fired)
+{
+    *pending = timeouts_pending;
+    *fired = timeouts_fired;
+}
+
 /*
  * Formats a string for the timeout value.
  */
@@ -55,6 +55,7 @@
 #include "popups.h"
 #include "print_screen.h"
 #include "product.h"
+#include "profile.h"
 #include "query.h"
 #include "resources.h"
 #include "status.h"
@@ -415,8 +416,8 @@ vwtrace(bool do_ts, tc_t category, const char *fmt, va_list args)
 {
     size_t n2w_left, n2w, nw;
     const char *ts;
-    char *buf = NULL;
-    char *bp;
+    const char *bp;
+    prof_cat_t prev;
 
     /* Ugly hack to write into a memory buffer. */
     if (tracef_bufptr != NULL) {
@@ -432,13 +433,13 @@ vwtrace(bool do_ts, tc_t category, const char *fmt, va_list args)
     }
 
     ts = NULL;
+    prev = prof_enter(PC_TRACE);
 
-    buf = Vasprintf(fmt, args);
-    n2w_left = strlen(buf);
-    bp = buf;
+    bp = txVasprintf(fmt, args);
+    n2w_left = strlen(bp);
 
     while (n2w_left > 0) {
-	char *nl;
+	const char *nl;
 	bool wrote_nl = false;
 
 	if (do_ts && !wrote_ts) {
@@ -482,9 +483,7 @@ vwtrace(bool do_ts, tc_t category, const char *fmt, va_list args)
     tracef_size = ftello(tracef);
 
 done:
-    if (buf != NULL) {
-	Free(buf);
-    }
+    prof_leave(prev);
     return;
 }
 
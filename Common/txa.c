@@ -36,12 +36,17 @@
 # include <malloc.h>
 #endif /*]*/
 
+#include "asprintf.h"
 #include "trace.h"
 #include "utils.h"
+#include "varbuf.h"
 
 #include "txa.h"
 
 #define BLOCK_SLOTS  1024	/* slots per block */
+#define CHUNK_SIZE  (64 * 1024)	/* arena chunk size */
+#define CHUNK_KEEP  4		/* arena chunks kept across txflush() */
+#define BIG_ALLOC   (CHUNK_SIZE / 4) /* larger than this gets its own Malloc */
 
 typedef struct txa_block {
     struct txa_block *next;
@@ -52,6 +57,26 @@ static txa_block_t **last_block = &blocks;
 static txa_block_t *current_block;
 static int slot_ix = 0;
 
+/*
+ * Arena alignment. This has to be a power of two, and at least as strict as
+ * any type's alignment. The size of a union of the widest types is not good
+ * enough: long double is 12 bytes on i386.
+ */
+#define TXA_ALIGN	16
+#define ALIGN_UP(n)	(((n) + TXA_ALIGN - 1) & ~(size_t)(TXA_ALIGN - 1))
+
+/* Arena chunk. Data follows the header. */
+typedef struct txa_chunk {
+    struct txa_chunk *next;
+    size_t used;
+} txa_chunk_t;
+#define CHUNK_HDR	ALIGN_UP(sizeof(txa_chunk_t))
+#define CHUNK_DATA(c)	((char *)(c) + CHUNK_HDR)
+
+static txa_chunk_t *chunks;	/* chunks in use, current one first */
+static txa_chunk_t *spare_chunks; /* chunks kept for reuse */
+static char *last_alloc;	/* most recent arena allocation */
+
 /**
  * Do a deferred free on a malloc'd block of memory.
  *
@@ -76,7 +101,86 @@ txdFree(void *buf)
 }
 
 /**
- * Format a string into malloc'd memory and do a deferred free on it.
+ * Allocate temporary memory, which will be freed in bulk by txflush().
+ *
+ * Small requests are carved out of an arena, so they do not go through the
+ * general-purpose allocator. Large ones are malloc'd and deferred-freed.
+ *
+ * @param[in] len	Length to allocate
+ *
+ * @return Buffer, suitably aligned for any type
+ */
+void *
+txalloc(size_t len)
+{
+    size_t alen = ALIGN_UP(len? len: 1);
+    char *r;
+
+    if (alen > BIG_ALLOC) {
+	last_alloc = NULL;
+	return (void *)txdFree(Malloc(len));
+    }
+
+    if (chunks == NULL || chunks->used + alen > CHUNK_SIZE - CHUNK_HDR) {
+	txa_chunk_t *c;
+
+	/* Start a new chunk. */
+	if (spare_chunks != NULL) {
+	    c = spare_chunks;
+	    spare_chunks = c->next;
+	} else {
+	    c = (txa_chunk_t *)Malloc(CHUNK_SIZE);
+	}
+	c->used = 0;
+	c->next = chunks;
+	chunks = c;
+    }
+
+    r = CHUNK_DATA(chunks) + chunks->used;
+    chunks->used += alen;
+    last_alloc = r;
+    return r;
+}
+
+/**
+ * Grow temporary memory.
+ *
+ * If buf was the most recent arena allocation and there is room, it is
+ * extended in place. Otherwise new space is allocated and old_len bytes are
+ * copied into it. The old space is reclaimed by txflush().
+ *
+ * This is the allocator used by varbufs initialized with vb_init_tx().
+ *
+ * @param[in] buf	Buffer to grow, or NULL
+ * @param[in] old_len	Number of bytes to keep
+ * @param[in] new_len	New length
+ *
+ * @return Buffer
+ */
+void *
+txrealloc(void *buf, size_t old_len, size_t new_len)
+{
+    void *r;
+
+    if (buf != NULL && buf == last_alloc) {
+	size_t offset = last_alloc - CHUNK_DATA(chunks);
+	size_t alen = ALIGN_UP(new_len);
+
+	if (alen <= BIG_ALLOC && offset + alen <= CHUNK_SIZE - CHUNK_HDR) {
+	    chunks->used = offset + alen;
+	    return buf;
+	}
+    }
+
+    r = txalloc(new_len);
+    if (buf != NULL && old_len) {
+	memcpy(r, buf, (old_len < new_len)? old_len: new_len);
+    }
+    return r;
+}
+
+/**
+ * Format a string into temporary memory.
  *
  * @param[in] fmt	Format
  *
@@ -86,16 +190,16 @@ const char *
 txAsprintf(const char *fmt, ...)
 {
     va_list args;
-    char *r;
+    const char *r;
 
     va_start(args, fmt);
-    r = Vasprintf(fmt, args);
+    r = txVasprintf(fmt, args);
     va_end(args);
-    return txdFree(r);
+    return r;
 }
 
 /**
- * Format a string into malloc'd memory and do a deferred free on it.
+ * Format a string into temporary memory.
  * Varargs version.
  *
  * @param[in] fmt	Format
@@ -106,7 +210,17 @@ txAsprintf(const char *fmt, ...)
 const char *
 txVasprintf(const char *fmt, va_list args)
 {
-    return txdFree(Vasprintf(fmt, args));
+    va_list args_copy;
+    int len;
+    char *r;
+
+    va_copy(args_copy, args);
+    len = vscprintf(fmt, args_copy);
+    va_end(args_copy);
+
+    r = txalloc(len + 1);
+    vsnprintf(r, len + 1, fmt, args);
+    return r;
 }
 
 /**
@@ -120,6 +234,9 @@ txflush(void)
     size_t nb = 0;
 #endif /*]*/
     txa_block_t *r, *next = NULL;
+    txa_chunk_t *c, *cnext;
+    unsigned nc = 0, nkeep = 0;
+    size_t na = 0;
 
     for (r = blocks; r != NULL; r = next) {
 	int i;
@@ -142,6 +259,25 @@ txflush(void)
     last_block = &blocks;
     slot_ix = 0;
 
+    /* Reset the arena, keeping a few chunks for next time. */
+    for (c = spare_chunks; c != NULL; c = c->next) {
+	nkeep++;
+    }
+    for (c = chunks; c != NULL; c = cnext) {
+	cnext = c->next;
+	na += c->used;
+	nc++;
+	if (nkeep < CHUNK_KEEP) {
+	    c->next = spare_chunks;
+	    spare_chunks = c;
+	    nkeep++;
+	} else {
+	    Free(c);
+	}
+    }
+    chunks = NULL;
+    last_alloc = NULL;
+
 #if defined(HAVE_MALLOC_USABLE_SIZE) /*[*/
     if (nf > 10 || nb > 1024) {
 	vtrace("txflush: %u slot%s, %zu bytes\n", nf, (nf == 1)? "": "s",
@@ -152,4 +288,7 @@ txflush(void)
 	vtrace("txflush: %u slot%s\n", nf, (nf == 1)? "": "s");
     }
 #endif /*]*/
+    if (nc > 1) {
+	vtrace("txflush: arena %u chunks, %zu bytes\n", nc, na);
+    }
 }
@@ -49,6 +49,22 @@ vb_init(varbuf_t *r)
     memset(r, 0, sizeof(*r));
 }
 
+/**
+ * Initialize a buffer with an alternate allocator.
+ *
+ * The allocator owns the memory, so the contents returned by vb_consume()
+ * must not be freed, and vb_free() does not free anything.
+ *
+ * @param[in,out] r	Varbuf to initialize.
+ * @param[in] alloc	Allocator
+ */
+void
+vb_init_alloc(varbuf_t *r, vb_alloc_t *alloc)
+{
+    memset(r, 0, sizeof(*r));
+    r->alloc = alloc;
+}
+
 /**
  * Expand a buffer.
  */
@@ -63,7 +79,11 @@ vb_expand(varbuf_t *r, size_t len)
 	while (r->len + len > r->alloc_len) {
 	    r->alloc_len *= 2;
 	}
-	r->buf = Realloc(r->buf, r->alloc_len);
+	if (r->alloc != NULL) {
+	    r->buf = (*r->alloc)(r->buf, r->len, r->alloc_len);
+	} else {
+	    r->buf = Realloc(r->buf, r->alloc_len);
+	}
     }
 }
 
@@ -198,6 +218,10 @@ vb_consume(varbuf_t *r)
     char *ret;
 
     ret = r->buf;
+    if (ret == NULL && r->alloc != NULL) {
+	ret = (*r->alloc)(NULL, 0, 1);
+	*ret = '\0';
+    }
     vb_init(r);
     return ret? ret: NewString("");
 }
@@ -210,6 +234,8 @@ vb_consume(varbuf_t *r)
 void
 vb_free(varbuf_t *r)
 {
-    Free(r->buf);
+    if (r->alloc == NULL) {
+	Free(r->buf);
+    }
     vb_init(r);
 }
@@ -0,0 +1,173 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2025 Paul Mattes.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#     * Redistributions of source code must retain the above copyright
+#       notice, this list of conditions and the following disclaimer.
+#     * Redistributions in binary form must reproduce the above copyright
+#       notice, this list of conditions and the following disclaimer in the
+#       documentation and/or other materials provided with the distribution.
+#     * Neither the names of Paul Mattes nor the names of his contributors
+#       may be used to endorse or promote products derived from this software
+#       without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY PAUL MATTES "AS IS" AND ANY EXPRESS OR IMPLIED
+# WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+# MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+# EVENT SHALL PAUL MATTES BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+# OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+# WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+# OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+# ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+# b3270 binary screen-update protocol tests
+
+import json
+from subprocess import Popen, PIPE, DEVNULL
+import struct
+import threading
+import unittest
+
+from Common.Test.cti import *
+
+# Message types.
+bin_erase = 1
+bin_cursor = 2
+bin_screen = 3
+bin_oia = 4
+
+# OIA fields, value types and value attributes.
+bin_oia_lock = 4
+bin_val_boolean = 1
+bin_val_int = 2
+bin_val_string = 3
+bin_oia_attr_value = 1
+
+@requests_timeout
+class TestB3270Binary(cti):
+
+    # Read b3270's output, splitting it into JSON and binary messages.
+    def read_messages(self, f, messages):
+        while True:
+            b = f.read(1)
+            if b == b'':
+                break
+            if b == b'\0':
+                (type, length) = struct.unpack('>BI', f.read(5))
+                messages.append((type, f.read(length)))
+            else:
+                messages.append(json.loads(b + f.readline()))
+
+    # Decode a screen message into a dictionary of row -> list of text changes.
+    def decode_screen(self, payload):
+        text = {}
+        (nrows,) = struct.unpack_from('>H', payload, 0)
+        off = 2
+        for _ in range(nrows):
+            (row, count) = struct.unpack_from('>HH', payload, off)
+            off += 4
+            for _ in range(count):
+                (kind, column, mask) = struct.unpack_from('>BHB', payload, off)
+                off += 4
+                off += (1 if mask & 1 else 0) + (1 if mask & 2 else 0) + (2 if mask & 4 else 0)
+                (n,) = struct.unpack_from('>H', payload, off)
+                off += 2
+                if kind == 0:
+                    text.setdefault(row, []).append((column, payload[off:off+n].decode('utf8')))
+                    off += n
+        self.assertEqual(len(payload), off)
+        return text
+
+    # Decode an OIA message into the field and a dictionary of attr -> value.
+    def decode_oia(self, payload):
+        values = {}
+        field = payload[0]
+        off = 1
+        while off < len(payload):
+            (attr, type) = struct.unpack_from('>BB', payload, off)
+            off += 2
+            if type == bin_val_boolean:
+                values[attr] = payload[off] != 0
+                off += 1
+            elif type == bin_val_int:
+                (values[attr],) = struct.unpack_from('>I', payload, off)
+                off += 4
+            else:
+                self.assertEqual(bin_val_string, type)
+                (n,) = struct.unpack_from('>H', payload, off)
+                off += 2
+                values[attr] = payload[off:off+n].decode('utf8')
+                off += n
+        self.assertEqual(len(payload), off)
+        return (field, values)
+
+    # Basic binary screen update test.
+    def test_binary_screen(self):
+
+        # Start a server to throw NVT text at b3270.
+        s = copyserver()
+
+        # Start b3270.
+        hport, ts = unused_port()
+        b3270 = Popen(vgwrap(['b3270', '-model', '2', '-httpd', str(hport), '-json', '-binaryscreen']),
+            stdin=PIPE, stdout=PIPE)
+        self.children.append(b3270)
+        messages = []
+        reader = threading.Thread(target=self.read_messages, args=(b3270.stdout, messages))
+        reader.start()
+        self.check_listen(hport)
+        ts.close()
+
+        # Connect and send some text.
+        self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Connect(a:c:t:127.0.0.1:{s.port})')
+        s.send('hello\r\nthere')
+        self.try_until(lambda: self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Ascii1(2,1,1,5)').json()['result'][0] == 'there',
+            2, 'Output did not arrive')
+        self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Quit()')
+        s.data()
+        b3270.stdin.close()
+        reader.join(timeout=2)
+        self.vgwait(b3270)
+
+        # Control messages are still JSON.
+        self.assertTrue(any(isinstance(m, dict) and 'initialize' in m for m in messages))
+        self.assertFalse(any(isinstance(m, dict) and 'screen' in m for m in messages))
+
+        # The text arrived in screen messages.
+        text = {}
+        for m in messages:
+            if isinstance(m, tuple) and m[0] == bin_screen:
+                for row, changes in self.decode_screen(m[1]).items():
+                    text.setdefault(row, []).extend(changes)
+        self.assertIn((1, 'hello'), text[1])
+        self.assertIn((1, 'there'), text[2])
+
+        # The cursor ended up after 'there', then was disabled by the disconnect.
+        cursors = [struct.unpack('>BHH', m[1]) for m in messages if isinstance(m, tuple) and m[0] == bin_cursor]
+        self.assertEqual([(1, 2, 6), (0, 0, 0)], cursors[-2:])
+
+        # The OIA lock field is binary. It is locked until connected, then
+        # unlocked, which omits the value.
+        oias = [self.decode_oia(m[1]) for m in messages if isinstance(m, tuple) and m[0] == bin_oia]
+        locks = [values for field, values in oias if field == bin_oia_lock]
+        self.assertNotEqual([], locks)
+        self.assertIsInstance(locks[0][bin_oia_attr_value], str)
+        self.assertIn({}, locks)
+
+    # XML with a wrapper document cannot carry binary messages.
+    def test_binary_xml_wrapper(self):
+        b3270 = Popen(vgwrap(['b3270', '-binaryscreen']), stdin=PIPE, stdout=DEVNULL, stderr=PIPE)
+        self.children.append(b3270)
+        b3270.stdin.close()
+        err = b3270.stderr.read().decode('utf8')
+        b3270.stderr.close()
+        self.vgwait(b3270, assertOnFailure=False)
+        self.assertIn('-binaryscreen requires', err)
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,158 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2025 Paul Mattes.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#     * Redistributions of source code must retain the above copyright
+#       notice, this list of conditions and the following disclaimer.
+#     * Redistributions in binary form must reproduce the above copyright
+#       notice, this list of conditions and the following disclaimer in the
+#       documentation and/or other materials provided with the distribution.
+#     * Neither the names of Paul Mattes nor the names of his contributors
+#       may be used to endorse or promote products derived from this software
+#       without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY PAUL MATTES "AS IS" AND ANY EXPRESS OR IMPLIED
+# WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+# MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+# EVENT SHALL PAUL MATTES BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+# OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+# WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+# OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+# ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+# b3270 screen update frame rate tests
+
+import json
+from subprocess import Popen, PIPE
+import threading
+import unittest
+
+from Common.Test.cti import *
+
+@requests_timeout
+class TestB3270FrameRate(cti):
+
+    # Read b3270's JSON output.
+    def read_messages(self, f, messages):
+        for line in f:
+            messages.append(json.loads(line))
+
+    # Return the text changes in a screen indication.
+    def screen_text(self, m):
+        return [(row['row'], change['text']) for row in m['screen'].get('rows', [])
+            for change in row['changes'] if 'text' in change]
+
+    # Frame rate coalescing test.
+    def test_frame_rate(self):
+
+        # Start a server to throw NVT text at b3270.
+        s = copyserver()
+
+        # Start b3270, limited to one screen update per second.
+        hport, ts = unused_port()
+        b3270 = Popen(vgwrap(['b3270', '-json', '-xrm', 'b3270.maxFrameRate: 1', '-httpd', str(hport)]),
+            stdin=PIPE, stdout=PIPE)
+        self.children.append(b3270)
+        messages = []
+        reader = threading.Thread(target=self.read_messages, args=(b3270.stdout, messages))
+        reader.start()
+        self.check_listen(hport)
+        ts.close()
+
+        # Connect and send several lines in quick succession.
+        self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Connect(a:c:t:127.0.0.1:{s.port})')
+        for i in range(1, 6):
+            s.send(f'line {i}\r\n')
+            time.sleep(0.05)
+        self.try_until(lambda: self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Ascii1(5,1,1,6)').json()['result'][0] == 'line 5',
+            2, 'Output did not arrive')
+
+        # Run a command from the UI. The screen is flushed before the reply.
+        b3270.stdin.write(b'{"run":{"actions":"Ascii1(5,1,1,6)","r-tag":"x"}}\n')
+        b3270.stdin.flush()
+        self.try_until(lambda: any('run-result' in m for m in messages), 2, 'No run result')
+        self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Quit()')
+        s.data()
+        b3270.stdin.close()
+        reader.join(timeout=2)
+        self.vgwait(b3270)
+
+        # The lines were coalesced into fewer updates than there were writes,
+        # and the last line was sent before the run result.
+        result = [i for i, m in enumerate(messages) if 'run-result' in m][0]
+        screens = [self.screen_text(m) for m in messages[:result] if 'screen' in m]
+        screens = [t for t in screens if t != []]
+        self.assertLess(len(screens), 5)
+        self.assertIn((5, 'line 5'), screens[-1])
+
+    # Frame rate scrolling test.
+    def test_frame_rate_scroll(self):
+
+        # Start a server to throw NVT text at b3270.
+        s = copyserver()
+
+        # Start b3270, limited to one screen update per second.
+        hport, ts = unused_port()
+        b3270 = Popen(vgwrap(['b3270', '-json', '-model', '3279-2', '-xrm', 'b3270.maxFrameRate: 1',
+            '-httpd', str(hport)]), stdin=PIPE, stdout=PIPE)
+        self.children.append(b3270)
+        messages = []
+        reader = threading.Thread(target=self.read_messages, args=(b3270.stdout, messages))
+        reader.start()
+        self.check_listen(hport)
+        ts.close()
+
+        # Connect and stream enough lines to scroll the screen many times.
+        self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Connect(a:c:t:127.0.0.1:{s.port})')
+        lines = 200
+        start = time.monotonic()
+        for i in range(1, lines + 1):
+            s.send(f'line {i}\r\n')
+            time.sleep(0.005)
+        self.try_until(lambda: self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Ascii1(23,1,1,8)').json()['result'][0] == f'line {lines}',
+            2, 'Output did not arrive')
+        elapsed = time.monotonic() - start
+        self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Quit()')
+        s.data()
+        b3270.stdin.close()
+        reader.join(timeout=2)
+        self.vgwait(b3270)
+
+        # Replay the updates the way a UI with scrollback would. Each scroll
+        # has to apply to the rows that were actually on the screen, so the
+        # lines scrolled off are the first ones sent, in order.
+        rows = [' ' * 80 for i in range(24)]
+        scrollback = []
+        screens = 0
+        for m in messages:
+            if 'erase' in m:
+                rows = [' ' * 80 for i in range(24)]
+            elif 'scroll' in m:
+                count = m['scroll'].get('count', 1)
+                scrollback += rows[:count]
+                rows = rows[count:] + [' ' * 80 for i in range(count)]
+            elif 'screen' in m:
+                screens += 1
+                for row in m['screen'].get('rows', []):
+                    for change in row['changes']:
+                        if 'text' in change:
+                            r = rows[row['row'] - 1]
+                            c = change['column'] - 1
+                            rows[row['row'] - 1] = r[:c] + change['text'] + r[c + len(change['text']):]
+        scrolled = [line.strip() for line in scrollback]
+        self.assertEqual([f'line {i}' for i in range(1, len(scrolled) + 1)], scrolled)
+        self.assertEqual(f'line {lines}', rows[22].strip())
+
+        # The number of screen updates depends on the frame rate, not on the
+        # number of lines. Each frame may take one update per screenful of
+        # scrolled lines, plus one for the screen itself.
+        frames = int(elapsed) + 2
+        self.assertLessEqual(screens, frames * 2 + (lines // 23) + 1)
+
+if __name__ == '__main__':
+    unittest.main()
@@ -27,7 +27,9 @@
 #
 # b3270 output queue tests
 
+import json
 from subprocess import Popen, PIPE
+import threading
 import unittest
 
 from Common.Test.cti import *
@@ -207,6 +209,84 @@ class TestB3270OutputQueue(cti):
         b3270.stderr.close()
         self.assertIn(b'Unread output exceeded', lines[0])
 
+    # Return the number of bytes queued on b3270's output queues.
+    def queued(self, hport: int) -> int:
+        r = self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Query(OutputQueues)')
+        self.assertTrue(r.ok)
+        fields = [i for i in r.json()['result'] if i.startswith('total')][0].split()
+        return int(fields[2])
+
+    # Read b3270's JSON output.
+    def read_messages(self, f, messages):
+        for line in f:
+            messages.append(json.loads(line))
+
+    # b3270 scrolling while the output is backed up test
+    def test_b3270_backed_up_scroll(self):
+
+        # Start a server to throw NVT text at b3270.
+        s = copyserver()
+
+        # Start b3270 and connect.
+        hport, ts = unused_port()
+        b3270 = Popen(vgwrap(['b3270', '-json', '-model', '3279-2', '-httpd', str(hport)]),
+            stdin=PIPE, stdout=PIPE)
+        self.children.append(b3270)
+        ts.close()
+        self.check_listen(hport)
+        self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Connect(a:c:t:127.0.0.1:{s.port})')
+
+        # Feed b3270 actions until the output backs up in the stdout pipe.
+        t0 = time.monotonic()
+        while self.queued(hport) < 500000:
+            for i in range(100):
+                b3270.stdin.write(b'"Query(-all)"\n')
+                b3270.stdin.flush()
+            time.sleep(0.5)
+            self.assertLess(time.monotonic() - t0, 5, 'Output queue did not back up')
+
+        # Send enough lines to scroll the screen while screen updates are
+        # being held.
+        for i in range(1, 61):
+            s.send(f'line {i}\r\n')
+            time.sleep(0.01)
+        self.try_until(lambda: self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Ascii1(23,1,1,7)').json()['result'][0] == 'line 60',
+            2, 'Output did not arrive')
+
+        # Drain the output.
+        messages = []
+        reader = threading.Thread(target=self.read_messages, args=(b3270.stdout, messages))
+        reader.start()
+        self.try_until(lambda: self.queued(hport) == 0, 5, 'Output queue did not clear')
+        self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Quit()')
+        s.data()
+        b3270.stdin.close()
+        reader.join(timeout=2)
+        self.vgwait(b3270)
+
+        # Replay the updates the way a UI with scrollback would. Scrolls are
+        # held along with the screen update, but each one that is sent has to
+        # apply to the rows that were actually on the screen.
+        rows = [' ' * 80 for i in range(24)]
+        scrollback = []
+        for m in messages:
+            if 'erase' in m:
+                rows = [' ' * 80 for i in range(24)]
+            elif 'scroll' in m:
+                count = m['scroll'].get('count', 1)
+                scrollback += [row.strip() for row in rows[:count]]
+                rows = rows[count:] + [' ' * 80 for i in range(count)]
+            elif 'screen' in m:
+                for row in m['screen'].get('rows', []):
+                    for change in row['changes']:
+                        if 'text' in change:
+                            r = rows[row['row'] - 1]
+                            c = change['column'] - 1
+                            rows[row['row'] - 1] = r[:c] + change['text'] + r[c + len(change['text']):]
+        self.assertEqual([f'line {i}' for i in range(1, len(scrollback) + 1)], scrollback)
+        self.assertEqual(60 - 23, len(scrollback))
+        self.assertEqual('line 60', rows[22].strip())
+
     def b3270_oq(self, spec: str, expect: str, stderr=False):
         # Start b3270.
         hport, ts = unused_port()
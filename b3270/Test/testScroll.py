@@ -0,0 +1,88 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2025 Paul Mattes.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#     * Redistributions of source code must retain the above copyright
+#       notice, this list of conditions and the following disclaimer.
+#     * Redistributions in binary form must reproduce the above copyright
+#       notice, this list of conditions and the following disclaimer in the
+#       documentation and/or other materials provided with the distribution.
+#     * Neither the names of Paul Mattes nor the names of his contributors
+#       may be used to endorse or promote products derived from this software
+#       without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY PAUL MATTES "AS IS" AND ANY EXPRESS OR IMPLIED
+# WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+# MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+# EVENT SHALL PAUL MATTES BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+# OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+# WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+# OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+# ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+# b3270 scrollback tests
+
+from subprocess import Popen, PIPE, DEVNULL
+import unittest
+
+from Common.Test.cti import *
+
+@requests_timeout
+class TestB3270Scroll(cti):
+
+    # Scrollback test.
+    def scroll_back(self, lines: int, save_lines: int):
+
+        # Start a server to throw NVT text at b3270.
+        s = copyserver()
+
+        # Start b3270.
+        hport, ts = unused_port()
+        b3270 = Popen(vgwrap(['b3270', '-model', '2', '-httpd', str(hport), '-json']), stdin=PIPE, stdout=DEVNULL)
+        self.children.append(b3270)
+        self.check_listen(hport)
+        ts.close()
+
+        # Set the scrollback size, connect to the server and send numbered
+        # lines, some with attributes.
+        self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Set(saveLines,{save_lines})')
+        self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Connect(a:c:t:127.0.0.1:{s.port})')
+        text = ''
+        for i in range(lines):
+            if i % 3 == 0:
+                text += f'\033[1mline {i}\033[m     x\r\n'
+            else:
+                text += f'line {i}\r\n'
+        s.send(text)
+        self.try_until(lambda: self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Ascii1(23,1,1,20)').json()['result'][0].strip() == f'line {lines - 1}',
+            2, 'Output did not arrive')
+
+        # Scroll back all the way and make sure the oldest saved line is
+        # intact.
+        self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Scroll(Set,{lines})')
+        screen = self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Ascii1()').json()['result']
+        first = int(screen[0].split()[1])
+        self.assertEqual(max(0, lines - 23 - save_lines), first)
+        for row in range(24):
+            n = first + row
+            expect = f'line {n}     x' if n % 3 == 0 else f'line {n}'
+            self.assertEqual(expect, screen[row].rstrip())
+
+        # Clean up.
+        self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Quit()')
+        s.data()
+        b3270.stdin.close()
+        self.vgwait(b3270)
+
+    def test_scroll_back(self):
+        self.scroll_back(200, 4096)
+    def test_scroll_back_wrap(self):
+        self.scroll_back(2000, 240)
+
+if __name__ == '__main__':
+    unittest.main()
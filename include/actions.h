@@ -44,11 +44,13 @@ typedef struct {
 
 typedef struct action_elt {
     llist_t list;		/* linkage */
+    struct action_elt *hash_next; /* hash chain */
     action_table_t t;		/* payload */
 } action_elt_t;
 
 extern llist_t actions_list;
 extern unsigned actions_list_count;
+extern unsigned actions_generation;
 
 extern const char       *ia_name[];
 
@@ -65,6 +67,8 @@ bool run_action_entry(action_elt_t *e, enum iaction cause, unsigned count,
 int check_argc(const char *aname, unsigned nargs, unsigned nargs_min,
 	unsigned nargs_max);
 void register_actions(action_table_t *actions, unsigned count);
+action_elt_t *action_find(const char *name);
+unsigned action_find_prefix(const char *prefix, action_elt_t ***matchesp);
 char *safe_param(const char *s);
 void disable_keyboard(bool disable, bool explicit, const char *why);
 #define DISABLE		true
@@ -50,6 +50,7 @@ typedef struct {
     char	*charset;	/* deprecated */
     char	*codepage;
     char	*conf_dir;
+    int		 connect_attempt_delay;
     int		 connect_timeout;
     char	*connectfile_name;
     bool	 contention_resolution;
@@ -90,13 +91,17 @@ typedef struct {
     char	*port;
     bool	 prefer_ipv4;
     bool	 prefer_ipv6;
+    bool	 profile;
     char	*proxy;
     bool	 qr_bg_color;
     bool	 reconnect;
+    int		 resolver_cache_ttl;
+    int		 resolver_cache_neg_ttl;
     bool	 retry;
     char	*sbcs_cgcsgid;
     char	*script_port;
     bool	 script_port_once;
+    int		 script_port_pipeline;
     bool	 scripted;
     bool	 scripted_always;
     bool	 secure;
@@ -234,8 +239,10 @@ typedef struct {
 
     /* b3270-specific fields. */
     struct {
+	bool	binary_screen;
 	bool	indent;
 	bool	json;
+	int	max_frame_rate;
 	bool	wrapper_doc;
     } b3270;
 
@@ -57,6 +57,7 @@
 #define IndOia		"oia"
 #define IndPassthru	"passthru"
 #define IndPrefixes	"prefixes"
+#define IndProfile	"profile"
 #define IndProxies	"proxies"
 #define IndProxy	"proxy"
 #define IndPopup	"popup"
@@ -88,10 +89,12 @@
 #define AttrAbort	"abort"
 #define AttrAction	"action"
 #define AttrActions	"actions"
+#define AttrAllocations	"allocations"
 #define AttrArg		"arg"
 #define AttrArgs	"args"
 #define AttrAttribute	"attribute"
 #define AttrBack	"back"
+#define AttrBatch	"batch"
 #define AttrBg		"bg"
 #define AttrBuild	"build"
 #define AttrBytes	"bytes"
@@ -102,8 +105,10 @@
 #define AttrColor	"color"
 #define AttrColumn	"column"
 #define AttrColumns	"columns"
+#define AttrContinue	"continue"
 #define AttrCount	"count"
 #define AttrCopyright	"copyright"
+#define AttrCpuMs	"cpu-ms"
 #define AttrElement	"element"
 #define AttrEnabled	"enabled"
 #define AttrError	"error"
@@ -137,6 +142,9 @@
 #define AttrProvider	"provider"
 #define AttrRecordsReceived "records-received"
 #define AttrRecordsSent	"records-sent"
+#define AttrResponseCount "response-count"
+#define AttrResponseP50	"response-p50-ms"
+#define AttrResponseP99	"response-p99-ms"
 #define AttrRetrying	"retrying"
 #define AttrRTag	"r-tag"
 #define AttrRow		"row"
@@ -190,6 +198,7 @@
 #define OiaScript	"script"
 #define OiaTiming	"timing"
 #define OiaTypeahead	"typeahead"
+#define OiaPrinterSession "printer-session"
 
 /* OIA lock reasons. */
 #define OiaLockNotConnected "not-connected"
@@ -245,3 +254,75 @@
 #define ValTrue		ResTrue
 #define ValFalse	ResFalse
 #define ValTrueFalse(b)	((b)? ValTrue: ValFalse)
+
+/*
+ * Binary screen-update protocol (-binaryscreen).
+ *
+ * Each message is a BinMarker byte, a type byte, a 32-bit big-endian
+ * payload length and the payload. Integers in the payload are big-endian;
+ * strings are a 16-bit length followed by UTF-8 text. Rows and columns are
+ * 1-origin, colors are host color numbers and graphic renditions are
+ * bitmasks of the BinGr* values.
+ */
+#define BinMarker	0x00	/* cannot start an XML or JSON message */
+#define BinHeaderSize	6
+
+/* Message types. */
+#define BinErase	1	/* rows(16) cols(16) fg(8) bg(8) */
+#define BinCursor	2	/* enabled(8) row(16) column(16) */
+#define BinScreen	3	/* rows(16), then per row: row(16) count(16) changes */
+#define BinOia		4	/* field(8), then per value: attr(8) type(8) value */
+#define BinScroll	5	/* fg(8) bg(8) count(16) */
+
+/* Erase values meaning 'unchanged' (rows, cols) and 'default' (fg, bg). */
+#define BinEraseSame	0
+#define BinColorDefault	0xff
+
+/* Screen changes: kind(8) column(16) mask(8) [fg(8)] [bg(8)] [gr(16)] then
+ * text(string) or count(16). */
+#define BinChangeText	0
+#define BinChangeAttr	1
+#define BinMaskFg	0x01
+#define BinMaskBg	0x02
+#define BinMaskGr	0x04
+
+/* Graphic renditions. */
+#define BinGrUnderline	0x0001
+#define BinGrBlink	0x0002
+#define BinGrHighlight	0x0004
+#define BinGrSelectable	0x0008
+#define BinGrReverse	0x0010
+#define BinGrWide	0x0020
+#define BinGrOrder	0x0040
+#define BinGrPrivateUse	0x0080
+#define BinGrNoCopy	0x0100
+#define BinGrWrap	0x0200
+#define BinGrLeftHalf	0x0400
+#define BinGrRightHalf	0x0800
+
+/* OIA value types. */
+#define BinValBoolean	1	/* 8 bits */
+#define BinValInt	2	/* 32 bits */
+#define BinValString	3
+
+/* OIA value attributes. A value that is absent is not sent. */
+#define BinOiaAttrValue	1	/* AttrValue */
+#define BinOiaAttrChar	2	/* AttrChar */
+#define BinOiaAttrType	3	/* AttrType */
+#define BinOiaAttrLu	4	/* AttrLu */
+
+/*
+ * OIA fields and the values each one carries, matching the JSON and XML
+ * "oia" indication. Values in brackets are absent when the field is off.
+ */
+#define BinOiaNotUndera	1	/* value(boolean) */
+#define BinOiaCompose	2	/* value(boolean) [char(string) type(string)] */
+#define BinOiaInsert	3	/* value(boolean) */
+#define BinOiaLock	4	/* [value(string)] */
+#define BinOiaLu	5	/* [value(string)] */
+#define BinOiaReverseInput 6	/* value(boolean) */
+#define BinOiaScreentrace 7	/* [value(int)] */
+#define BinOiaScript	8	/* value(boolean) */
+#define BinOiaTiming	9	/* [value(string)] */
+#define BinOiaTypeahead	10	/* value(boolean) */
+#define BinOiaPrinterSession 11	/* value(boolean) [lu(string)] */
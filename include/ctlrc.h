@@ -49,6 +49,9 @@ bool check_cols_rows(int mn, unsigned ovc, unsigned ovr, bool complain);
 void ctlr_aclear(int baddr, int count, int clear_ea);
 void ctlr_add(int baddr, unsigned char c, unsigned char cs);
 void ctlr_add_nvt(int baddr, ucs4_t ucs4, unsigned char cs);
+void ctlr_add_nvt_run(int baddr, const unsigned char *text, int count,
+	unsigned char gr, unsigned char fg, unsigned char bg);
+void ctlr_add_run(int baddr, const unsigned char *ebc, int count);
 void ctlr_add_bg(int baddr, unsigned char color);
 void ctlr_add_cs(int baddr, unsigned char cs);
 void ctlr_add_fa(int baddr, unsigned char fa, unsigned char cs);
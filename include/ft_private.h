@@ -109,4 +109,9 @@ typedef struct {
 } ft_tstate_t;
 extern ft_tstate_t fts;
 
+/* Throughput statistics. */
+void ft_stats_host_request(void);
+void ft_stats_host_reply(void);
+void ft_stats_record(void);
+
 #define __FT_PRIVATE_H
@@ -175,6 +175,11 @@ void Free(void *);
 void *Calloc(size_t, size_t);
 void *Realloc(void *, size_t);
 char *NewString(const char *);
+extern unsigned long alloc_count;
+extern unsigned long realloc_count;
+extern unsigned long free_count;
+typedef void alloc_hook_t(size_t len);
+extern alloc_hook_t *alloc_hook;
 
 /* Error exits. */
 void Error(const char *);
@@ -47,6 +47,7 @@ typedef enum {
 #define HF_NONE		0x0
 #define HF_TRAILER	0x1	/* include standard trailer */
 #define HF_HIDDEN	0x2	/* do not include in directory listings */
+#define HF_RAW_NL	0x4	/* do not expand newlines to CR/LF */
 
 typedef enum {
     HS_CONTINUE = 0,		/* incomplete request */
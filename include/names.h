@@ -36,6 +36,7 @@
 #define AnAttn		"Attn"
 #define AnBackSpace	"BackSpace"
 #define AnBackTab	"BackTab"
+#define AnBatch		"Batch"
 #define AnBell		"Bell"
 #define AnAnsiText	"AnsiText"
 #define AnAscii		"Ascii"
@@ -78,6 +79,7 @@
 #define AnFieldMark	"FieldMark"
 #define AnForceStatus	"ForceStatus"
 #define AnFlip		"Flip"
+#define AnFlushResolverCache "FlushResolverCache"
 #define AnHexString	"HexString"
 #define AnHome		"Home"
 #define	AnHelp		"Help"
@@ -119,6 +121,7 @@
 #define AnRedraw	"Redraw"
 #define AnRequestInput	"RequestInput"
 #define AnReset		"Reset"
+#define AnResetResponseTimes "ResetResponseTimes"
 #define AnRestoreInput	"RestoreInput"
 #define AnRight		"Right"
 #define AnRight2	"Right2"
@@ -126,6 +129,7 @@
 #define AnScreenTrace	"ScreenTrace"
 #define AnScript	"Script"
 #define AnScroll	"Scroll"
+#define AnSearch	"Search"
 #define AnSelectDown	"SelectDown"
 #define AnSelectLeft	"SelectLeft"
 #define AnSelectRight	"SelectRight"
@@ -157,6 +161,9 @@
 #define KwFailOnError	"failonerror"
 #define KwNoFailOnError	"nofailonerror"
 #define KwAuto		"auto"
+/*  Parameters to Batch(). */
+#define KwContinue	"continue"
+#define KwStopOnError	"stoponerror"
 /*  Parameters to Capabilities(). */
 #define KwInteractive	"interactive"
 #define KwPwInput	"pwinput"
@@ -214,6 +221,7 @@
 #define KwDirs		"Dirs"
 #define KwDisplayPixels	"DisplayPixels"
 #define KwResolver	"Resolver"
+#define KwResolverCache	"ResolverCache"
 #define KwFormatted	"Formatted"
 #define KwHost		"Host"
 #define KwKeyboardLock	"KeyboardLock"
@@ -224,8 +232,10 @@
 #define KwModel		"Model"
 #define KwOutputQueues	"OutputQueues"
 #define KwPrefixes	"Prefixes"
+#define KwProfile	"Profile"
 #define KwProxy		"Proxy"
 #define KwReplyMode	"ReplyMode"
+#define KwResponseTimes	"ResponseTimes"
 #define KwScreenCurSize	"ScreenCurSize"
 #define KwScreenMaxSize	"ScreenMaxSize"
 #define KwScreenSizeCurrent "ScreenSizeCurrent"
@@ -241,10 +251,13 @@
 #define KwTelnetMyOptions "TelnetMyOptions"
 #define KwTelnetHostOptions "TelnetHostOptions"
 #define KwTerminalName	"TerminalName"
+#define KwTransferStats "TransferStats"
+#define KwTypeahead	"Typeahead"
 #define KwTn3270eOptions "Tn3270eOptions"
 #define KwTraceFile	"TraceFile"
 #define KwTls		"Tls"
 #define KwTlsCertInfo	"TlsCertInfo"
+#define KwTlsHandshakes	"TlsHandshakes"
 #define KwTlsProvider	"TlsProvider"
 #define KwTlsSessionInfo "TlsSessionInfo"
 #define KwTlsSubjectNames "TlsSubjectNames"
@@ -313,6 +326,18 @@
 #define KwCursorAt	"cursorat"
 #define KwStringAt	"stringat"
 #define KwInputFieldAt	"inputfieldat"
+#define KwSearch	"search"
+#define KwFieldCount	"fieldcount"
+#define KwCursorInField	"cursorinfield"
+/*  Parameters to Wait(Oia). */
+#define KwLocked	"locked"
+#define KwUnlocked	"unlocked"
+#define KwUnformatted	"unformatted"
+/*  Parameters to Search(). */
+#define KwRegex		"regex"
+#define KwProtected	"protected"
+#define KwUnprotected	"unprotected"
+#define KwRegion	"region"
 /*  Parameters to WindowState(). */
 #define KwIconic	"iconic"
 #define KwNormal	"normal"
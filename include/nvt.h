@@ -32,6 +32,7 @@
 
 void nvt_init(void);
 void nvt_process(unsigned int c);
+void nvt_process_run(const unsigned char *buf, size_t len);
 void nvt_send_clear(void);
 void nvt_send_down(void);
 void nvt_send_end(void);
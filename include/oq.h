@@ -33,12 +33,16 @@
 #include "trace.h"
 
 typedef struct oq *oq_t;
+typedef void oq_backpressure_fn(bool backed_up);
 
 void oq_init(const char *spec);
 oq_t oq_create_socket(const char *name, tc_t tc, socket_t socket);
 oq_t oq_create_stdout(const char *name, tc_t tc);
 bool oq_write(oq_t oq, const char *data, size_t len, const char **errmsg);
 bool oq_errored(oq_t oq, const char **errmsg);
+void oq_set_backpressure(oq_t oq, oq_backpressure_fn *fn);
+bool oq_backed_up(oq_t oq);
+size_t oq_queued(void);
 void oq_free(oq_t *oq);
 
 void oq_register(void);
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2026 Paul Mattes.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the names of Paul Mattes nor the names of his contributors
+ *       may be used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY PAUL MATTES "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL PAUL MATTES BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+ *      profile.h
+ *              Per-subsystem allocation and CPU profiling.
+ */
+
+/* Profiling categories. */
+typedef enum {
+    PC_OTHER,		/* not otherwise categorized */
+    PC_CTLR,		/* 3270 data stream processing */
+    PC_SCREEN,		/* screen rendering */
+    PC_TASKS,		/* task queue */
+    PC_IO,		/* I/O event dispatch */
+    PC_JSON,		/* JSON parsing and formatting */
+    PC_UI,		/* UI stream */
+    PC_TRACE,		/* tracing */
+    NUM_PC
+} prof_cat_t;
+
+prof_cat_t prof_switch(prof_cat_t cat);
+const char *prof_name(prof_cat_t cat);
+void prof_get(prof_cat_t cat, unsigned long *allocs, unsigned long long *bytes,
+	unsigned long long *cpu_usec);
+void profile_register(void);
+
+/*
+ * Enter a profiling category, returning the one to go back to.
+ * When profiling is off, this is just a test of appres.profile.
+ */
+#define prof_enter(cat)	(appres.profile? prof_switch(cat): PC_OTHER)
+
+/* Go back to the previous profiling category. */
+#define prof_leave(prev) do { \
+    if (appres.profile) { \
+	(void) prof_switch(prev); \
+    } \
+} while (false)
@@ -53,5 +53,8 @@ rhp_t resolve_host_and_port_abs(const char *host, const char *portname,
 void cleanup_host_and_port(int slot);
 
 void set_46(bool prefer4, bool prefer6);
+void set_resolver_cache_ttl(int ttl, int neg_ttl);
+void resolver_cache_flush(void);
+const char *resolver_cache_dump(void);
 
 extern int gai_slots;
@@ -50,6 +50,7 @@
 #define ResBaselevelTranslations	"baselevelTranslations"
 #define ResBellMode		"bellMode"
 #define ResBellVolume		"bellVolume"
+#define ResBinaryScreen		"binaryScreen"
 #define ResBindUnlock		"bindUnlock"
 #define ResBindLimit		"bindLimit"
 #define ResBlankFill		"blankFill"
@@ -72,6 +73,7 @@
 #define ResCommandTimeout	"commandTimeout"
 #define ResComposeMap		"composeMap"
 #define ResConfDir		"confDir"
+#define ResConnectAttemptDelay	"connectAttemptDelay"
 #define ResConnectFileName	"connectFileName"
 #define ResConnectTimeout	"connectTimeout"
 #define ResConsole		"console"
@@ -164,6 +166,7 @@
 #define ResMacros		"macros"
 #define ResMarginedPaste	"marginedPaste"
 #define ResMaximize		"maximize"
+#define ResMaxFrameRate		"maxFrameRate"
 #define ResMaxRecent		"maxRecent"
 #define ResMenuBar		"menuBar"
 #define ResMetaEscape		"metaEscape"
@@ -200,11 +203,14 @@
 #define ResPrinterName		"printer.name"
 #define ResPrinterOptions	"printer.options"
 #define ResPrintDialog		"printDialog"
+#define ResProfile		"profile"
 #define ResProxy		"proxy"
 #define ResQuit			"quit"
 #define ResQrBgColor		"qrBgColor"
 #define ResReconnect		"reconnect"
 #define ResRectangleSelect	"rectangleSelect"
+#define ResResolverCacheNegTtl	"resolverCacheNegativeTtl"
+#define ResResolverCacheTtl	"resolverCacheTtl"
 #define ResRetry		"retry"
 #define ResReverseInputMode	"reverseInputMode"
 #define ResReverseVideo		"reverseVideo"
@@ -221,6 +227,7 @@
 #define ResScriptedAlways	"scriptedAlways"
 #define ResScriptPort		"scriptPort"
 #define ResScriptPortOnce	"scriptPortOnce"
+#define ResScriptPortPipeline	"scriptPortPipeline"
 #define ResScrollBar		"scrollBar"
 #define ResSecure		"secure"
 #define ResSelectBackground	"selectBackground"
@@ -236,9 +243,11 @@
 #define ResTermName		"termName"
 #define ResTitle		"title"
 #define ResTls992		"tls992"
+#define ResTlsKernelOffload	"tlsKernelOffload"
 #define ResTlsMaxProtocol	"tlsMaxProtocol"
 #define ResTlsMinProtocol	"tlsMinProtocol"
 #define ResTlsSecurityLevel	"tlsSecurityLevel"
+#define ResTlsSessionCacheFile	"tlsSessionCacheFile"
 #define ResTrace		"trace"
 #define ResTraceDir		"traceDir"
 #define ResTraceFile		"traceFile"
@@ -364,6 +373,7 @@
 #define ClsColorScheme		"ColorScheme"
 #define ClsComposeMap		"ComposeMap"
 #define ClsConfDir		"ConfDir"
+#define ClsConnectAttemptDelay	"ConnectAttemptDelay"
 #define ClsConnectFileName	"ConnectFileName"
 #define ClsConnectTimeout	"ConnectTimeout"
 #define ClsConsole		"Console"
@@ -464,10 +474,13 @@
 #define ClsPreferIpv4		"PreferIpv4"
 #define ClsPreferIpv6		"PreferIpv6"
 #define ClsPrinterLu		"PrinterLu"
+#define ClsProfile		"Profile"
 #define ClsProxy		"Proxy"
 #define ClsQuit			"Quit"
 #define ClsReconnect		"Reconnect"
 #define ClsRectangleSelect	"RectangleSelect"
+#define ClsResolverCacheNegTtl	"ResolverCacheNegativeTtl"
+#define ClsResolverCacheTtl	"ResolverCacheTtl"
 #define ClsRetry		"Retry"
 #define ClsReverseInputMode	"ReverseInputMode"
 #define ClsRightToLeftMode	"RightToLeftMode"
@@ -483,6 +496,7 @@
 #define ClsScriptedAlways	"ScriptedAlways"
 #define ClsScriptPort		"ScriptPort"
 #define ClsScriptPortOnce	"ScriptPortOnce"
+#define ClsScriptPortPipeline	"ScriptPortPipeline"
 #define ClsScrollBar		"ScrollBar"
 #define ClsSecure		"Secure"
 #define ClsSelectBackground	"SelectBackground"
@@ -495,9 +509,11 @@
 #define ClsSuppressFontMenu	"SuppressFontMenu"
 #define ClsTermName		"TermName"
 #define ClsTls992		"Tls992"
+#define ClsTlsKernelOffload	"TlsKernelOffload"
 #define ClsTlsMaxProtocol	"TlsMaxProtocol"
 #define ClsTlsMinProtocol	"TlsMinProtocol"
 #define ClsTlsSecurityLevel	"TlsSecurityLevel"
+#define ClsTlsSessionCacheFile	"TlsSessionCacheFile"
 #define ClsTrace		"Trace"
 #define ClsTraceDir		"TraceDir"
 #define ClsTraceFile		"TraceFile"
@@ -529,6 +545,7 @@
 #define OptAllBold		"-allbold"
 #define OptAltScreen		"-altscreen"
 #define OptAplMode		"-apl"
+#define OptBinaryScreen		"-binaryscreen"
 #define OptCaDir		"-cadir"
 #define OptCaFile		"-cafile"
 #define OptCallback		"-callback"
@@ -600,8 +617,10 @@
 #define OptNoVerifyHostCert	"-noverifycert"
 #define OptTermName		"-tn"
 #define OptTitle		"-title"
+#define OptTlsKernelOffload	"-tlskerneloffload"
 #define OptTlsMaxProtocol	"-tlsmaxprotocol"
 #define OptTlsMinProtocol	"-tlsminprotocol"
+#define OptTlsSessionCacheFile	"-tlssessioncachefile"
 #define OptTrace		"-trace"
 #define OptTraceFile		"-tracefile"
 #define OptTraceFileSize	"-tracefilesize"
@@ -48,6 +48,9 @@
 #define INPUT_PREFIX	"inpt: "
 #define PWINPUT_PREFIX	"inpw: "
 
+/* Prefix for a tagged request, and for each line of its response. */
+#define TAG_PREFIX	'@'
+
 /* Prompt terminators. */
 #define PROMPT_OK	"ok"
 #define PROMPT_ERROR	"error"
@@ -61,3 +64,4 @@
 #define JRET_RESULT_ERR	"result-err"
 #define JRET_SUCCESS	"success"
 #define JRET_STATUS	"status"
+#define JRET_TAG	"tag"
@@ -42,10 +42,12 @@ void mcursor_normal(void);
 void mcursor_waiting(void);
 bool screen_obscured(void);
 void screen_scroll(unsigned char fg, unsigned char bg);
+bool screen_scroll_hold(unsigned char fg, unsigned char bg);
 unsigned long screen_window_number(void);
 bool screen_has_bg_color(void);
 void ring_bell(void);
 void screen_disp(bool erasing);
+void screen_flush(void);
 void screen_80(void);
 void screen_132(void);
 void screen_flip(void);
@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2026 Paul Mattes.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the names of Paul Mattes nor the names of his contributors
+ *       may be used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY PAUL MATTES "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL PAUL MATTES BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+ *      screen_text.h
+ *              Incrementally maintained text mirror of the screen.
+ */
+
+size_t screen_text_cell(struct ea *buf, int baddr, bool *is_zero,
+	int *fa_cs, bool force_utf8, char *mb, size_t mb_len);
+void screen_text_sync(bool force_utf8);
+const char *screen_text_span(int row, int col, int ncols, bool force_utf8,
+	size_t *len);
+char *screen_text_grab(int baddr, size_t len, bool force_utf8);
+
+typedef struct screen_search screen_search_t;
+typedef void screen_search_fn(int row, int col, int len);
+screen_search_t *screen_search_new(const char *action, unsigned argc,
+	const char **argv, bool force_utf8);
+unsigned screen_search(const screen_search_t *ss, screen_search_fn *found);
+void screen_search_free(screen_search_t *ss);
+void screen_text_register(void);
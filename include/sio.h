@@ -80,6 +80,7 @@ int sio_read(sio_t sio, char *buf, size_t buflen);
 int sio_write(sio_t sio, const char *buf, size_t buflen);
 void sio_close(sio_t sio);
 bool sio_secure_unverified(sio_t sio);
+bool sio_session_resumed(sio_t sio);
 const char *sio_session_info(sio_t sio);
 const char *sio_server_cert_info(sio_t sio);
 const char *sio_server_subject_names(sio_t sio);
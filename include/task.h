@@ -40,6 +40,16 @@ struct macro_def {
 extern struct macro_def *macro_defs;
 typedef void *task_cbh;
 
+/* Events that wake up blocked tasks. */
+#define TE_KEYBOARD	0x01	/* keyboard lock changed */
+#define TE_CONNECT	0x02	/* connection state changed */
+#define TE_OUTPUT	0x04	/* host output arrived */
+#define TE_SCREEN	0x08	/* screen contents changed */
+#define TE_CURSOR	0x10	/* cursor moved */
+#define TE_ALL		0x1f
+extern unsigned task_events;
+#define task_wake(events)	(task_events |= (events))
+
 void abort_script(void);
 void abort_script_by_cb(const char *cb_name);
 void abort_queue(const char *unique_name);
@@ -67,6 +77,7 @@ void task_passthru_done(const char *tag, bool success, const char *result);
 bool task_redirect(void);
 const char *task_set_passthru(task_cbh **ret_cbh);
 void task_store(unsigned char c);
+void task_stats(unsigned *queues, unsigned *tasks, unsigned *waiting);
 void task_abort_input_request_irhandle(void *irhandle);
 void task_abort_input_request(void);
 bool task_is_interactive(void);
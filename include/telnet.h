@@ -38,6 +38,7 @@
 
 extern int ns_brcvd;
 extern int ns_bsent;
+extern size_t ns_bqueued;
 extern int ns_rrcvd;
 extern int ns_rsent;
 extern time_t ns_time;
@@ -83,6 +84,7 @@ const char *net_session_info(void);
 void net_password_continue(const char *password);
 unsigned net_sio_supported(void);
 const char *net_sio_provider(void);
+const char *net_query_tls_handshakes(void);
 const char *net_myopts(void);
 const char *net_hisopts(void);
 void net_register(void);
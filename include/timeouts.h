@@ -43,3 +43,4 @@
 bool compute_timeout(TIMEOUT_T *timeout, bool block);
 bool process_timeouts(void);
 const char *trace_tmo(TIMEOUT_T tmo, char *buf, size_t bufsize);
+void timeout_stats(unsigned *pending, unsigned long *fired);
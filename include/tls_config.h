@@ -49,6 +49,8 @@ typedef struct {
     char	*min_protocol;
     char	*max_protocol;
     char	*security_level;
+    char	*session_cache_file;
+    bool	 kernel_offload;
 } tls_config_t;
 
 /* Required options. */
@@ -71,12 +73,15 @@ typedef struct {
 #define TLS_OPT_MIN_PROTOCOL		0x00001000
 #define TLS_OPT_MAX_PROTOCOL		0x00002000
 #define TLS_OPT_SECURITY_LEVEL		0x00004000
+#define TLS_OPT_SESSION_CACHE_FILE	0x00008000
+#define TLS_OPT_KERNEL_OFFLOAD		0x00010000
 
 #define TLS_OPTIONAL_OPTS \
     (TLS_OPT_CA_DIR | TLS_OPT_CA_FILE | TLS_OPT_CERT_FILE | \
      TLS_OPT_CERT_FILE_TYPE | TLS_OPT_CHAIN_FILE | TLS_OPT_KEY_FILE | \
      TLS_OPT_KEY_FILE_TYPE | TLS_OPT_KEY_PASSWD | TLS_OPT_CLIENT_CERT | \
-     TLS_OPT_MIN_PROTOCOL | TLS_OPT_MAX_PROTOCOL | TLS_OPT_SECURITY_LEVEL)
+     TLS_OPT_MIN_PROTOCOL | TLS_OPT_MAX_PROTOCOL | TLS_OPT_SECURITY_LEVEL | \
+     TLS_OPT_SESSION_CACHE_FILE | TLS_OPT_KERNEL_OFFLOAD)
 
 #define TLS_ALL_OPTS	(TLS_REQUIRED_OPTS | TLS_OPTIONAL_OPTS)
 
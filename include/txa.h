@@ -30,7 +30,12 @@
  *              Transaction allocator.
  */
 
+void *txalloc(size_t len);
+void *txrealloc(void *buf, size_t old_len, size_t new_len);
 const char *txdFree(void *buf);
 const char *txAsprintf(const char *fmt, ...) printflike(1, 2);
 const char *txVasprintf(const char *fmt, va_list args);
 void txflush(void);
+
+/* Initialize a varbuf whose contents live until the next txflush(). */
+#define vb_init_tx(r)	vb_init_alloc(r, txrealloc)
@@ -34,6 +34,7 @@
 
 #define JSON_MODE	(appres.b3270.json)
 #define XML_MODE	(!appres.b3270.json)
+#define BINARY_MODE	(appres.b3270.binary_screen)
 
 /* Attribute types. */
 typedef enum {
@@ -50,6 +51,7 @@ typedef enum {
 void ui_io_init(void);
 void ui_leaf(const char *name, ...);
 void ui_add_element(const char *name, ui_attr_t attr, ...);
+bool ui_backed_up(void);
 
 /* XML-specific functions. */
 void uix_pop(void);
@@ -63,6 +65,14 @@ void uij_open_array(const char *name);
 void uij_close_object(void);
 void uij_close_array(void);
 
+/* Binary-specific functions. */
+void uib_start(unsigned char type);
+void uib_put8(unsigned value);
+void uib_put16(unsigned value);
+void uib_put32(unsigned long value);
+void uib_put_string(const char *s, size_t len);
+void uib_end(void);
+
 /* Helper functions. */
 const char *get_jstring(const json_t *j, const char *element, const char *attribute);
 void ui_unknown_attribute(const char *element, const char *attribute);
@@ -30,13 +30,21 @@
  *              Header file for x3270 variable-length buffer library.
  */
 
+/*
+ * Alternate allocator: returns new_len bytes of space, holding the first
+ * old_len bytes of buf.
+ */
+typedef void *vb_alloc_t(void *buf, size_t old_len, size_t new_len);
+
 typedef struct {
     char *buf;
     size_t len;
     size_t alloc_len;
+    vb_alloc_t *alloc;	/* alternate allocator, or NULL for Realloc */
 } varbuf_t;
 
 void vb_init(varbuf_t *r);
+void vb_init_alloc(varbuf_t *r, vb_alloc_t *alloc);
 void vb_append(varbuf_t *r, const char *buf, size_t len);
 void vb_appends(varbuf_t *r, const char *buf);
 void vb_vappendf(varbuf_t *r, const char *format, va_list ap);
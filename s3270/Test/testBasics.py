@@ -47,7 +47,36 @@ class TestS3270Basics(cti):
         # Query something ambiguous.
         r = self.get(f'http://127.0.0.1:{http_port}/3270/rest/json/b')
         result = r.json()['result']
-        self.assertEqual("Ambiguous action name 'b': BackSpace(), BackTab(), Bell()", result[0])
+        self.assertEqual("Ambiguous action name 'b': BackSpace(), BackTab(), Batch(), Bell()", result[0])
+
+        # Stop s3270.
+        self.get(f'http://127.0.0.1:{http_port}/3270/rest/json/Quit(-force))')
+
+        # Wait for the process to exit.
+        self.vgwait(s3270)
+
+    # s3270 action name resolution test
+    def test_s3270_action_prefix(self):
+        # Start s3270.
+        http_port, ts = unused_port()
+        s3270 = Popen(vgwrap(['s3270', '-httpd', f'127.0.0.1:{http_port}']), stdin=DEVNULL, stdout=DEVNULL)
+        self.children.append(s3270)
+        ts.close()
+        self.check_listen(http_port)
+
+        # Unique prefixes and names in any case resolve, the same way each
+        # time they are run.
+        for _ in range(3):
+            r = self.get(f'http://127.0.0.1:{http_port}/3270/rest/json/que(cursor1)')
+            self.assertEqual(['row 1 column 1 offset 0'], r.json()['result'])
+            r = self.get(f'http://127.0.0.1:{http_port}/3270/rest/json/QUERY(Cursor1)')
+            self.assertEqual(['row 1 column 1 offset 0'], r.json()['result'])
+
+        # Unknown actions fail, and keep failing.
+        for _ in range(2):
+            r = self.get(f'http://127.0.0.1:{http_port}/3270/rest/json/Zzz()')
+            self.assertFalse(r.ok)
+            self.assertEqual('Unknown action: Zzz', r.json()['result'][0])
 
         # Stop s3270.
         self.get(f'http://127.0.0.1:{http_port}/3270/rest/json/Quit(-force))')
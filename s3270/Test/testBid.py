@@ -148,12 +148,20 @@ class TestS3270Bid(cti):
             r = self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Enter()')
             self.assertTrue(r.ok)
 
+            # Check the typeahead queue.
+            r = self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Query(Typeahead)')
+            self.assertEqual('depth 2 max-depth 2 capacity 1024 dropped 0 overflowed 0', r.json()['result'][0])
+
             # Unblock the BID.
             p.send_records(1, send_tm = False)
 
             # Get the queued response.
             data = p.nread(8 + 14, 0.5)
 
+            # Check that the queue drained.
+            r = self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Query(Typeahead)')
+            self.assertTrue(r.json()['result'][0].startswith('depth 0 max-depth 2 '))
+
         self.assertEqual(data, b'\x02\x00\x00\x00/\x00\xff\xef\x00\x00\x00\x00\x00}\x01\xa1\x11\x01\xa0\x81\xff\xef', 'Expected Enter')
 
         # Wait for the processes to exit.
@@ -38,6 +38,17 @@ from Common.Test.playback import playback
 @requests_timeout
 class TestS3270ft(cti):
 
+    # Check the Query(TransferStats) output for a completed transfer.
+    def check_stats(self, line: str, mode: str, length: int, records: int, round_trips: int) -> dict:
+        stats = line.split()
+        self.assertEqual(['data:', 'complete', 'send', mode, 'bytes', str(length)], stats[0:6])
+        values = dict(zip(stats[4::2], stats[5::2]))
+        self.assertEqual(str(records), values['records'])
+        self.assertEqual(str(round_trips), values['round-trips'])
+        for field in ['host-wait', 'local', 'elapsed']:
+            self.assertGreaterEqual(float(values[field]), 0.0)
+        return values
+
     # s3270 DFT-mode file transfer test
     def test_s3270_ft_dft(self):
 
@@ -53,6 +64,7 @@ class TestS3270ft(cti):
 
             # Feed s3270 some actions.
             s3270.stdin.write(b'transfer direction=send host=tso localfile=s3270/Test/fttext hostfile=fttext\n')
+            s3270.stdin.write(b'Query(TransferStats)\n')
             s3270.stdin.write(b"PF(3)\n")
             s3270.stdin.flush()
 
@@ -63,7 +75,11 @@ class TestS3270ft(cti):
             stdout = s3270.communicate()[0].decode().split('\n')
             self.assertEqual('data: Transfer complete, 19925 bytes transferred', stdout[0].strip())
             self.assertTrue('bytes/sec in DFT mode' in stdout[1])
-            self.assertEqual('ok', stdout[3].strip())
+            self.assertTrue(stdout[2].strip().startswith('data: 2 records, 10 host round trips'))
+            self.assertTrue(stdout[2].strip().endswith('buffer size 16384'))
+            self.assertEqual('ok', stdout[4].strip())
+            stats = self.check_stats(stdout[5], 'dft', 19925, 2, 10)
+            self.assertEqual('16384', stats['buffer-size'])
 
         # Wait for the process to exit.
         s3270.stdin.close()
@@ -84,6 +100,7 @@ class TestS3270ft(cti):
 
             # Feed s3270 some actions.
             s3270.stdin.write(b'transfer direction=send host=vm "localfile=s3270/Test/fttext" "hostfile=ft text a"\n')
+            s3270.stdin.write(b'Query(TransferStats)\n')
             s3270.stdin.write(b"String(logoff)\n")
             s3270.stdin.write(b"Enter()\n")
             s3270.stdin.flush()
@@ -95,7 +112,9 @@ class TestS3270ft(cti):
             stdout = s3270.communicate()[0].decode().split('\n')
             self.assertEqual('data: Transfer complete, 19580 bytes transferred', stdout[0].strip())
             self.assertTrue('bytes/sec in CUT mode' in stdout[1])
-            self.assertEqual('ok', stdout[3].strip())
+            self.assertTrue(stdout[2].strip().startswith('data: 12 records, 14 host round trips'))
+            self.assertEqual('ok', stdout[4].strip())
+            self.check_stats(stdout[5], 'cut', 19580, 12, 14)
 
         # Wait for the process to exit.
         s3270.stdin.close()
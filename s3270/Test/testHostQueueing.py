@@ -36,6 +36,11 @@ from Common.Test.playback import playback
 @requests_timeout
 class TestS3270HostQueueing(cti):
 
+    # Get the number of bytes queued for the host.
+    def queued(self, hport: int) -> int:
+        tx = self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Query(StatsTx)').json()['result'][0].split()
+        return int(tx[tx.index('queued') + 1]) if 'queued' in tx else 0
+
     # s3270 host queueing test
     def test_s3270_host_queueing(self):
 
@@ -59,7 +64,7 @@ class TestS3270HostQueueing(cti):
             #  telnet.eor
             p.send_literal('000001000211000609000243ffef')
 
-            # Blast until it hangs.
+            # Blast until the emulator stops reading.
             # tn3270e 3270e-data
             #  cmd.rb
             #  telnet eor
@@ -78,16 +83,29 @@ class TestS3270HostQueueing(cti):
                     break
                 r = self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Query(ConnectionState)')
                 result = r.json()['result'][0]
-                if result == 'not-connected':
+                self.assertNotEqual('not-connected', result, 'Emulator disconnected')
+                if self.queued(hport) >= 64 * 1024:
                     break
             #print(f'Took {time.monotonic()-t0} seconds')
 
+            # The emulator should have queued its replies and stopped reading,
+            # rather than failing the connection or queueing without limit.
+            r = self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Query(ConnectionState)')
+            self.assertEqual('connected-tn3270e', r.json()['result'][0])
+            queued = self.queued(hport)
+            for i in range(300):
+                try:
+                    p.send_literal('000001000302ffef')
+                except (BlockingIOError, ConnectionResetError):
+                    break
+            time.sleep(0.5)
+            self.assertEqual(queued, self.queued(hport))
+
         # Wait for the processes to exit.
         self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Quit()')
         self.vgwait(s3270)
         stderr = s3270.stderr.readlines()
-        self.assertTrue(stderr[0].startswith(b'Connection failed:'))
-        self.assertTrue(stderr[1].startswith(b'Socket write:'))
+        self.assertEqual([], stderr)
         s3270.stderr.close()
 
 if __name__ == '__main__':
@@ -29,9 +29,11 @@
 
 from subprocess import Popen, PIPE, DEVNULL
 import requests
+import threading
 import unittest
 
 from Common.Test.cti import *
+from Common.Test.playback import playback
 
 class TestS3270Httpd(cti):
 
@@ -66,6 +68,70 @@ class TestS3270Httpd(cti):
         s.close()
         self.vgwait(s3270)
 
+    # s3270 HTTPD metrics test.
+    def test_s3270_httpd_metrics(self):
+
+        # Start 'playback' to emulate the host.
+        pport, socket = unused_port()
+        with playback(self, 's3270/Test/ibmlink.trc', port=pport) as p:
+            socket.close()
+
+            # Start s3270.
+            hport, socket = unused_port()
+            s3270 = Popen(vgwrap(['s3270', '-httpd', str(hport), f'127.0.0.1:{pport}']),
+                stdin=DEVNULL, stdout=DEVNULL)
+            self.children.append(s3270)
+            socket.close()
+            self.check_listen(hport)
+
+            # Paint the screen, then send an AID and get the host's answer.
+            # Enter() blocks until the host answers, so run it in the background.
+            p.send_records(4)
+            enter = threading.Thread(target=self.get, args=[f'http://127.0.0.1:{hport}/3270/rest/json/Enter()'])
+            enter.start()
+            p.nread(1)
+            p.send_records(1)
+            enter.join(timeout=5)
+            self.assertFalse(enter.is_alive(), 'Enter() did not complete')
+
+            # Fetch the metrics.
+            r = self.get(f'http://127.0.0.1:{hport}/3270/rest/metrics')
+            self.assertTrue(r.ok)
+            self.assertTrue(r.headers['Content-Type'].startswith('text/plain'))
+            self.assertNotIn('\r', r.text)
+            metrics = {}
+            for line in r.text.splitlines():
+                if not line.startswith('#'):
+                    name, value = line.rsplit(' ', 1)
+                    metrics[name] = float(value)
+
+            # Check the response time summary, then reset it.
+            r = self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Query(ResponseTimes)')
+            self.assertTrue(r.ok)
+            times = { line.split()[0]: line.split()[1:] for line in r.json()['result'] }
+            for key in ['all', 'connection', 'Enter']:
+                self.assertEqual(['count', '1'], times[key][0:2])
+                self.assertEqual(['mean', 'p50', 'p90', 'p99', 'max'], times[key][2::2])
+            self.get(f'http://127.0.0.1:{hport}/3270/rest/json/ResetResponseTimes()')
+            r = self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Query(ResponseTimes)')
+            self.assertEqual(['all', 'connection'], [line.split()[0] for line in r.json()['result']])
+            self.assertTrue(all(line.split()[2] == '0' for line in r.json()['result']))
+
+        # Check them.
+        self.assertEqual(1, metrics['x3270_connection_state{state="connected-tn3270e"}'])
+        self.assertEqual(0, metrics['x3270_connection_state{state="not-connected"}'])
+        self.assertGreater(metrics['x3270_bytes_received_total'], 0)
+        self.assertGreater(metrics['x3270_records_received_total'], 0)
+        self.assertGreater(metrics['x3270_bytes_sent_total'], 0)
+        self.assertEqual(1, metrics['x3270_host_response_seconds_count{aid="Enter"}'])
+        self.assertEqual(1, metrics['x3270_host_response_seconds_bucket{aid="Enter",le="+Inf"}'])
+        self.assertEqual(1, metrics['x3270_host_response_seconds_bucket{aid="Enter",le="60.000"}'])
+        self.assertGreater(metrics['x3270_allocations_total'], 0)
+
+        # Wait for s3270 to exit.
+        self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Quit()')
+        self.vgwait(s3270)
+
     # s3270 HTTPD stext error test.
     def s3270_httpd_stext_error_test(self, actions:str, content:str):
 
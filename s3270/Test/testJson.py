@@ -577,5 +577,99 @@ class TestS3270Json(cti):
     def test_s3270_pipechild_json_result_spaces(self):
         self.s3270_pipechild(self, suffix='-spaces')
 
+    # s3270 JSON batch socket test
+    def test_s3270_socket_json_batch(self):
+
+        # Start s3270.
+        port, ts = unused_port()
+        s3270 = Popen(vgwrap(['s3270', '-scriptport', str(port)]))
+        self.children.append(s3270)
+        self.check_listen(port)
+        ts.close()
+
+        # Push two batches at it, one that continues after an error and one
+        # that stops.
+        s = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        s.connect(('127.0.0.1', port))
+        batch = [{'action':'Set','args':['startTls']}, {'action':'Fail'}, {'action':'Set','args':['startTls']}]
+        s.sendall(json.dumps({'batch':batch,'continue':True}).encode('utf8') + b'\n')
+        s.sendall(json.dumps({'batch':batch}).encode('utf8') + b'\n')
+        result = self.recv_to_eof(s, 2).splitlines()
+        s.close()
+
+        s = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        s.connect(('127.0.0.1', port))
+        s.sendall(b'quit\n')
+        s.close()
+
+        # Wait for the process to exit successfully.
+        self.vgwait(s3270)
+
+        # Test the output.
+        j = json.loads(result[0])
+        self.assertFalse(j['success'])
+        self.assertEqual(['true', 'batch 1 Set(startTls) ok', 'Failed', 'batch 2 Fail() error', 'true', 'batch 3 Set(startTls) ok'], j['result'])
+        self.assertEqual([False, False, True, True, False, False], j['result-err'])
+        j = json.loads(result[1])
+        self.assertFalse(j['success'])
+        self.assertEqual(['true', 'batch 1 Set(startTls) ok', 'Failed', 'batch 2 Fail() error'], j['result'])
+
+    # s3270 pipelined, tagged socket test
+    def test_s3270_socket_pipeline(self):
+
+        # Start s3270, allowing only two queued requests.
+        port, ts = unused_port()
+        s3270 = Popen(vgwrap(['s3270', '-xrm', 's3270.scriptPortPipeline: 2', '-scriptport', str(port)]))
+        self.children.append(s3270)
+        self.check_listen(port)
+        ts.close()
+
+        # Send a series of requests without waiting for the replies.
+        s = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        s.connect(('127.0.0.1', port))
+        s.sendall(b'@a Wait(0.1,Seconds)\r\n@b Fail(x)\n@c {"action":"Set","args":["startTls"]}\n' +
+            b''.join(b'@%d Set(startTls)\n' % i for i in range(5)) + b'Set(startTls)\n')
+        result = self.recv_to_eof(s, 2).splitlines()
+        s.close()
+
+        s = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        s.connect(('127.0.0.1', port))
+        s.sendall(b'quit\n')
+        s.close()
+
+        # Wait for the process to exit successfully.
+        self.vgwait(s3270)
+
+        # Test the output. The replies are in order, and tagged.
+        self.assertTrue(result[0].startswith('@a L U U N N '))
+        self.assertEqual('@a ok', result[1])
+        self.assertEqual(['@b data: x', '@b error'], [result[2], result[4]])
+        j = json.loads(result[5])
+        self.assertEqual('c', j['tag'])
+        self.assertTrue(j['success'])
+        for i in range(5):
+            self.assertEqual([f'@{i} data: true', f'@{i} ok'], [result[6 + i * 3], result[8 + i * 3]])
+        self.assertEqual(['data: true', 'ok'], [result[21], result[23]])
+
+    # s3270 text batch stdin test
+    def test_s3270_stdin_batch(self):
+
+        # Start s3270.
+        s3270 = Popen(vgwrap(['s3270']), stdin=PIPE, stdout=PIPE)
+        self.children.append(s3270)
+
+        # Push a batch at it.
+        s3270.stdin.write(b'Batch(Continue) Set(startTls) Fail(x) Set(startTls)\n')
+
+        # Decode the result.
+        stdout = s3270.communicate()[0].decode('utf8').splitlines()
+
+        # Wait for the process to exit successfully.
+        self.vgwait(s3270)
+
+        # Test the output.
+        self.assertEqual(['data: true', 'data: batch 1 Set(startTls) ok', 'data: x', 'data: batch 2 Fail(x) error', 'data: true', 'data: batch 3 Set(startTls) ok'], stdout[:6])
+        self.assertEqual('error', stdout[7])
+
 if __name__ == '__main__':
     unittest.main()
@@ -99,6 +99,101 @@ class TestNewWait(cti):
     def test_input_field_at_offset(self):
         self.new_wait(3, [], 'InputFieldAt,1612', playback, 1)
 
+    # Screen predicates.
+    def test_field_count(self):
+        self.new_wait(3, [], 'FieldCount,44', playback, 1)
+    def test_cursor_in_field(self):
+        self.new_wait(3, [], 'CursorInField,32', playback, 1)
+    def test_oia(self):
+        self.new_wait(3, [], 'Oia,Formatted', playback, 1)
+
+    # Count the tasks blocked in Wait().
+    def blocked_waits(self, port):
+        j = self.get(f'http://127.0.0.1:{port}/3270/rest/json/Query(Tasks)').json()
+        return sum(1 for line in j['result'] if 'Wait(' in line)
+
+    # Several Wait()s blocked at once, each woken only by its own event.
+    def test_concurrent_waits(self):
+
+        # Start 'playback' to drive s3270.
+        pport, pts = unused_port()
+        with playback(self, 's3270/Test/ibmlink.trc', port=pport) as p:
+            pts.close()
+
+            # Start s3270 with a webserver.
+            sport, sts = unused_port()
+            s3270 = Popen(vgwrap(["s3270", "-httpd", f"127.0.0.1:{sport}",
+                f"127.0.0.1:{pport}"]))
+            self.children.append(s3270)
+            self.check_listen(sport)
+            sts.close()
+
+            # Get to the login screen.
+            p.send_records(4)
+
+            # Block one Wait() on the cursor and one on the screen contents.
+            results = {}
+            def wait(name, params):
+                results[name] = self.get(f'http://127.0.0.1:{sport}/3270/rest/json/Wait(2,{params})').ok
+            cursor = threading.Thread(target=wait, args=('cursor', 'CursorAt,20,16'))
+            string = threading.Thread(target=wait, args=('string', 'StringAt,21,13,"xx"'))
+            cursor.start()
+            string.start()
+            self.try_until(lambda: self.blocked_waits(sport) == 2, 2, "emulator did not block")
+
+            # Typing releases only the string wait.
+            self.get(f'http://127.0.0.1:{sport}/3270/rest/json/String(xxx)')
+            string.join(timeout=2)
+            self.assertTrue(results['string'])
+            self.assertEqual(1, self.blocked_waits(sport))
+
+            # Moving the cursor releases the cursor wait.
+            self.get(f'http://127.0.0.1:{sport}/3270/rest/json/Up()')
+            cursor.join(timeout=2)
+            self.assertTrue(results['cursor'])
+
+        self.get(f'http://127.0.0.1:{sport}/3270/rest/json/Quit()')
+        self.vgwait(s3270)
+
+    # A parked Wait() is woken by host output alone, with no action run.
+    def test_wait_woken_by_host(self):
+
+        # Start a server to throw NVT text at s3270.
+        s = copyserver()
+
+        # Start s3270 with a webserver and connect.
+        sport, sts = unused_port()
+        s3270 = Popen(vgwrap(["s3270", "-httpd", f"127.0.0.1:{sport}"]))
+        self.children.append(s3270)
+        self.check_listen(sport)
+        sts.close()
+        self.get(f'http://127.0.0.1:{sport}/3270/rest/json/Connect(a:c:t:127.0.0.1:{s.port})')
+
+        # Block one Wait() on the screen contents and one on the cursor.
+        results = {}
+        def wait(name, params):
+            results[name] = self.get(f'http://127.0.0.1:{sport}/3270/rest/json/Wait(2,{params})').ok
+        string = threading.Thread(target=wait, args=('string', 'StringAt,2,1,"hello"'))
+        cursor = threading.Thread(target=wait, args=('cursor', 'CursorAt,10,1'))
+        string.start()
+        cursor.start()
+        self.try_until(lambda: self.blocked_waits(sport) == 2, 2, "emulator did not block")
+
+        # Host output releases the string wait, but not the cursor wait.
+        s.send('\r\nhello')
+        string.join(timeout=1.5)
+        self.assertTrue(results['string'])
+        self.assertEqual(1, self.blocked_waits(sport))
+
+        # Host output moving the cursor releases the cursor wait.
+        s.send('\r\n' * 8)
+        cursor.join(timeout=1.5)
+        self.assertTrue(results['cursor'])
+
+        self.get(f'http://127.0.0.1:{sport}/3270/rest/json/Quit()')
+        self.vgwait(s3270)
+        s.data()
+
     # Simple negative test framework.
     def simple_negative_test(self, port, action, message):
         # Send the action to s3270.
@@ -126,11 +221,17 @@ class TestNewWait(cti):
         self.simple_negative_test(port, 'Wait(StringAt,1,2,3,4)', 'requires')
         self.simple_negative_test(port, 'Wait(InputFieldAt)', 'requires')
         self.simple_negative_test(port, 'Wait(InputFieldAt,1,2,3)', 'requires')
+        self.simple_negative_test(port, 'Wait(FieldCount)', 'requires')
+        self.simple_negative_test(port, 'Wait(FieldCount,fred)', 'Invalid')
+        self.simple_negative_test(port, 'Wait(CursorInField,-1)', 'Invalid')
+        self.simple_negative_test(port, 'Wait(Oia,fred)', 'must be')
 
         # Not-connected tests.
         self.simple_negative_test(port, 'Wait(CursorAt,0,0)', 'connected')
         self.simple_negative_test(port, 'Wait(StringAt,0,0,"Hello")', 'connected')
         self.simple_negative_test(port, 'Wait(InputFieldAt,0,0)', 'connected')
+        self.simple_negative_test(port, 'Wait(FieldCount,1)', 'connected')
+        self.simple_negative_test(port, 'Wait(Oia,Unlocked)', 'connected')
 
         # Clean up.
         self.get(f'http://127.0.0.1:{port}/3270/rest/json/Quit()')
@@ -28,6 +28,7 @@
 # s3270 NVT tests
 
 import re
+import tempfile
 import unittest
 from subprocess import Popen
 
@@ -257,5 +258,54 @@ class TestS3270Nvt(cti):
         self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Quit()')
         self.vgwait(s3270)
 
+    # Run a listing through s3270 and return the resulting screen.
+    def listing(self, data, trace):
+
+        # Start a server to throw NVT text at s3270.
+        s = sendserver(self)
+
+        # Start s3270. Tracing turns off the printable-run fast path.
+        hport, ts = unused_port()
+        args = ['s3270', '-httpd', str(hport)]
+        if trace:
+            tracefile = tempfile.NamedTemporaryFile(delete=False)
+            tracefile.close()
+            args += ['-trace', '-tracefile', tracefile.name]
+        s3270 = Popen(vgwrap(args + [f'a:c:t:127.0.0.1:{s.port}']))
+        self.children.append(s3270)
+        self.check_listen(hport)
+        ts.close()
+
+        # Send the data and wait for the end marker.
+        s.send(data + b'END')
+        r = self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Expect(END,2)')
+        self.assertTrue(r.ok)
+        buffer = self.get(f'http://127.0.0.1:{hport}/3270/rest/json/ReadBuffer(Ascii)').json()['result']
+        screen = self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Ascii1()').json()['result']
+        cursor = self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Query(Cursor1)').json()['result']
+
+        # Clean up.
+        s.close()
+        self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Quit()')
+        self.vgwait(s3270)
+        if trace:
+            os.unlink(tracefile.name)
+        return (buffer, screen, cursor)
+
+    # Printable text fast path test.
+    def test_printable_runs(self):
+        data = b'line one\r\n'
+        data += b'\033[1mbold\033[m plain \033[31mred\033[m\r\n'
+        data += b'x' * 200 + b'\r\n'
+        data += b'\033[?7l' + b'y' * 100 + b'\033[?7h\r\n'
+        data += b'abcdef\033[1;3H\033[4hINS\033[4l\033[3;78Hwrap-around\r\n'
+        data += b'caf\xc3\xa9 \033(0qqq\033(B done\r\n'
+        for i in range(60):
+            data += f'listing line {i}\r\n'.encode()
+        slow = self.listing(data, True)
+        fast = self.listing(data, False)
+        self.assertEqual(slow, fast)
+        self.assertEqual('listing line 59', fast[1][-2].strip())
+
 if __name__ == '__main__':
     unittest.main()
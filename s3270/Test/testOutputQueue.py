@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2026 Paul Mattes.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#     * Redistributions of source code must retain the above copyright
+#       notice, this list of conditions and the following disclaimer.
+#     * Redistributions in binary form must reproduce the above copyright
+#       notice, this list of conditions and the following disclaimer in the
+#       documentation and/or other materials provided with the distribution.
+#     * Neither the names of Paul Mattes nor the names of his contributors
+#       may be used to endorse or promote products derived from this software
+#       without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY PAUL MATTES "AS IS" AND ANY EXPRESS OR IMPLIED
+# WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+# MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+# EVENT SHALL PAUL MATTES BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+# OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+# WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+# OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+# ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+# s3270 host output queueing tests.
+
+import os
+import socket
+from subprocess import Popen, DEVNULL
+import sys
+import threading
+import unittest
+
+from Common.Test.cti import *
+
+@unittest.skipIf(sys.platform.startswith('win'), 'POSIX-only test')
+@requests_timeout
+class TestS3270OutputQueue(cti):
+
+    # Accept a connection, say hello, and then stop reading.
+    def stalled_host(self, listener: socket.socket, conns: list):
+        (conn, _) = listener.accept()
+        conn.sendall(b'hello\r\n')
+        conns.append(conn)
+
+    # s3270 output queueing test.
+    def test_s3270_output_queue(self):
+
+        # Start a host with a tiny receive window.
+        listener = socket.socket(socket.AF_INET, socket.SOCK_STREAM, 0)
+        listener.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 4096)
+        listener.bind(('127.0.0.1', 0))
+        listener.listen()
+        port = listener.getsockname()[1]
+        conns = []
+        host = threading.Thread(target=self.stalled_host, args=[listener, conns])
+        host.start()
+
+        # Start s3270 with a tiny send buffer.
+        hport, ts = unused_port()
+        env = os.environ.copy()
+        env['SNDBUF'] = '4096'
+        s3270 = Popen(vgwrap(['s3270', '-utenv', '-httpd', f':{hport}']),
+            stdin=DEVNULL, env=env)
+        self.children.append(s3270)
+        self.check_listen(hport)
+        ts.close()
+        self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Open(127.0.0.1:{port})')
+        host.join()
+
+        # Type until the host falls behind. The emulator must keep answering
+        # and stay connected, with the excess queued.
+        line = 'x' * 4000
+        sent = 0
+        queued = False
+        for i in range(100):
+            r = self.post(f'http://127.0.0.1:{hport}/3270/rest/post', json=f'String("{line}\\n")')
+            self.assertTrue(r.ok, 'String failed')
+            sent += len(line) + 2
+            tx = self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Query(StatsTx)').json()['result'][0]
+            if 'queued' in tx:
+                queued = True
+                break
+        self.assertTrue(queued, 'Output never queued')
+        r = self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Query(ConnectionState)').json()
+        self.assertNotEqual('', r['result'][0])
+
+        # Let the host catch up. Everything typed must arrive, in order.
+        conn = conns[0]
+        conn.settimeout(2)
+        data = b''
+        while len(data) < sent:
+            chunk = conn.recv(65536)
+            if chunk == b'':
+                break
+            data += chunk
+        self.assertEqual(((line + '\r\n') * (sent // (len(line) + 2))).encode(), data)
+        self.try_until(lambda: 'queued' not in self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Query(StatsTx)').json()['result'][0],
+            2, 'Output queue did not drain')
+
+        conn.close()
+        listener.close()
+        self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Quit()')
+        self.vgwait(s3270)
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,115 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2026 Paul Mattes.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#     * Redistributions of source code must retain the above copyright
+#       notice, this list of conditions and the following disclaimer.
+#     * Redistributions in binary form must reproduce the above copyright
+#       notice, this list of conditions and the following disclaimer in the
+#       documentation and/or other materials provided with the distribution.
+#     * Neither the names of Paul Mattes nor the names of his contributors
+#       may be used to endorse or promote products derived from this software
+#       without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY PAUL MATTES "AS IS" AND ANY EXPRESS OR IMPLIED
+# WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+# MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+# EVENT SHALL PAUL MATTES BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+# OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+# WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+# OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+# ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+# s3270 staggered parallel connect tests.
+
+import os
+import socket
+from subprocess import Popen
+import sys
+import threading
+import time
+import unittest
+
+from Common.Test.cti import *
+from Common.Test.playback import playback
+
+@unittest.skipIf(sys.platform.startswith('win') or sys.platform == 'darwin', 'Needs 127.0.0.2 and SYN drops')
+@requests_timeout
+class TestS3270ParallelConnect(cti):
+
+    # Create a listener on 127.0.0.2:<port> whose accept queue is full, so
+    # new connections to it hang instead of completing or being refused.
+    def black_hole(self, port: int):
+        listener = socket.socket(socket.AF_INET, socket.SOCK_STREAM, 0)
+        listener.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        listener.bind(('127.0.0.2', port))
+        listener.listen(0)
+        fillers = []
+        for i in range(2):
+            s = socket.socket(socket.AF_INET, socket.SOCK_STREAM, 0)
+            s.setblocking(False)
+            s.connect_ex(('127.0.0.2', port))
+            fillers.append(s)
+        return [listener] + fillers
+
+    def async_accept(self, p: playback):
+        p.send_records(4)
+
+    # Connect to a host whose first address does not answer.
+    def parallel_connect(self, delay: int):
+        pport, ts = unused_port()
+        with playback(self, 's3270/Test/ibmlink.trc', pport) as p:
+            ts.close()
+            hole = self.black_hole(pport)
+
+            hport, ts = unused_port()
+            ts.close()
+
+            # Start s3270.
+            env = os.environ.copy()
+            env['MOCK_ASYNC_RESOLVER'] = 'succeed-async=127.0.0.2,127.0.0.1'
+            s3270 = Popen(vgwrap(['s3270', '-httpd', str(hport), '-utenv',
+                '-connecttimeout', '3',
+                '-xrm', f's3270.connectAttemptDelay: {delay}']), env=env)
+            self.children.append(s3270)
+            self.check_listen(hport)
+
+            # Connect.
+            if delay > 0:
+                at = threading.Thread(target=self.async_accept, args=[p])
+                at.start()
+            start = time.time()
+            r = self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Connect(host:{pport})')
+            elapsed = time.time() - start
+            if delay > 0:
+                # The second address should win well before the timeout.
+                self.assertTrue(r.ok, 'Connect failed')
+                self.assertLess(elapsed, 2.0)
+                at.join()
+            else:
+                # Without staggering, the dead address uses up the whole timeout.
+                self.assertFalse(r.ok, 'Connect should fail')
+                self.assertGreaterEqual(elapsed, 2.5)
+
+            for s in hole:
+                s.close()
+
+        # Wait for the process to exit.
+        self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Quit()')
+        self.vgwait(s3270)
+
+    # s3270 staggered parallel connect test.
+    def test_s3270_parallel_connect(self):
+        self.parallel_connect(100)
+
+    # s3270 sequential connect test.
+    def test_s3270_sequential_connect(self):
+        self.parallel_connect(0)
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2026 Paul Mattes.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#     * Redistributions of source code must retain the above copyright
+#       notice, this list of conditions and the following disclaimer.
+#     * Redistributions in binary form must reproduce the above copyright
+#       notice, this list of conditions and the following disclaimer in the
+#       documentation and/or other materials provided with the distribution.
+#     * Neither the names of Paul Mattes nor the names of his contributors
+#       may be used to endorse or promote products derived from this software
+#       without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY PAUL MATTES "AS IS" AND ANY EXPRESS OR IMPLIED
+# WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+# MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+# EVENT SHALL PAUL MATTES BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+# OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+# WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+# OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+# ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+# s3270 profiling tests
+
+from subprocess import Popen, PIPE
+import unittest
+
+from Common.Test.cti import *
+
+class TestS3270Profile(cti):
+
+    # Run s3270 with some actions, returning the data lines.
+    def s3270_profile(self, args: list[str], actions: str):
+
+        # Start s3270.
+        s3270 = Popen(vgwrap(['s3270'] + args), stdin=PIPE, stdout=PIPE,
+                stderr=PIPE)
+        self.children.append(s3270)
+
+        # Feed s3270 the actions.
+        got = s3270.communicate(input=actions.encode('utf8'), timeout=2)
+
+        # Wait for the processes to exit.
+        self.vgwait(s3270)
+
+        self.assertEqual(b'', got[1])
+        return [line.decode('utf8')[6:] for line in got[0].splitlines() if line.startswith(b'data: ')]
+
+    # Profiling off by default.
+    def test_s3270_profile_default(self):
+        data = self.s3270_profile([], 'Query(Profile)\n')
+        self.assertEqual(['profiling disabled'], data)
+
+    # Profiling enabled from the command line.
+    def test_s3270_profile_enabled(self):
+        data = self.s3270_profile(['-set', 'profile'],
+            'Query(Profile)\n')
+        self.assertEqual('profiling enabled', data[0])
+        cats = {}
+        for line in data[1:]:
+            words = line.split()
+            self.assertEqual(7, len(words), line)
+            self.assertEqual(['allocations', 'bytes', 'cpu-ms'], words[1::2])
+            cats[words[0]] = [int(w) for w in words[2::2]]
+        self.assertEqual(['other', 'ctlr', 'screen', 'tasks', 'io', 'json', 'ui', 'trace'], list(cats.keys()))
+
+        # Running actions allocates memory.
+        self.assertGreater(cats['tasks'][0], 0)
+        self.assertGreater(cats['tasks'][1], 0)
+
+    # Profiling toggled at run time.
+    def test_s3270_profile_toggle(self):
+        data = self.s3270_profile([], 'Set(profile,true)\nQuery(Profile)\nSet(profile,false)\nQuery(Profile)\n')
+        self.assertEqual('profiling enabled', data[0])
+        self.assertEqual('profiling disabled', data[-1])
+
+if __name__ == '__main__':
+    unittest.main()
@@ -121,7 +121,7 @@ class TestS3270Query(cti):
         # Query something ambiguous.
         r = self.get(f'http://127.0.0.1:{http_port}/3270/rest/json/Query(p)')
         result = r.json()['result']
-        self.assertEqual("Query(): Ambiguous parameter 'p': Prefixes, Proxies, Proxy", result[0])
+        self.assertEqual("Query(): Ambiguous parameter 'p': Prefixes, Profile, Proxies, Proxy", result[0])
 
         # Stop s3270.
         self.get(f'http://127.0.0.1:{http_port}/3270/rest/json/Quit(-force))')
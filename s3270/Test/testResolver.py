@@ -235,5 +235,70 @@ class TestS3270Resolver(cti):
         self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Quit()')
         self.vgwait(s3270)
 
+    # s3270 resolver cache test.
+    def test_s3270_resolver_cache(self):
+
+        # Get an unused port to use as a target.
+        tport, ts = unused_port()
+        ts.close()
+
+        hport, ts = unused_port()
+        ts.close()
+
+        # Start s3270.
+        s3270 = Popen(vgwrap(['s3270', '-httpd', str(hport)]))
+        self.children.append(s3270)
+        self.check_listen(hport)
+
+        # Connect twice. Both attempts fail, but the second one should find
+        # the name in the cache.
+        for i in range(2):
+            r = self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Open(localhost:{tport})')
+            self.assertFalse(r.ok)
+            r = self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Query(ResolverCache)')
+            result = r.json()['result']
+            self.assertEqual(f'hits {i} misses 1 ttl 60 negative-ttl 10', result[0])
+            self.assertEqual(2, len(result))
+            entry = result[1].split()
+            self.assertEqual([f'localhost/{tport}', 'any', 'addresses'], entry[0:3])
+            self.assertEqual(['hits', str(i)], entry[-2:])
+
+        # Flush the cache.
+        r = self.get(f'http://127.0.0.1:{hport}/3270/rest/json/FlushResolverCache()')
+        self.assertTrue(r.ok)
+        r = self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Query(ResolverCache)')
+        self.assertEqual(['hits 1 misses 1 ttl 60 negative-ttl 10'], r.json()['result'])
+
+        # Wait for the process to exit.
+        self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Quit()')
+        self.vgwait(s3270)
+
+    # s3270 resolver cache disable test.
+    def test_s3270_resolver_cache_disabled(self):
+
+        # Get an unused port to use as a target.
+        tport, ts = unused_port()
+        ts.close()
+
+        hport, ts = unused_port()
+        ts.close()
+
+        # Start s3270 with successful lookups not cached.
+        s3270 = Popen(vgwrap(['s3270', '-httpd', str(hport),
+            '-xrm', 's3270.resolverCacheTtl: 0']))
+        self.children.append(s3270)
+        self.check_listen(hport)
+
+        # Connect twice. Both lookups should miss and nothing should be saved.
+        for i in range(2):
+            r = self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Open(localhost:{tport})')
+            self.assertFalse(r.ok)
+            r = self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Query(ResolverCache)')
+            self.assertEqual([f'hits 0 misses {i+1} ttl 0 negative-ttl 10'], r.json()['result'])
+
+        # Wait for the process to exit.
+        self.get(f'http://127.0.0.1:{hport}/3270/rest/json/Quit()')
+        self.vgwait(s3270)
+
 if __name__ == '__main__':
     unittest.main()
@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2026 Paul Mattes.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#     * Redistributions of source code must retain the above copyright
+#       notice, this list of conditions and the following disclaimer.
+#     * Redistributions in binary form must reproduce the above copyright
+#       notice, this list of conditions and the following disclaimer in the
+#       documentation and/or other materials provided with the distribution.
+#     * Neither the names of Paul Mattes nor the names of his contributors
+#       may be used to endorse or promote products derived from this software
+#       without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY PAUL MATTES "AS IS" AND ANY EXPRESS OR IMPLIED
+# WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+# MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+# EVENT SHALL PAUL MATTES BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+# OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+# WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+# OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+# ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+# s3270 screen text mirror tests
+
+from subprocess import Popen, DEVNULL
+import unittest
+
+from Common.Test.cti import *
+from Common.Test.playback import playback
+
+@requests_timeout
+class TestS3270ScreenText(cti):
+
+    # s3270 screen text update test
+    def test_s3270_screen_text_update(self):
+
+        # Start 'playback' to read s3270's output.
+        port, ts = unused_port()
+        with playback(self, 's3270/Test/ibmlink.trc', port=port,) as p:
+            ts.close()
+
+            # Start s3270.
+            hport, ts = unused_port()
+            s3270 = Popen(vgwrap(['s3270', '-httpd', str(hport), f'127.0.0.1:{port}']), stdin=DEVNULL, stdout=DEVNULL)
+            self.children.append(s3270)
+            self.check_listen(hport)
+            ts.close()
+            url = f'http://127.0.0.1:{hport}/3270/rest/json/'
+
+            # Get the screen, twice.
+            p.send_records(4)
+            before = self.get(url + 'Ascii()').json()['result']
+            self.assertEqual(24, len(before))
+            self.assertEqual(before, self.get(url + 'Ascii()').json()['result'])
+            self.assertEqual(' ===>', self.get(url + 'Ascii(23,0,1,5)').json()['result'][0])
+
+            # Type something and make sure the change shows up, and only there.
+            row, col = [int(x) for x in self.get(url + 'Query(Cursor)').json()['result'][0].split()]
+            self.get(url + 'String(hello)')
+            after = self.get(url + 'Ascii()').json()['result']
+            self.assertEqual('hello', after[row][col:col+5])
+            self.assertEqual(before[:row] + before[row+1:], after[:row] + after[row+1:])
+            self.assertEqual('hello', self.get(url + f'Ascii({row},{col},5)').json()['result'][0])
+            self.assertEqual(after[row], self.get(url + f'Ascii({row},0,1,80)').json()['result'][0])
+
+            # Wait for it as a string (Wait coordinates are 1-origin).
+            r = self.get(url + f'Wait(1,StringAt,{row+1},{col+1},hello)')
+            self.assertTrue(r.ok)
+
+            self.get(url + 'Disconnect()')
+            self.get(url + 'Quit()')
+
+        # Wait for the processes to exit.
+        self.vgwait(s3270)
+
+    # s3270 screen search test
+    def test_s3270_screen_search(self):
+
+        # Start 'playback' to read s3270's output.
+        port, ts = unused_port()
+        with playback(self, 's3270/Test/ibmlink.trc', port=port,) as p:
+            ts.close()
+
+            # Start s3270.
+            hport, ts = unused_port()
+            s3270 = Popen(vgwrap(['s3270', '-httpd', str(hport), f'127.0.0.1:{port}']), stdin=DEVNULL, stdout=DEVNULL)
+            self.children.append(s3270)
+            self.check_listen(hport)
+            ts.close()
+            url = f'http://127.0.0.1:{hport}/3270/rest/json/'
+            p.send_records(4)
+
+            # Literal and regular expression searches.
+            r = self.get(url + 'Search(===>)').json()['result']
+            self.assertIn('23 1 4', r)
+            self.assertEqual(r, self.get(url + 'Search(Regex,==*>)').json()['result'])
+            self.assertEqual([], self.get(url + 'Search(xyzzy)').json()['result'])
+
+            # Region and field restrictions.
+            self.assertNotIn('23 1 4', self.get(url + 'Search(Region,0,0,23,80,===>)').json()['result'])
+            self.assertEqual(['23 1 4'], self.get(url + 'Search(Region,23,0,1,80,===>)').json()['result'])
+            self.assertIn('23 1 4', self.get(url + 'Search(Protected,===>)').json()['result'])
+            self.assertNotIn('23 1 4', self.get(url + 'Search(Unprotected,===>)').json()['result'])
+
+            # Errors.
+            self.assertFalse(self.get(url + 'Search(Regex,[)').ok)
+            self.assertFalse(self.get(url + 'Search(Region,0,0,99,80,x)').ok)
+            self.assertFalse(self.get(url + 'Search(Bogus,x)').ok)
+
+            # Wait for a search.
+            self.assertTrue(self.get(url + 'Wait(1,Search,===>)').ok)
+            self.assertFalse(self.get(url + 'Wait(0.1,Search,xyzzy)').ok)
+            r = self.get(url + 'Wait(Search,Region,0,0,99,80,x)')
+            self.assertFalse(r.ok)
+            self.assertEqual(['Wait(): Invalid region'], r.json()['result'])
+
+            self.get(url + 'Disconnect()')
+            self.get(url + 'Quit()')
+
+        # Wait for the processes to exit.
+        self.vgwait(s3270)
+
+if __name__ == '__main__':
+    unittest.main()
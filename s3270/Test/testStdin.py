@@ -29,6 +29,8 @@
 
 from subprocess import Popen, PIPE, DEVNULL
 import sys
+import threading
+import time
 import unittest
 
 from Common.Test.cti import *
@@ -111,31 +113,55 @@ class TestS3270Stdin(cti):
         s3270.stdout.close()
 
     # s3270 stdin output backup crash test
-    def test_s3270_stdin_backup_crash(self):
+    def test_s3270_stdin_backpressure(self):
 
         # Start s3270.
-        s3270 = Popen(vgwrap(['s3270']), stdin=PIPE, stdout=PIPE, stderr=PIPE)
+        port, ts = unused_port()
+        s3270 = Popen(vgwrap(['s3270', '-httpd', f'127.0.0.1:{port}', '-set', 'scriptedAlways']),
+            stdin=PIPE, stdout=PIPE, stderr=PIPE)
         self.children.append(s3270)
+        self.check_listen(port)
+        ts.close()
 
-        # Feed s3270 actions until the output backs up completely on stdout.
-        t0 = time.monotonic()
-        while True:
-            try:
-                s3270.stdin.write(b'Query(-all)\n')
-            except (BrokenPipeError, OSError):
-                break
-            self.assertLess(time.monotonic() - t0, 10, 's3270 did not crash')
+        # Feed s3270 actions from another thread without reading its output.
+        stop = threading.Event()
+        def feed():
+            while not stop.is_set():
+                try:
+                    s3270.stdin.write(b'Query(-all)\n')
+                    s3270.stdin.flush()
+                except (BrokenPipeError, OSError, ValueError):
+                    break
+        feeder = threading.Thread(target=feed)
+        feeder.start()
 
-        # Wait for the processes to exit.
-        try:
-            s3270.stdin.close()
-        except (BrokenPipeError, OSError):
-            pass
+        # Wait for stdout to back up.
+        def stdout_queue():
+            r = self.get(f'http://127.0.0.1:{port}/3270/rest/json/Query(OutputQueues)')
+            self.assertTrue(r.ok)
+            return [i for i in r.json()['result'] if i.startswith('s3270-stdout')][0]
+        t0 = time.monotonic()
+        while 'backed-up' not in stdout_queue():
+            self.assertLess(time.monotonic() - t0, 10, 'stdout did not back up')
+            time.sleep(0.1)
+
+        # Input should now be paused, so the queue should stop growing.
+        time.sleep(0.5)
+        queued = int(stdout_queue().split()[2])
+        time.sleep(0.5)
+        self.assertEqual(queued, int(stdout_queue().split()[2]))
+        self.assertLess(queued, 1024 * 1024)
+
+        # Drain stdout, which lets the feeder finish.
+        stop.set()
+        while feeder.is_alive():
+            s3270.stdout.read1(65536)
+        s3270.stdin.close()
+        s3270.stdout.read()
         s3270.stdout.close()
-        self.vgwait(s3270, assertOnFailure=False)
-        lines = s3270.stderr.readlines()
+        self.vgwait(s3270)
+        self.assertEqual(b'', s3270.stderr.read())
         s3270.stderr.close()
-        self.assertIn(b'Unread output exceeded', lines[0])
 
 if __name__ == '__main__':
     unittest.main()
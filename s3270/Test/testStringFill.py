@@ -0,0 +1,87 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2025 Paul Mattes.
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#     * Redistributions of source code must retain the above copyright
+#       notice, this list of conditions and the following disclaimer.
+#     * Redistributions in binary form must reproduce the above copyright
+#       notice, this list of conditions and the following disclaimer in the
+#       documentation and/or other materials provided with the distribution.
+#     * Neither the names of Paul Mattes nor the names of his contributors
+#       may be used to endorse or promote products derived from this software
+#       without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY PAUL MATTES "AS IS" AND ANY EXPRESS OR IMPLIED
+# WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+# MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+# EVENT SHALL PAUL MATTES BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+# OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+# WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+# OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+# ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+# s3270 String() field fill tests
+
+from subprocess import Popen, DEVNULL
+import unittest
+
+from Common.Test.cti import *
+from Common.Test.playback import playback
+
+@requests_timeout
+class TestS3270StringFill(cti):
+
+    # Read the screen buffer and cursor position.
+    def snap(self, sport: int):
+        r = self.get(f'http://127.0.0.1:{sport}/3270/rest/json/ReadBuffer(Ascii) Query(Cursor1)')
+        self.assertTrue(r.ok)
+        return r.json()['result']
+
+    # s3270 String() fill test.
+    # Verifies that a string typed all at once produces the same screen
+    # as the same characters typed one at a time.
+    def test_s3270_string_fill(self):
+
+        pport, socket = unused_port()
+        with playback(self, 's3270/Test/sruvm.trc', pport) as p:
+            socket.close()
+
+            # Start s3270.
+            sport, socket = unused_port()
+            s3270 = Popen(vgwrap(['s3270', '-httpd', str(sport),
+                    f'127.0.0.1:{pport}']), stdin=DEVNULL, stdout=DEVNULL)
+            self.children.append(s3270)
+            self.check_listen(sport)
+            socket.close()
+
+            # Fill in the screen.
+            p.send_records(2)
+
+            # Type a string that overflows the first field, starting a few
+            # columns in so blank fill applies.
+            text = 'abcdefghijklmnopqrstuvwxyz'
+            self.get(f'http://127.0.0.1:{sport}/3270/rest/json/EraseInput() Home() Right() Right() Right()')
+            r = self.get(f'http://127.0.0.1:{sport}/3270/rest/json/String("{text}")')
+            self.assertTrue(r.ok)
+            bulk = self.snap(sport)
+
+            # Do it again, one character at a time.
+            self.get(f'http://127.0.0.1:{sport}/3270/rest/json/EraseInput() Home() Right() Right() Right()')
+            for c in text:
+                r = self.get(f'http://127.0.0.1:{sport}/3270/rest/json/String("{c}")')
+                self.assertTrue(r.ok)
+            single = self.snap(sport)
+
+            self.assertEqual(single, bulk)
+
+        # Wait for the processes to exit.
+        self.get(f'http://127.0.0.1:{sport}/3270/rest/json/Quit()')
+        self.vgwait(s3270)
+
+if __name__ == '__main__':
+    unittest.main()
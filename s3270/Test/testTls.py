@@ -28,8 +28,11 @@
 # s3270 TLS tests
 
 import os
+import socket
+import ssl
 from subprocess import Popen, PIPE, DEVNULL
 import sys
+import tempfile
 import threading
 import unittest
 
@@ -460,5 +463,152 @@ class TestS3270Tls(cti):
         # Wait for the process to exit.
         self.vgwait(s3270)
 
+    # Accept TLS connections with one server context, sending a line of NVT
+    # text and holding each one open until the client closes it.
+    def resume_server(self, listener: socket.socket, context: ssl.SSLContext, count: int):
+        for i in range(count):
+            (conn, _) = listener.accept()
+            tconn = context.wrap_socket(conn, server_side=True)
+            tconn.sendall(b'hello\r\n')
+            try:
+                while tconn.recv(1024) != b'':
+                    pass
+            except OSError:
+                pass
+            tconn.close()
+
+    # Check for a secure connection.
+    def is_secure(self, http_port: int) -> bool:
+        result = self.get(f'http://127.0.0.1:{http_port}/3270/rest/json/Query(Tls)').json()['result']
+        return len(result) > 0 and result[0].startswith('secure')
+
+    # Connect and wait for the TLS handshake to finish.
+    def resume_connect(self, http_port: int, port: int):
+        self.get(f'http://127.0.0.1:{http_port}/3270/rest/json/Open(l:y:127.0.0.1:{port})')
+        self.try_until(lambda: self.is_secure(http_port), 2, 'TLS handshake did not finish')
+
+    # s3270 TLS session resumption test
+    @unittest.skipUnless(sys.platform == 'linux', 'Linux-only test')
+    def test_s3270_tls_session_resumption(self):
+
+        # Start a server that can resume sessions.
+        context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+        context.load_cert_chain('Common/Test/tls/TEST.crt', 'Common/Test/tls/TEST.key')
+        port, listener = unused_port()
+        listener.listen()
+        server = threading.Thread(target=self.resume_server, args=[listener, context, 5])
+        server.start()
+        cache_file = tempfile.NamedTemporaryFile(delete=False)
+        cache_file.close()
+        os.unlink(cache_file.name)
+
+        # Connect twice from one emulator. The second handshake resumes the first session.
+        http_port, http_ts = unused_port()
+        s3270 = Popen(vgwrap(['s3270', '-httpd', f':{http_port}', '-tlssessioncachefile', cache_file.name]),
+            stdin=DEVNULL, stdout=DEVNULL)
+        self.children.append(s3270)
+        self.check_listen(http_port)
+        http_ts.close()
+        self.resume_connect(http_port, port)
+        r = self.get(f'http://127.0.0.1:{http_port}/3270/rest/json/Query(TlsHandshakes)').json()
+        self.assertEqual('handshakes 1 resumed 0', r['result'][0])
+        self.get(f'http://127.0.0.1:{http_port}/3270/rest/json/Disconnect()')
+        self.resume_connect(http_port, port)
+        r = self.get(f'http://127.0.0.1:{http_port}/3270/rest/json/Query(TlsHandshakes)').json()
+        self.assertEqual('handshakes 2 resumed 1', r['result'][0])
+        r = self.get(f'http://127.0.0.1:{http_port}/3270/rest/json/Query(TlsSessionInfo)').json()
+        self.assertIn('Session resumed: yes', r['result'])
+        self.get(f'http://127.0.0.1:{http_port}/3270/rest/json/Quit(-force)')
+        self.vgwait(s3270)
+
+        # The cache file holds session secrets, so only its owner can read it.
+        self.assertEqual(0, os.stat(cache_file.name).st_mode & 0o077)
+
+        # A second emulator sharing the cache file resumes the session too.
+        http_port, http_ts = unused_port()
+        s3270 = Popen(vgwrap(['s3270', '-httpd', f':{http_port}', '-tlssessioncachefile', cache_file.name]),
+            stdin=DEVNULL, stdout=DEVNULL)
+        self.children.append(s3270)
+        self.check_listen(http_port)
+        http_ts.close()
+        self.resume_connect(http_port, port)
+        r = self.get(f'http://127.0.0.1:{http_port}/3270/rest/json/Query(TlsHandshakes)').json()
+        self.assertEqual('handshakes 1 resumed 1', r['result'][0])
+        self.get(f'http://127.0.0.1:{http_port}/3270/rest/json/Quit(-force)')
+        self.vgwait(s3270)
+
+        # An emulator with a different TLS configuration does not resume a
+        # session made under another one, even with the same cache file.
+        for (args, resumed) in [(['-accepthostname', 'any'], 0), ([], 1)]:
+            http_port, http_ts = unused_port()
+            s3270 = Popen(vgwrap(['s3270', '-httpd', f':{http_port}', '-tlssessioncachefile', cache_file.name] + args),
+                stdin=DEVNULL, stdout=DEVNULL)
+            self.children.append(s3270)
+            self.check_listen(http_port)
+            http_ts.close()
+            self.resume_connect(http_port, port)
+            r = self.get(f'http://127.0.0.1:{http_port}/3270/rest/json/Query(TlsHandshakes)').json()
+            self.assertEqual(f'handshakes 1 resumed {resumed}', r['result'][0])
+            self.get(f'http://127.0.0.1:{http_port}/3270/rest/json/Quit(-force)')
+            self.vgwait(s3270)
+
+        # Both sessions are in the file.
+        with open(cache_file.name) as f:
+            self.assertEqual(2, len(f.readlines()))
+
+        server.join()
+        listener.close()
+        os.unlink(cache_file.name)
+        os.unlink(cache_file.name + '.lock')
+
+    # Accept one TLS connection and return what the client sends.
+    def offload_server(self, listener: socket.socket, context: ssl.SSLContext, result: list):
+        (conn, _) = listener.accept()
+        tconn = context.wrap_socket(conn, server_side=True)
+        tconn.sendall(b'hello\r\n')
+        data = b''
+        try:
+            while not data.endswith(b'\n'):
+                chunk = tconn.recv(1024)
+                if chunk == b'':
+                    break
+                data += chunk
+        except OSError:
+            pass
+        result.append(data)
+        tconn.close()
+
+    # s3270 TLS kernel offload test
+    @unittest.skipUnless(sys.platform == 'linux', 'Linux-only test')
+    def test_s3270_tls_kernel_offload(self):
+
+        # Start a server.
+        context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+        context.load_cert_chain('Common/Test/tls/TEST.crt', 'Common/Test/tls/TEST.key')
+        port, listener = unused_port()
+        listener.listen()
+        result = []
+        server = threading.Thread(target=self.offload_server, args=[listener, context, result])
+        server.start()
+
+        # Connect with kernel offload requested. Whether the kernel can take
+        # over depends on the host, but either way data must flow in both
+        # directions and the session info must say which path is active.
+        http_port, http_ts = unused_port()
+        s3270 = Popen(vgwrap(['s3270', '-httpd', f':{http_port}', '-tlskerneloffload']),
+            stdin=DEVNULL, stdout=DEVNULL)
+        self.children.append(s3270)
+        self.check_listen(http_port)
+        http_ts.close()
+        self.resume_connect(http_port, port)
+        r = self.get(f'http://127.0.0.1:{http_port}/3270/rest/json/Query(TlsSessionInfo)').json()
+        self.assertTrue(any(line.startswith('Record encryption: ') for line in r['result']))
+        self.get(f'http://127.0.0.1:{http_port}/3270/rest/json/String("world\\n")')
+        server.join(timeout=2)
+        self.assertEqual([b'world\r\n'], result)
+        self.get(f'http://127.0.0.1:{http_port}/3270/rest/json/Quit(-force)')
+        self.vgwait(s3270)
+        listener.close()
+
 if __name__ == '__main__':
     unittest.main()
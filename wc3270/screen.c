@@ -2481,7 +2481,7 @@ decode_state(int state, bool limited, const char *skip)
     char *space = "";
     varbuf_t r;
 
-    vb_init(&r);
+    vb_init_tx(&r);
     if (skip == NULL) {
 	skip = "";
     }
@@ -2549,7 +2549,7 @@ decode_state(int state, bool limited, const char *skip)
 	vb_free(&r);
 	return "none";
     }
-    return txdFree(vb_consume(&r));
+    return vb_consume(&r);
 }
 
 /* Handle mouse events. */
@@ -2724,7 +2724,7 @@ decode_mflags(DWORD flags, decode_t names[])
     int i;
     bool any = false;
 
-    vb_init(&r);
+    vb_init_tx(&r);
     vb_appendf(&r, "0x%x", (unsigned)f);
     for (i = 0; names[i].name != NULL; i++) {
 	if (f & names[i].flag) {
@@ -2736,7 +2736,7 @@ decode_mflags(DWORD flags, decode_t names[])
     if (f != 0 && f != flags) {
 	vb_appendf(&r, "%s0x%x", any? "|": " ", f);
     }
-    return txdFree(vb_consume(&r));
+    return vb_consume(&r);
 }
 
 /* Return value from do_rr(). */
@@ -2922,7 +2922,7 @@ trace_as_keymap(unsigned long xk, KEY_EVENT_RECORD *e)
     const char *s;
     varbuf_t r;
 
-    vb_init(&r);
+    vb_init_tx(&r);
     vb_appendf(&r, "[xk 0x%lx] ", xk);
     s = decode_state(e->dwControlKeyState, true, NULL);
     if (strcmp(s, "none")) {
@@ -2958,7 +2958,7 @@ trace_as_keymap(unsigned long xk, KEY_EVENT_RECORD *e)
     } else {
 	vb_appendf(&r, "<Key>%c", (unsigned char)xk);
     }
-    vctrace(TC_UI, " %s ->", txdFree(vb_consume(&r)));
+    vctrace(TC_UI, " %s ->", vb_consume(&r));
 }
 
 /* Translate a Windows virtual key to a menubar abstract key. */
@@ -52,6 +52,8 @@ XtResource resources[] = {
       offset(unlock_delay_ms), XtRString, "350" },
     { ResScriptPort, ClsScriptPort, XtRString, sizeof(String),
       offset(script_port), XtRString, 0 },
+    { ResScriptPortPipeline, ClsScriptPortPipeline, XtRInt, sizeof(int),
+      offset(script_port_pipeline), XtRString, "16" },
     { ResHttpd, ClsHttpd, XtRString, sizeof(String),
       offset(httpd_port), XtRString, 0 },
     { ResLoginMacro, ClsLoginMacro, XtRString, sizeof(String),
@@ -114,8 +116,14 @@ XtResource resources[] = {
       offset(suppress_actions), XtRString, 0 },
     { ResCrosshairColor, ClsCrosshairColor, XtRString, sizeof(String),
       offset(interactive.crosshair_color), XtRString, "purple" },
+    { ResConnectAttemptDelay, ClsConnectAttemptDelay, XtRInt, sizeof(int),
+      offset(connect_attempt_delay), XtRString, "250" },
     { ResConnectTimeout, ClsConnectTimeout, XtRInt, sizeof(int),
       offset(connect_timeout), XtRString, "0" },
+    { ResResolverCacheNegTtl, ClsResolverCacheNegTtl, XtRInt, sizeof(int),
+      offset(resolver_cache_neg_ttl), XtRString, "10" },
+    { ResResolverCacheTtl, ClsResolverCacheTtl, XtRInt, sizeof(int),
+      offset(resolver_cache_ttl), XtRString, "60" },
     { ResConsole, ClsConsole, XtRString, sizeof(char *),
       offset(interactive.console), XtRString, 0 },
     { ResNoTelnetInputMode, ClsNoTelnetInputMode, XtRString, sizeof(char *),
@@ -176,6 +184,8 @@ XtResource resources[] = {
       offset(tls.min_protocol), XtRString, 0 },
     { ResTlsSecurityLevel, ClsTlsSecurityLevel, XtRString, sizeof(char *),
       offset(tls.security_level), XtRString, 0 },
+    { ResTlsSessionCacheFile, ClsTlsSessionCacheFile, XtRString, sizeof(char *),
+      offset(tls.session_cache_file), XtRString, 0 },
 
     { ResFtAllocation, ClsFtAllocation, XtRString, sizeof(char *),
       offset(ft.allocation), XtRString, 0 },
@@ -321,6 +331,8 @@ XtResource xresources[] = {
       boffset(prefer_ipv4), XtRString, ResFalse },
     { ResPreferIpv6, ClsPreferIpv6, XtRBoolean, sizeof(Boolean),
       boffset(prefer_ipv6), XtRString, ResFalse },
+    { ResProfile, ClsProfile, XtRBoolean, sizeof(Boolean),
+      boffset(profile), XtRString, ResFalse },
     { ResModifiedSel, ClsModifiedSel, XtRBoolean, sizeof(Boolean),
       boffset(modified_sel), XtRString, ResFalse },
     { ResUnlockDelay, ClsUnlockDelay, XtRBoolean, sizeof(Boolean),
@@ -434,6 +446,8 @@ XtResource xresources[] = {
       boffset(tls.starttls), XtRString, ResTrue },
     { ResVerifyHostCert, ClsVerifyHostCert, XtRBoolean, sizeof(Boolean),
       boffset(tls.verify_host_cert), XtRString, ResTrue },
+    { ResTlsKernelOffload, ClsTlsKernelOffload, XtRBoolean, sizeof(Boolean),
+      boffset(tls.kernel_offload), XtRString, ResFalse },
 };
 
 Cardinal num_xresources = XtNumber(xresources);
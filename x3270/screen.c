@@ -2226,7 +2226,7 @@ StepEfont_xaction(Widget w, XEvent *event, String *params, Cardinal *num_params)
 
 	if (efont_is_scalable) {
 	    split_name(full_efontname, res, sizeof(res));
-	    vb_init(&r);
+	    vb_init_tx(&r);
 	    for (i = 0; i < 15; i++) {
 		switch (i) {
 		case 7:
@@ -2242,7 +2242,7 @@ StepEfont_xaction(Widget w, XEvent *event, String *params, Cardinal *num_params)
 		}
 		dash = "-";
 	    }
-	    new_font_name = txdFree(vb_consume(&r));
+	    new_font_name = vb_consume(&r);
 	} else {
 	    /* Has variants. */
 	    new_font_name = find_variant(full_efontname, bigger);
@@ -7171,8 +7171,8 @@ check_scalable(const char *font_name)
 
     /* Construct the target names. */
     split_name(font_name, res, sizeof(res));
-    vb_init(&r1);
-    vb_init(&r2);
+    vb_init_tx(&r1);
+    vb_init_tx(&r2);
     for (i = 0; i < 15; i++) {
 	if (i == 7 || i == 8 || i == 12) {
 	    vb_appendf(&r1, "%s0", dash);
@@ -7188,8 +7188,8 @@ check_scalable(const char *font_name)
     }
 
     /* Search. */
-    name1 = txdFree(vb_consume(&r1));
-    name2 = txdFree(vb_consume(&r2));
+    name1 = vb_consume(&r1);
+    name2 = vb_consume(&r2);
     for (d = dfc; d != NULL; d = d->next) {
 	if (!strcasecmp(d->name, name1) ||
 	    !strcasecmp(d->name, name2)) {
@@ -64,6 +64,7 @@
 #include "kybd.h"
 #include "login_macro.h"
 #include "min_version.h"
+#include "metrics.h"
 #include "model.h"
 #include "nvt.h"
 #include "opts.h"
@@ -74,6 +75,7 @@
 #include "print_screen.h"
 #include "print_window.h"
 #include "product.h"
+#include "profile.h"
 #include "proxy_toggle.h"
 #include "query.h"
 #include "resolver.h"
@@ -82,6 +84,7 @@
 #include "rpq.h"
 #include "save_restore.h"
 #include "screen.h"
+#include "screen_text.h"
 #include "selectc.h"
 #include "sio.h"
 #include "sio_glue.h"
@@ -571,6 +574,9 @@ main(int argc, char *argv[])
     rpq_register();
     resolver_pipe_register();
     oq_register();
+    metrics_register();
+    profile_register();
+    screen_text_register();
 
     /* Save the original command line. */
     save_command_string(argc, argv);
@@ -782,6 +788,8 @@ main(int argc, char *argv[])
 
     /* Set up the resolver. */
     set_46(appres.prefer_ipv4, appres.prefer_ipv6);
+    set_resolver_cache_ttl(appres.resolver_cache_ttl,
+	    appres.resolver_cache_neg_ttl);
 
     /* Set up atoms. */
     a_3270 = XInternAtom(display, "3270", False);
@@ -1292,6 +1300,7 @@ copy_xres_to_res_bool(void)
     copy_bool(once);
     copy_bool(prefer_ipv4);
     copy_bool(prefer_ipv6);
+    copy_bool(profile);
     copy_bool(reconnect);
     copy_bool(retry);
     copy_bool(script_port_once);
@@ -1322,6 +1331,7 @@ copy_xres_to_res_bool(void)
 
     copy_bool(tls.starttls);
     copy_bool(tls.verify_host_cert);
+    copy_bool(tls.kernel_offload);
 }
 
 /* Child exit callbacks. */
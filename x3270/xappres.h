@@ -104,6 +104,7 @@ typedef struct {
 	Boolean once;
 	Boolean prefer_ipv4;
 	Boolean prefer_ipv6;
+	Boolean profile;
 	Boolean reconnect;
 	Boolean retry;
 	Boolean script_port_once;
@@ -134,6 +135,7 @@ typedef struct {
 	struct {
 	    Boolean starttls;
 	    Boolean verify_host_cert;
+	    Boolean kernel_offload;
 	} tls;
     } bools;
 } xappres_t, *xappresptr_t;